@@ -11,12 +11,15 @@
 static const size_t alloc_min_len = 8;
 static const size_t alloc_mid_inc = 16;
 static const size_t alloc_mid_len = 256;
-static const size_t alloc_max_len = 4096;
+
+// Sized for the largest lenses: the 16 stripes of a striped dist and the
+// bucket budget of an hdr lens.
+static const size_t alloc_max_len = 65536;
 
 // [  0,    8] -> 1
 // ]  8,  256] -> 16 = 256 / 16
-// ]256, 4096] -> 4  = { 512, 1024, 2048, 4096 }
-enum { alloc_classes = 1 + 16 + 4 };
+// ]256, 65536] -> 8 = { 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536 }
+enum { alloc_classes = 1 + 16 + 8 };
 
 
 
@@ -61,7 +64,7 @@ static size_t alloc_class(size_t *len)
         return class;
     }
 
-    // ]256, 2048] we go by powers of 2.
+    // ]256, 65536] we go by powers of 2.
     *len = ceil_pow2(*len);
     size_t bits = ctz(*len) - ctz(alloc_mid_len);
     size_t class = bits + (alloc_mid_len / alloc_mid_inc);
@@ -13,15 +13,294 @@
 #include <inttypes.h>
 
 
+// -----------------------------------------------------------------------------
+// json
+// -----------------------------------------------------------------------------
+
+// Topk items and counter vec labels are user-provided strings so they need to
+// be escaped before they can be used as JSON keys.
+static void buffer_put_json_string(struct buffer *buffer, const char *str)
+{
+    buffer_put(buffer, '"');
+
+    for (const char *it = str; *it; ++it) {
+        unsigned char c = *it;
+
+        if (c == '"' || c == '\\') {
+            buffer_put(buffer, '\\');
+            buffer_put(buffer, c);
+        }
+        else if (c < 0x20) buffer_printf(buffer, "\\u%04x", c);
+        else buffer_put(buffer, c);
+    }
+
+    buffer_put(buffer, '"');
+}
+
+static void write_counter(struct buffer *buffer, const char *key, const struct optics_poll *poll)
+{
+    switch (poll->type) {
+
+    case optics_counter:
+        buffer_printf(buffer, "\"%s\":%" PRIu64, key, poll->value.counter);
+        break;
+
+    case optics_gauge:
+        buffer_printf(buffer, "\"%s\":%g", key, poll->value.gauge);
+        break;
+
+    case optics_dist:
+        buffer_printf(buffer,
+                "\"%s\":{\"p50\":%g,\"p90\":%g,\"p99\":%g,\"max\":%g,\"count\":%zu",
+                key,
+                poll->value.dist.p50,
+                poll->value.dist.p90,
+                poll->value.dist.p99,
+                poll->value.dist.max,
+                poll->value.dist.n);
+
+        if (poll->value.dist.exemplar) {
+            buffer_printf(buffer, ",\"exemplar\":{\"tag\":%lu,\"value\":%g}",
+                    poll->value.dist.exemplar,
+                    poll->value.dist.exemplar_value);
+        }
+
+        buffer_put(buffer, '}');
+        break;
+
+    case optics_histo:
+    {
+        const struct optics_histo *histo = &poll->value.histo;
+
+        buffer_printf(buffer, "\"%s\":{\"below\":%zu,\"above\":%zu",
+                key, histo->above, histo->below);
+
+        for (size_t i = 0; i < histo->buckets_len - 1; ++i) {
+            buffer_printf(buffer, ",\"bucket_%lu-%lu\":%zu",
+                    histo->buckets[i], histo->buckets[i+1], histo->counts[i]);
+        }
+
+        bool exemplars = false;
+        for (size_t i = 0; i <= histo->buckets_len; ++i) {
+            if (!histo->exemplars[i]) continue;
+
+            buffer_printf(buffer, exemplars ? "," : ",\"exemplars\":{");
+            exemplars = true;
+
+            if (!i) buffer_printf(buffer, "\"below\"");
+            else if (i == histo->buckets_len) buffer_printf(buffer, "\"above\"");
+            else {
+                buffer_printf(buffer, "\"bucket_%lu-%lu\"",
+                        histo->buckets[i - 1], histo->buckets[i]);
+            }
+            buffer_printf(buffer, ":%lu", histo->exemplars[i]);
+        }
+        if (exemplars) buffer_put(buffer, '}');
+
+        buffer_put(buffer, '}');
+        break;
+    }
+
+    case optics_quantile:
+    {
+        const struct optics_quantile *quantile = &poll->value.quantile;
+
+        buffer_printf(buffer, "\"%s\":{\"value\":%g,\"count\":%zu}",
+                key,
+                quantile->sample,
+                quantile->count);
+        break;
+    }
+
+    case optics_hdr:
+    {
+        const struct optics_hdr *hdr = &poll->value.hdr;
+
+        size_t count = hdr->above;
+        for (size_t i = 0; i < hdr->buckets_len; ++i) count += hdr->counts[i];
+
+        buffer_printf(buffer,
+                "\"%s\":{\"p50\":%" PRIu64 ",\"p90\":%" PRIu64 ",\"p99\":%" PRIu64
+                ",\"p999\":%" PRIu64 ",\"max\":%" PRIu64 ",\"count\":%zu"
+                ",\"above\":%zu}",
+                key,
+                optics_hdr_percentile(hdr, 50),
+                optics_hdr_percentile(hdr, 90),
+                optics_hdr_percentile(hdr, 99),
+                optics_hdr_percentile(hdr, 99.9),
+                hdr->max,
+                count,
+                hdr->above);
+        break;
+    }
+
+    case optics_sketch:
+    {
+        const struct optics_sketch *sketch = &poll->value.sketch;
+
+        size_t count = 0;
+        for (size_t i = 0; i < optics_sketch_buckets_max; ++i) count += sketch->counts[i];
+
+        buffer_printf(buffer,
+                "\"%s\":{\"p50\":%g,\"p90\":%g,\"p99\":%g,\"p999\":%g,\"count\":%zu}",
+                key,
+                optics_sketch_percentile(sketch, 50),
+                optics_sketch_percentile(sketch, 90),
+                optics_sketch_percentile(sketch, 99),
+                optics_sketch_percentile(sketch, 99.9),
+                count);
+        break;
+    }
+
+    case optics_hll:
+        buffer_printf(buffer, "\"%s\":%g", key, optics_hll_estimate(&poll->value.hll));
+        break;
+
+    case optics_topk:
+    {
+        const struct optics_topk *topk = &poll->value.topk;
+        size_t len = topk->len < topk->k ? topk->len : topk->k;
+
+        buffer_printf(buffer, "\"%s\":{", key);
+        for (size_t i = 0; i < len; ++i) {
+            if (i) buffer_put(buffer, ',');
+            buffer_put_json_string(buffer, topk->items[i].item);
+            buffer_printf(buffer, ":%lu", topk->items[i].count);
+        }
+        buffer_put(buffer, '}');
+        break;
+    }
+
+    case optics_summary:
+    {
+        const struct optics_summary *summary = &poll->value.summary;
+
+        buffer_printf(buffer,
+                "\"%s\":{\"count\":%zu,\"mean\":%g,\"stddev\":%g,\"min\":%g,\"max\":%g}",
+                key,
+                summary->count,
+                optics_summary_mean(summary),
+                optics_summary_stddev(summary),
+                summary->min,
+                summary->max);
+        break;
+    }
+
+    case optics_counter_vec:
+    {
+        const struct optics_counter_vec *vec = &poll->value.counter_vec;
+
+        buffer_printf(buffer, "\"%s\":{", key);
+        for (size_t i = 0; i < vec->len; ++i) {
+            if (i) buffer_put(buffer, ',');
+            buffer_put_json_string(buffer, vec->labels[i]);
+            buffer_printf(buffer, ":%ld", vec->counts[i]);
+        }
+        buffer_put(buffer, '}');
+        break;
+    }
+
+    case optics_heatmap:
+    {
+        const struct optics_heatmap *heatmap = &poll->value.heatmap;
+
+        buffer_printf(buffer, "\"%s\":{\"x\":[", key);
+        for (size_t i = 0; i < heatmap->x_len; ++i)
+            buffer_printf(buffer, "%s%lu", i ? "," : "", heatmap->x_buckets[i]);
+
+        buffer_printf(buffer, "],\"y\":[");
+        for (size_t i = 0; i < heatmap->y_len; ++i)
+            buffer_printf(buffer, "%s%lu", i ? "," : "", heatmap->y_buckets[i]);
+
+        buffer_printf(buffer, "],\"counts\":[");
+        for (size_t x = 0; x <= heatmap->x_len; ++x) {
+            buffer_printf(buffer, "%s[", x ? "," : "");
+            for (size_t y = 0; y <= heatmap->y_len; ++y) {
+                buffer_printf(buffer, "%s%zu", y ? "," : "",
+                        heatmap->counts[x * (heatmap->y_len + 1) + y]);
+            }
+            buffer_put(buffer, ']');
+        }
+        buffer_printf(buffer, "]}");
+        break;
+    }
+
+    case optics_event:
+    {
+        const struct optics_event *event = &poll->value.event;
+
+        buffer_printf(buffer, "\"%s\":{\"dropped\":%zu,\"events\":[",
+                key, event->dropped);
+        for (size_t i = 0; i < event->len; ++i) {
+            buffer_printf(buffer, "%s[%lu,%g]", i ? "," : "",
+                    event->events[i].id, event->events[i].value);
+        }
+        buffer_printf(buffer, "]}");
+        break;
+    }
+
+    case optics_tsc:
+    {
+        const struct optics_tsc *tsc = &poll->value.tsc;
+
+        size_t count = tsc->cycles.above;
+        for (size_t i = 0; i < tsc->cycles.buckets_len; ++i) count += tsc->cycles.counts[i];
+
+        buffer_printf(buffer,
+                "\"%s\":{\"p50\":%g,\"p90\":%g,\"p99\":%g,\"p999\":%g,\"max\":%g,\"count\":%zu}",
+                key,
+                optics_tsc_percentile(tsc, 50),
+                optics_tsc_percentile(tsc, 90),
+                optics_tsc_percentile(tsc, 99),
+                optics_tsc_percentile(tsc, 99.9),
+                optics_tsc_max(tsc),
+                count);
+        break;
+    }
+
+    case optics_meter:
+    {
+        const struct optics_meter *meter = &poll->value.meter;
+
+        buffer_printf(buffer,
+                "\"%s\":{\"count\":%" PRId64 ",\"rate_1\":%g,\"rate_5\":%g,\"rate_15\":%g}",
+                key, meter->count, meter->rate_1, meter->rate_5, meter->rate_15);
+        break;
+    }
+
+    case optics_quantile_vec:
+    {
+        const struct optics_quantile_vec *vec = &poll->value.quantile_vec;
+
+        buffer_printf(buffer, "\"%s\":{\"quantiles\":[", key);
+        for (size_t i = 0; i < vec->len; ++i)
+            buffer_printf(buffer, "%s%g", i ? "," : "", vec->quantiles[i]);
+
+        buffer_printf(buffer, "],\"values\":[");
+        for (size_t i = 0; i < vec->len; ++i)
+            buffer_printf(buffer, "%s%g", i ? "," : "", vec->samples[i]);
+
+        buffer_printf(buffer, "],\"count\":%zu}", vec->count);
+        break;
+    }
+
+    default:
+        optics_fail("unknown lens type '%d'", poll->type);
+        break;
+    }
+}
+
+
 // -----------------------------------------------------------------------------
 // metrics
 // -----------------------------------------------------------------------------
 
+// Metrics are rendered when they're polled as the poll values can hold payloads
+// that don't outlive the poll.
 struct metric
 {
     char *key;
-    enum optics_lens_type type;
-    union optics_poll_value value;
+    struct buffer json;
 };
 
 struct metrics
@@ -37,8 +316,10 @@ static void metrics_free(struct metrics *metrics)
 {
     if (!metrics) return;
 
-    for (size_t i = 0; i < metrics->len; ++i)
+    for (size_t i = 0; i < metrics->len; ++i) {
         free(metrics->data[i].key);
+        buffer_reset(&metrics->data[i].json);
+    }
 
     free(metrics);
 }
@@ -63,11 +344,9 @@ static struct metrics *metrics_append(struct metrics *metrics, const struct opti
     optics_key_push(&key, poll->host);
     optics_key_push(&key, poll->key);
 
-    metrics->data[metrics->len] = (struct metric) {
-        .key = strndup(key.data, optics_name_max_len),
-        .type = poll->type,
-        .value = poll->value,
-    };
+    struct metric *metric = &metrics->data[metrics->len];
+    *metric = (struct metric) { .key = strndup(key.data, optics_name_max_len) };
+    write_counter(&metric->json, metric->key, poll);
     metrics->len++;
 
     return metrics;
@@ -118,63 +397,6 @@ static void swap_tables(struct rest *rest)
     rest->build = NULL;
 }
 
-static void write_counter(struct buffer *buffer, const struct metric *metric)
-{
-    switch (metric->type) {
-
-    case optics_counter:
-        buffer_printf(buffer, "\"%s\":%" PRIu64, metric->key, metric->value.counter);
-        break;
-
-    case optics_gauge:
-        buffer_printf(buffer, "\"%s\":%g", metric->key, metric->value.gauge);
-        break;
-
-    case optics_dist:
-        buffer_printf(buffer,
-                "\"%s\":{\"p50\":%g,\"p90\":%g,\"p99\":%g,\"max\":%g,\"count\":%zu}",
-                metric->key,
-                metric->value.dist.p50,
-                metric->value.dist.p90,
-                metric->value.dist.p99,
-                metric->value.dist.max,
-                metric->value.dist.n);
-        break;
-
-    case optics_histo:
-    {
-        const struct optics_histo *histo = &metric->value.histo;
-
-        buffer_printf(buffer, "\"%s\":{\"below\":%zu,\"above\":%zu",
-                metric->key, histo->above, histo->below);
-
-        for (size_t i = 0; i < histo->buckets_len - 1; ++i) {
-            buffer_printf(buffer, ",\"bucket_%lu-%lu\":%zu",
-                    histo->buckets[i], histo->buckets[i+1], histo->counts[i]);
-        }
-
-        buffer_put(buffer, '}');
-        break;
-    }
-
-    case optics_quantile:
-    {
-        const struct optics_quantile *quantile = &metric->value.quantile;
-
-        buffer_printf(buffer, "\"%s\":{\"value\":%g,\"count\":%zu}",
-                metric->key,
-                quantile->sample,
-                quantile->count);
-        break;
-    }
-
-    default:
-        optics_fail("unknown lens type '%d'", metric->type);
-        break;
-    }
-}
-
-
 // -----------------------------------------------------------------------------
 // callbacks
 // -----------------------------------------------------------------------------
@@ -194,8 +416,10 @@ rest_get(void *ctx, struct crest_req *req, struct crest_resp *resp)
 
         if (rest->current) {
             for (size_t i = 0; i < rest->current->len; ++i) {
+                const struct buffer *json = &rest->current->data[i].json;
+
                 if (i > 0) buffer_put(&buffer, ',');
-                write_counter(&buffer, &rest->current->data[i]);
+                buffer_write(&buffer, json->data, json->len);
             }
         }
 
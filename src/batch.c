@@ -0,0 +1,247 @@
+/* batch.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+
+   Thread-local buffers which accumulate records without any atomic operations
+   and commit them to their lens in one shot whenever the epoch changes or when
+   explicitly flushed.
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+struct optics_batch
+{
+    struct optics_lens *lens;
+    enum optics_lens_type type;
+
+    // Raw epoch counter and not just the active epoch so that we can detect
+    // when we missed more than one epoch change.
+    size_t epoch;
+    bool dirty;
+
+    union
+    {
+        int64_t counter;
+
+        struct
+        {
+            size_t buckets_len;
+            uint64_t buckets[optics_histo_buckets_max + 1];
+
+            // [below, counts..., above]; see lens_histo_index.
+            size_t counts[optics_histo_buckets_max + 2];
+        } histo;
+
+        struct
+        {
+            size_t n;
+            double max;
+
+            // Same size as the lens' reservoir so that they can be merged.
+            size_t reservoir_len;
+            double samples[optics_dist_samples_max];
+        } dist;
+    } value;
+};
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+static size_t batch_epoch(struct optics_batch *batch)
+{
+    struct optics *optics = batch->lens->optics;
+    return atomic_load_explicit(&optics->header->epoch, memory_order_acquire);
+}
+
+static bool batch_type(struct optics_batch *batch, enum optics_lens_type type)
+{
+    if (optics_likely(batch->type == type)) return true;
+
+    optics_fail("invalid batch type: %d != %d", batch->type, type);
+    return false;
+}
+
+// Values are committed to the epoch they were recorded in. If we're still
+// within the poller's grace period then they'll be part of the right poll
+// otherwise they'll be picked up as a straggler on the next poll.
+static bool batch_commit(struct optics_batch *batch)
+{
+    if (!batch->dirty) return true;
+
+    optics_epoch_t epoch = batch->epoch & 1;
+
+    switch (batch->type) {
+
+    case optics_counter:
+        if (!lens_counter_inc(batch->lens, epoch, batch->value.counter)) return false;
+        batch->value.counter = 0;
+        break;
+
+    case optics_histo:
+        if (!lens_histo_commit(batch->lens, epoch, batch->value.histo.counts)) return false;
+        memset(batch->value.histo.counts, 0, sizeof(batch->value.histo.counts));
+        break;
+
+    case optics_dist:
+        if (!lens_dist_commit(batch->lens, epoch,
+                        batch->value.dist.samples, batch->value.dist.n,
+                        batch->value.dist.max))
+            return false;
+        batch->value.dist.n = 0;
+        batch->value.dist.max = 0;
+        break;
+
+    case optics_gauge:
+    case optics_quantile:
+    case optics_hdr:
+    case optics_sketch:
+    case optics_hll:
+    case optics_topk:
+    case optics_summary:
+    case optics_counter_vec:
+    case optics_heatmap:
+    case optics_event:
+    case optics_tsc:
+    case optics_meter:
+    case optics_quantile_vec:
+    default:
+        optics_fail("unsupported batch type '%d'", batch->type);
+        return false;
+    }
+
+    batch->dirty = false;
+    return true;
+}
+
+static bool batch_refresh(struct optics_batch *batch)
+{
+    size_t epoch = batch_epoch(batch);
+    if (optics_likely(epoch == batch->epoch)) return true;
+
+    if (!batch_commit(batch)) return false;
+    batch->epoch = epoch;
+    return true;
+}
+
+
+// -----------------------------------------------------------------------------
+// alloc
+// -----------------------------------------------------------------------------
+
+struct optics_batch * optics_batch_alloc(struct optics_lens *lens)
+{
+    struct optics_batch *batch = calloc(1, sizeof(*batch));
+    optics_assert_alloc(batch);
+
+    batch->lens = lens;
+    batch->type = optics_lens_type(lens);
+    batch->epoch = batch_epoch(batch);
+
+    switch (batch->type) {
+
+    case optics_counter:
+        break;
+
+    case optics_dist:
+        if (!lens_dist_reservoir(lens, &batch->value.dist.reservoir_len)) goto fail;
+        break;
+
+    case optics_histo:
+        if (!lens_histo_buckets(lens,
+                        batch->value.histo.buckets, &batch->value.histo.buckets_len))
+            goto fail;
+        break;
+
+    case optics_gauge:
+    case optics_quantile:
+    case optics_hdr:
+    case optics_sketch:
+    case optics_hll:
+    case optics_topk:
+    case optics_summary:
+    case optics_counter_vec:
+    case optics_heatmap:
+    case optics_event:
+    case optics_tsc:
+    case optics_meter:
+    case optics_quantile_vec:
+    default:
+        optics_fail("unsupported batch lens type '%d'", batch->type);
+        goto fail;
+    }
+
+    return batch;
+
+  fail:
+    free(batch);
+    return NULL;
+}
+
+void optics_batch_free(struct optics_batch *batch)
+{
+    if (!batch_commit(batch))
+        optics_warn("unable to flush batch: %s", optics_errno.msg);
+    free(batch);
+}
+
+bool optics_batch_flush(struct optics_batch *batch)
+{
+    if (!batch_commit(batch)) return false;
+    batch->epoch = batch_epoch(batch);
+    return true;
+}
+
+
+// -----------------------------------------------------------------------------
+// record
+// -----------------------------------------------------------------------------
+
+bool optics_batch_counter_inc(struct optics_batch *batch, int64_t value)
+{
+    if (!batch_type(batch, optics_counter)) return false;
+    if (!lens_sample(batch->lens->lens)) return true;
+    if (!batch_refresh(batch)) return false;
+
+    batch->value.counter += value;
+    batch->dirty = true;
+    return true;
+}
+
+bool optics_batch_histo_inc(struct optics_batch *batch, double value)
+{
+    if (!batch_type(batch, optics_histo)) return false;
+    if (!lens_sample(batch->lens->lens)) return true;
+    if (!batch_refresh(batch)) return false;
+
+    size_t index = lens_histo_index(
+            batch->value.histo.buckets, batch->value.histo.buckets_len, value);
+    batch->value.histo.counts[index]++;
+    batch->dirty = true;
+    return true;
+}
+
+bool optics_batch_dist_record(struct optics_batch *batch, double value)
+{
+    if (!batch_type(batch, optics_dist)) return false;
+    if (!lens_sample(batch->lens->lens)) return true;
+    if (!batch_refresh(batch)) return false;
+
+    size_t len = batch->value.dist.reservoir_len;
+
+    size_t i = batch->value.dist.n;
+    if (i >= len)
+        i = rng_gen_range(rng_global(), 0, batch->value.dist.n);
+    if (i < len)
+        batch->value.dist.samples[i] = value;
+
+    batch->value.dist.n++;
+    if (value > batch->value.dist.max) batch->value.dist.max = value;
+
+    batch->dirty = true;
+    return true;
+}
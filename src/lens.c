@@ -4,6 +4,19 @@
 */
 
 
+// -----------------------------------------------------------------------------
+// config
+// -----------------------------------------------------------------------------
+
+// Upper bound on the number of per-cpu stripes of a striped lens. Needs to be a
+// power of 2 so that we can map a cpu to a stripe with a simple mask.
+static const size_t lens_stripes_max = 32;
+
+// Number of times a read polls a lock held by a straggling writer before giving
+// up on the lens.
+static const size_t lens_read_spins = 1UL << 16;
+
+
 // -----------------------------------------------------------------------------
 // struct
 // -----------------------------------------------------------------------------
@@ -18,12 +31,20 @@ struct optics_packed lens
     atomic_off_t next;
     optics_off_t prev;
 
+    // Weight drawn from the sampling budget by each event of a sampled lens. See
+    // lens_sample for details.
+    double sampling_weight;
+
     // Struct is packed so keep the int at the bottom to avoid alignment issues
     // (not that x86 cares all that much... I blame my OCD).
     enum optics_lens_type type;
 
+    // Sampled lenses record one event out of sampling on average. Both 0 and 1
+    // mean that every event is recorded.
+    uint32_t sampling;
+
     // Allign to a cache line to avoid alignment issues in the lens itself.
-    uint8_t padding[20];
+    uint8_t padding[8];
 };
 
 static_assert(sizeof(struct lens) % 64 == 0,
@@ -100,12 +121,132 @@ static void * lens_sub_ptr(struct lens *lens, enum optics_lens_type type)
     return ((uint8_t *) lens) + sizeof(struct lens);
 }
 
+// Inverse of lens_sub_ptr for typed handles which only keep the sub pointer.
+static struct lens * lens_head_ptr(void *sub)
+{
+    return (struct lens *) (((uint8_t *) sub) - sizeof(struct lens));
+}
+
 static double lens_rescale(const struct optics_poll *poll, double value)
 {
     return value / poll->elapsed;
 }
 
 
+// -----------------------------------------------------------------------------
+// stripes
+// -----------------------------------------------------------------------------
+
+static size_t lens_stripes(void)
+{
+    size_t stripes = ceil_pow2(cpus());
+    return stripes < lens_stripes_max ? stripes : lens_stripes_max;
+}
+
+// Stripes are not strictly per-cpu since we can get preempted after reading
+// the cpu id and multiple cpus can share the same stripe if we have more cpus
+// then stripes. Writes to a stripe must therefore still be atomic but they
+// should mostly stay local to a single cache line.
+static size_t lens_stripe(size_t stripes)
+{
+    return cpu_current() & (stripes - 1);
+}
+
+
+// -----------------------------------------------------------------------------
+// locks
+// -----------------------------------------------------------------------------
+
+// Reads are done on the inactive epoch so a lock can only be held by a writer
+// that straggled across the epoch change and is about to release it. Spinning
+// is bounded so that a writer that died while holding the lock can't wedge the
+// poller.
+static bool lens_read_lock(struct slock *lock)
+{
+    for (size_t i = 0; i < lens_read_spins; ++i) {
+        if (!slock_is_locked(lock) && slock_try_lock(lock)) return true;
+    }
+    return false;
+}
+
+
+// -----------------------------------------------------------------------------
+// sampling
+// -----------------------------------------------------------------------------
+
+// Upper bound on the number of values that lens_sample_n filters at once.
+enum { lens_sample_chunk = 64 };
+
+// Each thread keeps a single budget drawn from an exponential distribution which
+// every event of a sampled lens draws down by the weight of its lens. An event
+// is kept if it runs out the budget which happens with a probability of
+// 1 - exp(-weight) = 1/sampling. Since the exponential distribution is
+// memoryless, this holds independently of how the events of lenses with
+// different rates are interleaved on the thread. Negative budgets are redrawn
+// on the next event which makes the common case a single subtraction.
+static __thread double lens_sample_budget = -1;
+
+static bool lens_sample(struct lens *lens)
+{
+    if (optics_likely(lens->sampling <= 1)) return true;
+
+    if (optics_unlikely(lens_sample_budget < 0)) {
+        // ]0, 1] so that we can safely take the log.
+        uint64_t rng = rng_gen(rng_global());
+        lens_sample_budget = -log(((rng >> 11) + 1) * (1.0 / (1UL << 53)));
+    }
+
+    lens_sample_budget -= lens->sampling_weight;
+    return lens_sample_budget < 0;
+}
+
+static bool lens_sampled(struct lens *lens)
+{
+    return lens->sampling > 1;
+}
+
+// Copies the values kept by the sampling of the lens out of the first
+// lens_sample_chunk values and returns the number of values copied.
+static size_t lens_sample_n(struct lens *lens, const double *values, size_t n, double *dst)
+{
+    if (n > lens_sample_chunk) n = lens_sample_chunk;
+
+    size_t len = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (lens_sample(lens)) dst[len++] = values[i];
+    }
+    return len;
+}
+
+// The rate should be set before the lens is recorded into as the record path
+// reads both fields without synchronization.
+static bool lens_set_sampling(struct lens *lens, size_t sampling)
+{
+    bool supported =
+        lens->type == optics_counter ||
+        lens->type == optics_dist ||
+        lens->type == optics_histo;
+    if (!supported) {
+        optics_fail("unsupported sampling lens type '%d'", lens->type);
+        return false;
+    }
+
+    if (!sampling || sampling > UINT32_MAX) {
+        optics_fail("invalid sampling '%lu' not in [1, %u]", sampling, UINT32_MAX);
+        return false;
+    }
+
+    lens->sampling_weight = sampling > 1 ? -log1p(-1.0 / sampling) : 0;
+    lens->sampling = sampling;
+    return true;
+}
+
+static size_t lens_sampling(struct lens *lens)
+{
+    return lens->sampling > 1 ? lens->sampling : 1;
+}
+
+
 // -----------------------------------------------------------------------------
 // interface
 // -----------------------------------------------------------------------------
@@ -178,3 +319,14 @@ static void lens_kill(struct optics *optics, struct lens *lens)
 #include "lens_dist.c"
 #include "lens_histo.c"
 #include "lens_quantile.c"
+#include "lens_hdr.c"
+#include "lens_sketch.c"
+#include "lens_hll.c"
+#include "lens_topk.c"
+#include "lens_summary.c"
+#include "lens_counter_vec.c"
+#include "lens_heatmap.c"
+#include "lens_event.c"
+#include "lens_tsc.c"
+#include "lens_meter.c"
+#include "lens_quantile_vec.c"
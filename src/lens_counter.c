@@ -8,20 +8,65 @@
 // struct
 // -----------------------------------------------------------------------------
 
+struct optics_packed lens_counter_stripe
+{
+    atomic_int_fast64_t value[2];
+    uint8_t padding[48];
+};
+
+static_assert(sizeof(struct lens_counter_stripe) == 64,
+        "counter stripes should each be on their own cache line");
+
 struct optics_packed lens_counter
 {
     atomic_int_fast64_t value[2];
+    size_t stripes;
+
+    // Only allocated for striped counters. The padding keeps the stripes
+    // aligned on cache lines which is what the lens header is aligned on.
+    uint8_t padding[40];
+    struct lens_counter_stripe stripe[];
 };
 
+static_assert(sizeof(struct lens_counter) == 64,
+        "counter stripes should be aligned on a cache line");
+
 
 // -----------------------------------------------------------------------------
 // impl
 // -----------------------------------------------------------------------------
 
 static struct lens *
-lens_counter_alloc(struct optics *optics, const char *name)
+lens_counter_alloc(struct optics *optics, const char *name, size_t stripes)
 {
-    return lens_alloc(optics, optics_counter, sizeof(struct lens_counter), name);
+    size_t len = offsetof(struct lens_counter, padding);
+    if (stripes)
+        len = sizeof(struct lens_counter) + stripes * sizeof(struct lens_counter_stripe);
+
+    struct lens *lens = lens_alloc(optics, optics_counter, len, name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_counter *counter = lens_sub_ptr(lens, optics_counter);
+    if (!counter) goto fail_sub;
+
+    counter->stripes = stripes;
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+static void
+lens_counter_inc_typed(struct lens_counter *counter, optics_epoch_t epoch, int64_t value)
+{
+    atomic_int_fast64_t *dst = &counter->value[epoch];
+    if (counter->stripes)
+        dst = &counter->stripe[lens_stripe(counter->stripes)].value[epoch];
+
+    atomic_fetch_add_explicit(dst, value, memory_order_relaxed);
 }
 
 static bool
@@ -30,17 +75,52 @@ lens_counter_inc(struct optics_lens *lens, optics_epoch_t epoch, int64_t value)
     struct lens_counter *counter = lens_sub_ptr(lens->lens, optics_counter);
     if (!counter) return false;
 
-    atomic_fetch_add_explicit(&counter->value[epoch], value, memory_order_relaxed);
+    lens_counter_inc_typed(counter, epoch, value);
     return true;
 }
 
+static bool
+lens_counter_inc_n(
+        struct optics_lens *lens, optics_epoch_t epoch, const int64_t *values, size_t n)
+{
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += values[i];
+    return lens_counter_inc(lens, epoch, sum);
+}
+
+static atomic_int_fast64_t *
+lens_counter_inline(struct optics_lens *lens)
+{
+    struct lens_counter *counter = lens_sub_ptr(lens->lens, optics_counter);
+    if (!counter) return NULL;
+
+    if (counter->stripes) {
+        optics_fail("striped counter '%s' can't be recorded inline", lens_name(lens->lens));
+        return NULL;
+    }
+
+    if (lens_sampled(lens->lens)) {
+        optics_fail("sampled counter '%s' can't be recorded inline", lens_name(lens->lens));
+        return NULL;
+    }
+
+    return counter->value;
+}
+
 static enum optics_ret
 lens_counter_read(struct optics_lens *lens, optics_epoch_t epoch, int64_t *value)
 {
     struct lens_counter *counter = lens_sub_ptr(lens->lens, optics_counter);
     if (!counter) return optics_err;
 
-    *value += atomic_exchange_explicit(&counter->value[epoch], 0, memory_order_relaxed);
+    int64_t sum = atomic_exchange_explicit(&counter->value[epoch], 0, memory_order_relaxed);
+
+    for (size_t i = 0; i < counter->stripes; ++i) {
+        atomic_int_fast64_t *stripe = &counter->stripe[i].value[epoch];
+        sum += atomic_exchange_explicit(stripe, 0, memory_order_relaxed);
+    }
+
+    *value += sum * (int64_t) lens_sampling(lens->lens);
     return optics_ok;
 }
 
@@ -0,0 +1,150 @@
+/* lens_counter_vec.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+// The counters of an epoch are contiguous so that the reader can go through
+// them in a single pass. The labels are stored after the counters of both
+// epochs so that pollers in other processes can name the slots.
+struct optics_packed lens_counter_vec
+{
+    size_t len;
+    atomic_int_fast64_t counters[];
+};
+
+static char *lens_counter_vec_labels(struct lens_counter_vec *vec)
+{
+    return (char *) &vec->counters[2 * vec->len];
+}
+
+
+// -----------------------------------------------------------------------------
+// impl
+// -----------------------------------------------------------------------------
+
+static struct lens *
+lens_counter_vec_alloc(
+        struct optics *optics, const char *name, const char **labels, size_t len)
+{
+    if (!len || len > optics_counter_vec_slots_max) {
+        optics_fail("invalid counter vec length '%lu' not in [1, %d]",
+                len, optics_counter_vec_slots_max);
+        return NULL;
+    }
+
+    for (size_t i = 0; labels && i < len; ++i) {
+        if (strnlen(labels[i], optics_counter_vec_label_max_len) < optics_counter_vec_label_max_len)
+            continue;
+
+        optics_fail("counter vec label '%s' exceeds max length '%d'",
+                labels[i], optics_counter_vec_label_max_len - 1);
+        return NULL;
+    }
+
+    size_t lens_len = sizeof(struct lens_counter_vec);
+    lens_len += 2 * len * sizeof(atomic_int_fast64_t);
+    lens_len += len * optics_counter_vec_label_max_len;
+
+    struct lens *lens = lens_alloc(optics, optics_counter_vec, lens_len, name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_counter_vec *vec = lens_sub_ptr(lens, optics_counter_vec);
+    if (!vec) goto fail_sub;
+
+    vec->len = len;
+
+    // Unlabeled slots are named after their index.
+    char *dst = lens_counter_vec_labels(vec);
+    for (size_t i = 0; i < len; ++i, dst += optics_counter_vec_label_max_len) {
+        if (labels) strcpy(dst, labels[i]);
+        else snprintf(dst, optics_counter_vec_label_max_len, "%lu", i);
+    }
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+static bool lens_counter_vec_inc_typed(
+        struct lens_counter_vec *vec, optics_epoch_t epoch, size_t index, int64_t value)
+{
+    if (optics_unlikely(index >= vec->len)) {
+        optics_fail("out of bounds counter vec index '%lu' >= '%lu'", index, vec->len);
+        return false;
+    }
+
+    atomic_fetch_add_explicit(
+            &vec->counters[epoch * vec->len + index], value, memory_order_relaxed);
+    return true;
+}
+
+static bool lens_counter_vec_inc(
+        struct optics_lens *lens, optics_epoch_t epoch, size_t index, int64_t value)
+{
+    struct lens_counter_vec *vec = lens_sub_ptr(lens->lens, optics_counter_vec);
+    if (!vec) return false;
+
+    return lens_counter_vec_inc_typed(vec, epoch, index, value);
+}
+
+static enum optics_ret
+lens_counter_vec_read(
+        struct optics_lens *lens, optics_epoch_t epoch, struct optics_counter_vec *value)
+{
+    struct lens_counter_vec *vec = lens_sub_ptr(lens->lens, optics_counter_vec);
+    if (!vec) return optics_err;
+
+    if (!value->len) {
+        value->len = vec->len;
+        memcpy(value->labels, lens_counter_vec_labels(vec),
+                vec->len * optics_counter_vec_label_max_len);
+    }
+    else if (value->len != vec->len) {
+        optics_fail("mismatched counter vec length '%lu' != '%lu'", value->len, vec->len);
+        return optics_err;
+    }
+    else {
+        // Counts are merged by position so the labels must line up exactly.
+        const char *labels = lens_counter_vec_labels(vec);
+        for (size_t i = 0; i < vec->len; ++i, labels += optics_counter_vec_label_max_len) {
+            if (!strncmp(value->labels[i], labels, optics_counter_vec_label_max_len)) continue;
+
+            optics_fail("mismatched counter vec label '%lu': '%s' != '%s'",
+                    i, value->labels[i], labels);
+            return optics_err;
+        }
+    }
+
+    atomic_int_fast64_t *counters = &vec->counters[epoch * vec->len];
+    for (size_t i = 0; i < vec->len; ++i)
+        value->counts[i] += atomic_exchange_explicit(&counters[i], 0, memory_order_relaxed);
+
+    return optics_ok;
+}
+
+static bool
+lens_counter_vec_normalize(
+        const struct optics_poll *poll, optics_normalize_cb_t cb, void *ctx)
+{
+    const struct optics_counter_vec *vec = &poll->value.counter_vec;
+
+    struct optics_key key = {0};
+    optics_key_push(&key, poll->key);
+
+    for (size_t i = 0; i < vec->len; ++i) {
+        size_t old = optics_key_push_sanitized(&key, vec->labels[i]);
+        bool ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, vec->counts[i]));
+        optics_key_pop(&key, old);
+        if (!ret) return false;
+    }
+
+    return true;
+}
@@ -3,54 +3,422 @@
    FreeBSD-style copyright and disclaimer apply
 */
 
+// -----------------------------------------------------------------------------
+// config
+// -----------------------------------------------------------------------------
+
+// Each stripe holds two full reservoirs so we need to cap the stripes well
+// below the other striped lenses to stay within our allocator's limits. Only
+// dists with the default reservoir size can be striped for the same reason.
+static const size_t lens_dist_stripes_max = 16;
+
+
 // -----------------------------------------------------------------------------
 // struct
 // -----------------------------------------------------------------------------
 
+// The reservoir directly follows the epoch and is stored as doubles or, for
+// compact dists, as floats. See lens_dist_sample_set.
 struct optics_packed lens_dist_epoch
 {
     struct slock lock;
 
     size_t n;
     double max;
-    double samples[optics_dist_samples];
+
+    // Tag of the largest tagged record along with its value. A tag of 0 means
+    // that no tagged record was seen.
+    uint64_t exemplar;
+    double exemplar_value;
+
+    union
+    {
+        // Algorithm L state: index of the next record to be sampled once the
+        // reservoir is full and the largest key currently in the reservoir.
+        struct { size_t skip; double skip_w; };
+
+        // Forward decay state: landmark tsc and total weight of the records
+        // relative to that landmark.
+        struct { uint64_t landmark; double weight; };
+    };
+
+    uint8_t samples[];
 };
 
+static_assert(sizeof(struct lens_dist_epoch) % sizeof(double) == 0,
+        "dist samples should be aligned");
+
+// The epochs are laid out back to back in data with the two epochs of a stripe
+// next to each other and unstriped dists using a single stripe. Striped dists
+// round their epochs up to a cache line so that stripes don't share one.
 struct optics_packed lens_dist
 {
-    struct lens_dist_epoch epochs[2];
+    size_t reservoir_len;
+    size_t epoch_len;
+    size_t stripes;
+    bool compact;
+
+    // Forward decayed dists weight their records by exp(decay * tsc) where
+    // decay is derived from the half-life in seconds. Uniform dists have a
+    // half-life of 0.
+    double half_life;
+    double decay;
+
+    // Keeps the epochs aligned on cache lines which is what the lens header is
+    // aligned on.
+    uint8_t padding[23];
+    uint8_t data[];
 };
 
+static_assert(sizeof(struct lens_dist) == 64,
+        "dist epochs should be aligned on a cache line");
+
+static inline struct lens_dist_epoch *
+lens_dist_epoch(struct lens_dist *dist_head, size_t stripe, optics_epoch_t epoch)
+{
+    size_t index = stripe * 2 + epoch;
+    return (struct lens_dist_epoch *) (dist_head->data + index * dist_head->epoch_len);
+}
+
+
+// -----------------------------------------------------------------------------
+// samples
+// -----------------------------------------------------------------------------
+
+static inline void lens_dist_sample_set(
+        const struct lens_dist *dist_head, struct lens_dist_epoch *dist, size_t i, double value)
+{
+    if (dist_head->compact) ((float *) dist->samples)[i] = value;
+    else ((double *) dist->samples)[i] = value;
+}
+
+static void lens_dist_samples_load(
+        const struct lens_dist *dist_head, struct lens_dist_epoch *dist, double *dst, size_t len)
+{
+    if (!dist_head->compact) {
+        memcpy(dst, dist->samples, len * sizeof(*dst));
+        return;
+    }
+
+    const float *samples = (const float *) dist->samples;
+    for (size_t i = 0; i < len; ++i) dst[i] = samples[i];
+}
+
+static void lens_dist_samples_store(
+        const struct lens_dist *dist_head,
+        struct lens_dist_epoch *dist,
+        size_t offset,
+        const double *src, size_t len)
+{
+    if (!dist_head->compact) {
+        memcpy((double *) dist->samples + offset, src, len * sizeof(*src));
+        return;
+    }
+
+    float *samples = (float *) dist->samples + offset;
+    for (size_t i = 0; i < len; ++i) samples[i] = src[i];
+}
+
+
+// -----------------------------------------------------------------------------
+// skip
+// -----------------------------------------------------------------------------
+
+// Once the reservoir is full we use Algorithm L which directly computes how many
+// records to skip before the next one makes it into the reservoir instead of
+// rolling the dice on every record. The skip state only ever needs to be
+// touched when a record is sampled.
+
+static double lens_dist_rng_unit(struct rng *rng)
+{
+    // ]0, 1] so that we can safely take the log.
+    return ((rng_gen(rng) >> 11) + 1) * (1.0 / (1UL << 53));
+}
+
+static void lens_dist_skip_next(struct lens_dist_epoch *dist, struct rng *rng)
+{
+    double skip = floor(log(lens_dist_rng_unit(rng)) / log(1 - dist->skip_w));
+    dist->skip = dist->n + (skip < (double) (SIZE_MAX / 2) ? (size_t) skip : SIZE_MAX / 2);
+}
+
+static void lens_dist_skip_sampled(struct lens_dist_epoch *dist, size_t len, struct rng *rng)
+{
+    dist->skip_w *= exp(log(lens_dist_rng_unit(rng)) / len);
+}
+
+// Resets the skip state for a reservoir that is a uniform sample of dist->n
+// records. The largest key of the reservoir is the len-th smallest of n uniform
+// keys which we generate from its exponential spacings. This only happens when
+// a batch is committed so the cost of the logs is amortized over the batch.
+static void lens_dist_skip_reset(struct lens_dist_epoch *dist, size_t len, struct rng *rng)
+{
+    if (dist->n == len)
+        dist->skip_w = exp(log(lens_dist_rng_unit(rng)) / len);
+    else {
+        double sum = 0;
+        for (size_t i = 0; i < len; ++i)
+            sum -= log(lens_dist_rng_unit(rng)) / (dist->n - i);
+        dist->skip_w = -expm1(-sum);
+    }
+
+    lens_dist_skip_next(dist, rng);
+}
+
+
+// -----------------------------------------------------------------------------
+// decay
+// -----------------------------------------------------------------------------
+
+// Forward decay weights each record by exp(decay * (t - landmark)) which
+// favours recent records without having to touch the older ones. The
+// reservoir is maintained with Chao's weighted sampling: once full, a record
+// replaces a random sample with a probability proportional to its share of
+// the total weight. Records that outweigh the entire reservoir always make it
+// in but can't pick the lightest sample to replace which slightly slows down
+// the decay of dists with fewer records than samples per half-life.
+
+// Moving the landmark forward keeps the weights within the range of a double.
+static const double lens_dist_decay_rebase = 64;
+
+static inline double lens_dist_decay_exponent(
+        const struct lens_dist *dist_head, uint64_t t, uint64_t landmark)
+{
+    return dist_head->decay * (double) (int64_t) (t - landmark);
+}
+
+static inline bool lens_dist_decay_pick(struct rng *rng, double prob)
+{
+    return prob >= 1 || rng_gen_prob(rng, prob);
+}
+
+// Should be called while holding the reservoir's lock.
+static void lens_dist_record_decayed(
+        struct lens_dist *dist_head, struct lens_dist_epoch *dist, double value, uint64_t now)
+{
+    size_t len = dist_head->reservoir_len;
+
+    if (!dist->n) {
+        dist->landmark = now;
+        dist->weight = 1;
+        lens_dist_sample_set(dist_head, dist, 0, value);
+        return;
+    }
+
+    double exponent = lens_dist_decay_exponent(dist_head, now, dist->landmark);
+    if (exponent > lens_dist_decay_rebase) {
+        dist->weight *= exp(-exponent);
+        dist->landmark = now;
+        exponent = 0;
+    }
+
+    double weight = exp(exponent);
+    dist->weight += weight;
+
+    if (dist->n < len)
+        lens_dist_sample_set(dist_head, dist, dist->n, value);
+    else {
+        struct rng *rng = rng_global();
+        if (lens_dist_decay_pick(rng, len * weight / dist->weight))
+            lens_dist_sample_set(dist_head, dist, rng_gen_range(rng, 0, len), value);
+    }
+}
+
 
 // -----------------------------------------------------------------------------
 // impl
 // -----------------------------------------------------------------------------
 
 
+// A half-life of 0 disables forward decay. The tsc scale is only used to
+// convert the half-life into tsc ticks.
 static struct lens *
-lens_dist_alloc(struct optics *optics, const char *name)
+lens_dist_alloc(
+        struct optics *optics,
+        const char *name,
+        size_t reservoir_len,
+        bool compact,
+        double half_life,
+        double tsc_nanos,
+        size_t stripes)
+{
+    if (reservoir_len < optics_dist_samples_min || reservoir_len > optics_dist_samples_max) {
+        optics_fail("invalid dist reservoir size '%lu' not in [%d, %d]",
+                reservoir_len, optics_dist_samples_min, optics_dist_samples_max);
+        return NULL;
+    }
+
+    if (!(half_life >= 0) || isinf(half_life)) {
+        optics_fail("invalid dist half-life '%g'", half_life);
+        return NULL;
+    }
+
+    if (stripes > lens_dist_stripes_max) stripes = lens_dist_stripes_max;
+
+    size_t epoch_len = sizeof(struct lens_dist_epoch) +
+        reservoir_len * (compact ? sizeof(float) : sizeof(double));
+    epoch_len = align(epoch_len, stripes ? 64 : sizeof(double));
+
+    size_t len = sizeof(struct lens_dist) + (stripes ? stripes : 1) * 2 * epoch_len;
+
+    struct lens *lens = lens_alloc(optics, optics_dist, len, name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_dist *dist = lens_sub_ptr(lens, optics_dist);
+    if (!dist) goto fail_sub;
+
+    dist->reservoir_len = reservoir_len;
+    dist->epoch_len = epoch_len;
+    dist->stripes = stripes;
+    dist->compact = compact;
+
+    if (half_life > 0) {
+        dist->half_life = half_life;
+        dist->decay = M_LN2 / (half_life * 1e9) * tsc_nanos;
+    }
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+// Returns a locked reservoir for the given epoch. Striped dists start with the
+// stripe of the current cpu and move on to the next stripe if it's already
+// taken instead of spinning. We only wait on a lock if every stripe is taken
+// which requires more concurrent writers than we have stripes.
+static struct lens_dist_epoch *
+lens_dist_lock(struct lens_dist *dist_head, optics_epoch_t epoch)
+{
+    struct lens_dist_epoch *dist = lens_dist_epoch(dist_head, 0, epoch);
+
+    if (dist_head->stripes) {
+        size_t mask = dist_head->stripes - 1;
+        size_t stripe = lens_stripe(dist_head->stripes);
+
+        for (size_t i = 0; i < dist_head->stripes; ++i) {
+            dist = lens_dist_epoch(dist_head, (stripe + i) & mask, epoch);
+            if (slock_try_lock(&dist->lock)) return dist;
+        }
+
+        dist = lens_dist_epoch(dist_head, stripe, epoch);
+    }
+
+    slock_lock(&dist->lock);
+    return dist;
+}
+
+static void
+lens_dist_record_typed(
+        struct lens_dist *dist_head, optics_epoch_t epoch, double value, uint64_t exemplar)
+{
+    size_t len = dist_head->reservoir_len;
+    uint64_t now = dist_head->decay ? optics_rdtsc() : 0;
+
+    struct lens_dist_epoch *dist = lens_dist_lock(dist_head, epoch);
+    {
+        if (dist_head->decay) {
+            lens_dist_record_decayed(dist_head, dist, value, now);
+            dist->n++;
+        }
+        else if (dist->n < len) {
+            lens_dist_sample_set(dist_head, dist, dist->n, value);
+            dist->n++;
+
+            if (dist->n == len)
+                lens_dist_skip_reset(dist, len, rng_global());
+        }
+        else if (dist->n == dist->skip) {
+            struct rng *rng = rng_global();
+            lens_dist_sample_set(dist_head, dist, rng_gen_range(rng, 0, len), value);
+
+            dist->n++;
+            lens_dist_skip_sampled(dist, len, rng);
+            lens_dist_skip_next(dist, rng);
+        }
+        else dist->n++;
+
+        if (value > dist->max) dist->max = value;
+
+        // Already covered by the reservoir lock so no need for a CAS.
+        if (exemplar && (!dist->exemplar || value > dist->exemplar_value)) {
+            dist->exemplar = exemplar;
+            dist->exemplar_value = value;
+        }
+
+        slock_unlock(&dist->lock);
+    }
+}
+
+static bool
+lens_dist_record(
+        struct optics_lens* lens, optics_epoch_t epoch, double value, uint64_t exemplar)
 {
-    return lens_alloc(optics, optics_dist, sizeof(struct lens_dist), name);
+    struct lens_dist *dist_head = lens_sub_ptr(lens->lens, optics_dist);
+    if (!dist_head) return false;
+
+    lens_dist_record_typed(dist_head, epoch, value, exemplar);
+    return true;
 }
 
+// Holds the reservoir lock for the entire array and uses the skip counts to jump
+// directly to the values that need to be sampled. Forward decayed dists give
+// all the values the same timestamp and have no skip counts.
 static bool
-lens_dist_record(struct optics_lens* lens, optics_epoch_t epoch, double value)
+lens_dist_record_n(
+        struct optics_lens* lens, optics_epoch_t epoch, const double *values, size_t n)
 {
     struct lens_dist *dist_head = lens_sub_ptr(lens->lens, optics_dist);
     if (!dist_head) return false;
+    if (!n) return true;
+
+    double max = values[0];
+    for (size_t i = 1; i < n; ++i)
+        max = values[i] > max ? values[i] : max;
 
-    struct lens_dist_epoch *dist = &dist_head->epochs[epoch];
+    size_t len = dist_head->reservoir_len;
+    uint64_t now = dist_head->decay ? optics_rdtsc() : 0;
+
+    struct lens_dist_epoch *dist = lens_dist_lock(dist_head, epoch);
     {
-        slock_lock(&dist->lock);
+        size_t i = 0;
+        struct rng *rng = rng_global();
 
-        size_t i = dist->n;
-        if (i >= optics_dist_samples)
-            i = rng_gen_range(rng_global(), 0, dist->n);
-        if (i < optics_dist_samples)
-            dist->samples[i] = value;
+        if (dist_head->decay) {
+            for (; i < n; ++i, dist->n++)
+                lens_dist_record_decayed(dist_head, dist, values[i], now);
+        }
 
-        dist->n++;
-        if (value > dist->max) dist->max = value;
+        else if (dist->n < len) {
+            size_t fill = len - dist->n;
+            if (fill > n) fill = n;
+
+            lens_dist_samples_store(dist_head, dist, dist->n, values, fill);
+            dist->n += fill;
+            i += fill;
+
+            if (dist->n == len) lens_dist_skip_reset(dist, len, rng);
+        }
+
+        while (i < n) {
+            size_t skip = dist->skip - dist->n;
+            if (skip >= n - i) {
+                dist->n += n - i;
+                break;
+            }
+
+            i += skip;
+            dist->n += skip;
+            lens_dist_sample_set(dist_head, dist, rng_gen_range(rng, 0, len), values[i]);
+
+            i++;
+            dist->n++;
+            lens_dist_skip_sampled(dist, len, rng);
+            lens_dist_skip_next(dist, rng);
+        }
+
+        if (max > dist->max) dist->max = max;
 
         slock_unlock(&dist->lock);
     }
@@ -58,23 +426,27 @@ lens_dist_record(struct optics_lens* lens, optics_epoch_t epoch, double value)
 }
 
 
-static int lens_dist_value_cmp(const void *lhs, const void *rhs)
+static inline size_t lens_dist_p(size_t percentile, size_t n)
 {
-    return *((double *) lhs) - *((double *) rhs);
+    return (n * percentile) / 100;
 }
 
-static inline size_t lens_dist_p(size_t percentile, size_t n)
+// Number of samples held by a reservoir of len samples after n records.
+static size_t lens_dist_sampled_len(size_t n, size_t len)
 {
-    return (n * percentile) / 100;
+    return n > len ? len : n;
 }
 
-static size_t lens_dist_reservoir_len(size_t len)
+// Full reservoirs are merged based on the number of values they stand for which
+// includes the values skipped by sampled lenses. Partial reservoirs have to
+// stick to their recorded count as it's also their number of valid samples.
+static size_t lens_dist_merge_len(size_t recorded, size_t n, size_t len)
 {
-    return len > optics_dist_samples ? optics_dist_samples : len;
+    return recorded < len ? recorded : n;
 }
 
 static size_t lens_dist_merge(
-        double *dst,
+        double *dst, size_t len,
         const double *lhs, size_t lhs_len,
         const double *rhs, size_t rhs_len)
 {
@@ -83,25 +455,25 @@ static size_t lens_dist_merge(
 
     if (lhs_len >= rhs_len) {
         dst_len = lhs_len;
-        memcpy(dst, lhs, lens_dist_reservoir_len(lhs_len) * sizeof(*lhs));
+        memcpy(dst, lhs, lens_dist_sampled_len(lhs_len, len) * sizeof(*lhs));
 
         to_merge = rhs;
         to_merge_len = rhs_len;
     }
     else {
         dst_len = rhs_len;
-        memcpy(dst, rhs, lens_dist_reservoir_len(rhs_len) * sizeof(*rhs));
+        memcpy(dst, rhs, lens_dist_sampled_len(rhs_len, len) * sizeof(*rhs));
 
         to_merge = lhs;
         to_merge_len = lhs_len;
     }
 
     assert(to_merge_len <= dst_len);
-    if (!to_merge_len) return lens_dist_reservoir_len(dst_len);
+    if (!to_merge_len) return lens_dist_sampled_len(dst_len, len);
 
     // Fill up our reservoir if not already full.
-    if (dst_len < optics_dist_samples) {
-        size_t to_copy = optics_dist_samples - dst_len;
+    if (dst_len < len) {
+        size_t to_copy = len - dst_len;
         if (to_copy > to_merge_len) to_copy = to_merge_len;
 
         memcpy(dst + dst_len, to_merge, to_copy * sizeof(*lhs));
@@ -112,69 +484,325 @@ static size_t lens_dist_merge(
         if (!to_merge_len) return dst_len;
     }
 
+    struct rng *rng = rng_global();
+
     // We have non-sampled data so use the regular sampling method
-    if (to_merge_len <= optics_dist_samples) {
+    if (to_merge_len <= len) {
         for (size_t i = 0; i < to_merge_len; ++i) {
-            size_t index = rng_gen_range(rng_global(), 0, dst_len);
-            if (index < optics_dist_samples)
+            size_t index = rng_gen_range(rng, 0, dst_len);
+            if (index < len)
                 dst[index] = to_merge[i];
             dst_len++;
         }
     }
 
     // We have two sampled set so pick from each set with proportion equal to
-    // the number of values they represent.
+    // the number of values they represent. Equivalent to rng_gen_prob but with
+    // the threshold computed once for the whole reservoir.
     else {
         const double rate = (double) to_merge_len / (double) (to_merge_len + dst_len);
-        for (size_t i = 0; i < optics_dist_samples; ++i) {
-            if (rng_gen_prob(rng_global(), rate))
+        const uint64_t threshold = rate * rng_max();
+
+        for (size_t i = 0; i < len; ++i) {
+            if (rng_gen(rng) <= threshold)
                 dst[i] = to_merge[i];
         }
     }
 
-    return optics_dist_samples;
+    return len;
 }
 
-static enum optics_ret
-lens_dist_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_dist *value)
+static inline double lens_dist_log_add(double lhs, double rhs)
+{
+    if (lhs < rhs) { double tmp = lhs; lhs = rhs; rhs = tmp; }
+    return lhs + log1p(exp(rhs - lhs));
+}
+
+// Counterpart of lens_dist_merge for forward decayed reservoirs where each
+// reservoir is weighted by the log of the decayed weight of its records instead
+// of its number of records. The records of a reservoir that isn't full are
+// assumed to have an equal share of its weight since we don't keep the weight
+// of individual records.
+static size_t lens_dist_merge_decayed(
+        double *dst, size_t len,
+        const double *lhs, size_t lhs_len, double lhs_weight,
+        const double *rhs, size_t rhs_len, double rhs_weight)
+{
+    if (lhs_len < rhs_len) {
+        const double *samples = lhs; lhs = rhs; rhs = samples;
+        size_t n = lhs_len; lhs_len = rhs_len; rhs_len = n;
+        double weight = lhs_weight; lhs_weight = rhs_weight; rhs_weight = weight;
+    }
+
+    size_t dst_len = lens_dist_sampled_len(lhs_len, len);
+    memcpy(dst, lhs, dst_len * sizeof(*lhs));
+    if (!rhs_len) return dst_len;
+
+    struct rng *rng = rng_global();
+
+    // We have non-sampled data so feed it record by record. Weights are
+    // relative to the weight of a single record which saves us the logs. The
+    // exponent is clamped to avoid overflowing to inf when lhs is much fresher
+    // than rhs; the records of rhs are negligible past that point anyway.
+    if (rhs_len <= len) {
+        double exponent = lhs_weight - (rhs_weight - log(rhs_len));
+        if (exponent > lens_dist_decay_rebase) exponent = lens_dist_decay_rebase;
+        double weight = exp(exponent);
+
+        for (size_t i = 0; i < rhs_len; ++i) {
+            weight += 1;
+
+            if (dst_len < len) dst[dst_len++] = rhs[i];
+            else if (lens_dist_decay_pick(rng, len / weight))
+                dst[rng_gen_range(rng, 0, len)] = rhs[i];
+        }
+
+        return dst_len;
+    }
+
+    // We have two sampled set so pick from each set with proportion equal to
+    // the weight they represent. A stale lhs rounds the rate to 1 which would
+    // overflow the threshold so rhs is taken as is instead.
+    const double rate = 1 / (1 + exp(lhs_weight - rhs_weight));
+    if (rate >= 1) {
+        memcpy(dst, rhs, len * sizeof(*rhs));
+        return len;
+    }
+
+    const uint64_t threshold = rate * rng_max();
+
+    for (size_t i = 0; i < len; ++i) {
+        if (rng_gen(rng) <= threshold)
+            dst[i] = rhs[i];
+    }
+
+    return len;
+}
+
+// Batches don't carry the timestamps required by forward decayed dists.
+static bool
+lens_dist_reservoir(struct optics_lens *lens, size_t *reservoir_len)
 {
     struct lens_dist *dist_head = lens_sub_ptr(lens->lens, optics_dist);
-    if (!dist_head) return optics_err;
+    if (!dist_head) return false;
+
+    if (dist_head->decay) {
+        optics_fail("unsupported batch on forward decayed dist '%s'", lens_name(lens->lens));
+        return false;
+    }
+
+    *reservoir_len = dist_head->reservoir_len;
+    return true;
+}
+
+// Samples must come from a reservoir of the same size as the lens' reservoir.
+static bool
+lens_dist_commit(
+        struct optics_lens *lens,
+        optics_epoch_t epoch,
+        const double *samples, size_t samples_len,
+        double max)
+{
+    struct lens_dist *dist_head = lens_sub_ptr(lens->lens, optics_dist);
+    if (!dist_head) return false;
+    if (!samples_len) return true;
 
-    struct lens_dist_epoch *dist = &dist_head->epochs[epoch];
+    size_t len = dist_head->reservoir_len;
 
-    size_t samples_len = 0;
-    double samples[optics_dist_samples];
+    struct lens_dist_epoch *dist = lens_dist_lock(dist_head, epoch);
     {
-        // Since we're not locking the active epoch, we should only contend
-        // with straglers which can be dealt with by the poller.
-        if (slock_is_locked(&dist->lock)) return optics_busy;
+        double reservoir[optics_dist_samples_max];
+        lens_dist_samples_load(
+                dist_head, dist, reservoir, lens_dist_sampled_len(dist->n, len));
 
-        samples_len = dist->n;
-        if (value->max < dist->max) value->max = dist->max;
+        double result[optics_dist_samples_max];
+        size_t result_len = lens_dist_merge(
+                result, len, reservoir, dist->n, samples, samples_len);
+        lens_dist_samples_store(dist_head, dist, 0, result, result_len);
 
-        size_t to_copy = lens_dist_reservoir_len(samples_len);
-        memcpy(samples, dist->samples, to_copy * sizeof(samples[0]));
+        dist->n += samples_len;
+        if (max > dist->max) dist->max = max;
 
-        dist->max = 0;
-        dist->n = 0;
+        if (dist->n >= len)
+            lens_dist_skip_reset(dist, len, rng_global());
 
         slock_unlock(&dist->lock);
     }
+    return true;
+}
+
+// Should be called while holding the reservoir's lock. Weights of forward
+// decayed reservoirs are moved from their landmark to now so that reservoirs
+// from different stripes and regions can be compared.
+static void
+lens_dist_read_epoch(
+        struct lens_dist *dist_head,
+        struct lens_dist_epoch *dist,
+        size_t sampling,
+        uint64_t now,
+        struct optics_dist *value)
+{
+    size_t samples_len = dist->n;
+    if (!samples_len) return;
+
+    if (value->max < dist->max) value->max = dist->max;
+
+    bool exemplar = dist->exemplar &&
+        (!value->exemplar || value->exemplar_value < dist->exemplar_value);
+    if (exemplar) {
+        value->exemplar = dist->exemplar;
+        value->exemplar_value = dist->exemplar_value;
+    }
+
+    size_t len = dist_head->reservoir_len;
+    size_t sampled_len = lens_dist_sampled_len(samples_len, len);
+
+    double weight = 0;
+    if (dist_head->decay) {
+        weight = log(dist->weight) + log(sampling) +
+            lens_dist_decay_exponent(dist_head, dist->landmark, now);
+    }
+
+    // The first reservoir read is by far the most common case and doesn't need
+    // to go through the merge.
+    if (!value->recorded) {
+        lens_dist_samples_load(dist_head, dist, value->samples, sampled_len);
+        value->weight = weight;
+    }
+    else {
+        double reservoir[optics_dist_samples_max];
+        lens_dist_samples_load(dist_head, dist, reservoir, sampled_len);
+
+        size_t result_len = 0;
+        double result[optics_dist_samples_max];
+
+        if (!dist_head->decay) {
+            result_len = lens_dist_merge(
+                    result, len,
+                    reservoir, lens_dist_merge_len(samples_len, samples_len * sampling, len),
+                    value->samples, lens_dist_merge_len(value->recorded, value->n, len));
+        }
+        else {
+            result_len = lens_dist_merge_decayed(
+                    result, len,
+                    reservoir, samples_len, weight,
+                    value->samples, value->recorded, value->weight);
+            value->weight = lens_dist_log_add(value->weight, weight);
+        }
+
+        memcpy(value->samples, result, result_len * sizeof(result[0]));
+    }
+    value->n += samples_len * sampling;
+    value->recorded += samples_len;
+
+    dist->max = 0;
+    dist->n = 0;
+    dist->exemplar = 0;
+    dist->exemplar_value = 0;
+}
+
+static inline void lens_dist_swap(double *samples, size_t i, size_t j)
+{
+    double tmp = samples[i];
+    samples[i] = samples[j];
+    samples[j] = tmp;
+}
+
+// Quickselect which moves the k-th smallest sample to index k with every sample
+// before it smaller or equal and every sample after it greater or equal.
+static void lens_dist_select(double *samples, size_t len, size_t k)
+{
+    ssize_t lo = 0, hi = len - 1;
+
+    while (lo < hi) {
+        ssize_t mid = lo + (hi - lo) / 2;
+        if (samples[mid] < samples[lo]) lens_dist_swap(samples, lo, mid);
+        if (samples[hi] < samples[lo]) lens_dist_swap(samples, lo, hi);
+        if (samples[hi] < samples[mid]) lens_dist_swap(samples, mid, hi);
+        double pivot = samples[mid];
+
+        ssize_t i = lo, j = hi;
+        while (i <= j) {
+            while (samples[i] < pivot) i++;
+            while (samples[j] > pivot) j--;
+            if (i <= j) lens_dist_swap(samples, i++, j--);
+        }
+
+        if ((ssize_t) k <= j) hi = j;
+        else if ((ssize_t) k >= i) lo = i;
+        else return;
+    }
+}
+
+// The order of the samples in a reservoir is irrelevant so we can select the
+// percentiles in place. Selecting from the highest percentile down means that
+// each selection only has to look at the samples below the previous one.
+static void lens_dist_percentiles(struct optics_dist *value)
+{
+    size_t len = lens_dist_sampled_len(value->recorded, value->reservoir_len);
+    if (!len) return;
+
+    struct { size_t percentile; double *dst; } percentiles[] = {
+        { 99, &value->p99 },
+        { 90, &value->p90 },
+        { 50, &value->p50 },
+    };
+
+    size_t end = len;
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+        size_t k = lens_dist_p(percentiles[i].percentile, len);
+        if (k < end) lens_dist_select(value->samples, end, k);
+
+        *percentiles[i].dst = value->samples[k];
+        end = k;
+    }
+}
+
+static enum optics_ret
+lens_dist_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_dist *value)
+{
+    struct lens_dist *dist_head = lens_sub_ptr(lens->lens, optics_dist);
+    if (!dist_head) return optics_err;
+
+    // Reservoirs of different sizes can't be merged without biasing the
+    // samples towards the smaller one.
+    if (!value->reservoir_len) {
+        value->reservoir_len = dist_head->reservoir_len;
+        value->half_life = dist_head->half_life;
+    }
+    else if (value->reservoir_len != dist_head->reservoir_len) {
+        optics_fail("mismatched dist reservoir size '%lu' != '%lu'",
+                value->reservoir_len, dist_head->reservoir_len);
+        return optics_err;
+    }
+    else if (value->half_life != dist_head->half_life) {
+        optics_fail("mismatched dist half-life '%g' != '%g'",
+                value->half_life, dist_head->half_life);
+        return optics_err;
+    }
 
-    if (!samples_len) return optics_ok;
+    uint64_t now = dist_head->decay ? optics_rdtsc() : 0;
+    size_t sampling = lens_sampling(lens->lens);
 
-    double result[optics_dist_samples];
-    size_t result_len = lens_dist_merge(result, samples, samples_len, value->samples, value->n);
+    // Every stripe must be locked before any of them is read so that the value
+    // either covers the entire epoch or nothing at all. Skipping a busy stripe
+    // would leave its samples to be mixed with the samples of a later interval.
+    size_t stripes = dist_head->stripes ? dist_head->stripes : 1;
+    for (size_t i = 0; i < stripes; ++i) {
+        if (lens_read_lock(&lens_dist_epoch(dist_head, i, epoch)->lock)) continue;
 
-    memcpy(value->samples, result, optics_dist_samples * sizeof(double));
-    qsort(result, result_len, sizeof(double), lens_dist_value_cmp);
+        while (i > 0) slock_unlock(&lens_dist_epoch(dist_head, --i, epoch)->lock);
+        return optics_busy;
+    }
 
-    value->n += samples_len;
-    value->p50 = result[lens_dist_p(50, result_len)];
-    value->p90 = result[lens_dist_p(90, result_len)];
-    value->p99 = result[lens_dist_p(99, result_len)];
+    size_t n = value->n;
+    for (size_t i = 0; i < stripes; ++i) {
+        struct lens_dist_epoch *dist = lens_dist_epoch(dist_head, i, epoch);
+        lens_dist_read_epoch(dist_head, dist, sampling, now, value);
+        slock_unlock(&dist->lock);
+    }
 
+    if (n != value->n) lens_dist_percentiles(value);
     return optics_ok;
 }
 
@@ -214,5 +842,15 @@ lens_dist_normalize(
     optics_key_pop(&key, old);
     if (!ret) return false;
 
+    // Like topk items, the tag goes in the key as it can't be represented
+    // exactly by the value.
+    if (poll->value.dist.exemplar) {
+        old = optics_key_push(&key, "exemplar");
+        optics_key_pushf(&key, "%lu", poll->value.dist.exemplar);
+        ret = cb(ctx, poll->ts, key.data, poll->value.dist.exemplar_value);
+        optics_key_pop(&key, old);
+        if (!ret) return false;
+    }
+
     return true;
 }
@@ -0,0 +1,177 @@
+/* lens_event.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+// The head of a ring packs the generation of the ring in its upper bits and the
+// number of reserved slots in its lower bits. Writers reserve a slot with a
+// single fetch_add and the reader starts a new generation when it drains the
+// ring which also resets the slot count.
+enum { lens_event_gen_shift = 32 };
+static const uint64_t lens_event_index_mask = (1UL << lens_event_gen_shift) - 1;
+
+// Slots are tagged with the generation they were written in so that the reader
+// can detect slots that were reserved but not yet written by stragglers.
+// Fields are atomics as they're read seqlock style.
+struct optics_packed lens_event_slot
+{
+    atomic_uint_fast64_t tag;
+    atomic_uint_fast64_t id;
+    atomic_uint_fast64_t value;
+};
+
+struct optics_packed lens_event
+{
+    size_t capacity;
+    atomic_uint_fast64_t heads[2];
+
+    // 2 epochs of capacity slots.
+    struct lens_event_slot slots[];
+};
+
+
+// -----------------------------------------------------------------------------
+// impl
+// -----------------------------------------------------------------------------
+
+static struct lens *
+lens_event_alloc(struct optics *optics, const char *name, size_t capacity)
+{
+    if (!capacity || capacity > optics_event_capacity_max) {
+        optics_fail("invalid event capacity '%lu' not in [1, %d]",
+                capacity, optics_event_capacity_max);
+        return NULL;
+    }
+
+    size_t len = sizeof(struct lens_event) + 2 * capacity * sizeof(struct lens_event_slot);
+    struct lens *lens = lens_alloc(optics, optics_event, len, name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_event *event = lens_sub_ptr(lens, optics_event);
+    if (!event) goto fail_sub;
+
+    event->capacity = capacity;
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+static void lens_event_record_typed(
+        struct lens_event *event, optics_epoch_t epoch, uint64_t id, double value)
+{
+    uint64_t head = atomic_fetch_add_explicit(&event->heads[epoch], 1, memory_order_relaxed);
+
+    // Overflowing events are dropped and accounted for by the reader.
+    size_t index = head & lens_event_index_mask;
+    if (index >= event->capacity) return;
+
+    struct lens_event_slot *slot = &event->slots[epoch * event->capacity + index];
+    uint64_t tag = (head >> lens_event_gen_shift) + 1;
+
+    atomic_store_explicit(&slot->tag, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&slot->id, id, memory_order_relaxed);
+    atomic_store_explicit(&slot->value, pun_dtoi(value), memory_order_relaxed);
+
+    atomic_store_explicit(&slot->tag, tag, memory_order_release);
+}
+
+static bool lens_event_record(
+        struct optics_lens *lens, optics_epoch_t epoch, uint64_t id, double value)
+{
+    struct lens_event *event = lens_sub_ptr(lens->lens, optics_event);
+    if (!event) return false;
+
+    lens_event_record_typed(event, epoch, id, value);
+    return true;
+}
+
+static enum optics_ret
+lens_event_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_event *value)
+{
+    struct lens_event *event = lens_sub_ptr(lens->lens, optics_event);
+    if (!event) return optics_err;
+
+    // Starting a new generation resets the ring and invalidates the tags of
+    // any stragglers still writing into it.
+    atomic_uint_fast64_t *head = &event->heads[epoch];
+    uint64_t old = atomic_load_explicit(head, memory_order_relaxed);
+    uint64_t new;
+    do {
+        new = ((old >> lens_event_gen_shift) + 1) << lens_event_gen_shift;
+    } while (!atomic_compare_exchange_weak_explicit(head, &old, new,
+                    memory_order_acquire, memory_order_relaxed));
+
+    size_t reserved = old & lens_event_index_mask;
+    size_t len = reserved < event->capacity ? reserved : event->capacity;
+    uint64_t tag = (old >> lens_event_gen_shift) + 1;
+
+    value->dropped += reserved - len;
+
+    struct lens_event_slot *slots = &event->slots[epoch * event->capacity];
+    for (size_t i = 0; i < len; ++i) {
+        struct lens_event_slot *slot = &slots[i];
+
+        uint64_t t0 = atomic_load_explicit(&slot->tag, memory_order_acquire);
+        uint64_t id = atomic_load_explicit(&slot->id, memory_order_relaxed);
+        uint64_t raw = atomic_load_explicit(&slot->value, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t t1 = atomic_load_explicit(&slot->tag, memory_order_relaxed);
+
+        // Slots that are still being written or that were merged from other
+        // processes past the capacity of the value are dropped.
+        if (t0 != tag || t1 != tag || value->len == optics_event_capacity_max) {
+            value->dropped++;
+            continue;
+        }
+
+        value->events[value->len++] = (struct optics_event_item) {
+            .id = id,
+            .value = pun_itod(raw),
+        };
+    }
+
+    return optics_ok;
+}
+
+static bool
+lens_event_normalize(
+        const struct optics_poll *poll, optics_normalize_cb_t cb, void *ctx)
+{
+    bool ret = false;
+    size_t old;
+
+    const struct optics_event *event = &poll->value.event;
+
+    struct optics_key key = {0};
+    optics_key_push(&key, poll->key);
+
+    old = optics_key_push(&key, "count");
+    ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, event->len));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    old = optics_key_push(&key, "dropped");
+    ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, event->dropped));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    for (size_t i = 0; i < event->len; ++i) {
+        old = optics_key_pushf(&key, "%lu", event->events[i].id);
+        ret = cb(ctx, poll->ts, key.data, event->events[i].value);
+        optics_key_pop(&key, old);
+        if (!ret) return false;
+    }
+
+    return true;
+}
@@ -13,6 +13,10 @@
 struct optics_packed lens_gauge
 {
     atomic_uint_fast64_t value;
+
+    // Additive gauges are summed across processes by the poller instead of
+    // being overwritten.
+    bool additive;
 };
 
 static_assert(sizeof(atomic_uint_fast64_t) == sizeof(double),
@@ -27,23 +31,94 @@ static_assert(sizeof(uint64_t) == sizeof(double),
 // -----------------------------------------------------------------------------
 
 static struct lens *
-lens_gauge_alloc(struct optics *optics, const char *name)
+lens_gauge_alloc(struct optics *optics, const char *name, bool additive)
+{
+    struct lens *lens = lens_alloc(optics, optics_gauge, sizeof(struct lens_gauge), name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_gauge *gauge = lens_sub_ptr(lens, optics_gauge);
+    if (!gauge) goto fail_sub;
+
+    gauge->additive = additive;
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+// Additive and regular gauges are merged differently by the poller so a gauge
+// can't be opened as the other kind. Lenses of other types are left to the
+// type checks of the record functions.
+static bool lens_gauge_check_additive(struct lens *lens, bool additive)
+{
+    if (lens_type(lens) != optics_gauge) return true;
+
+    struct lens_gauge *gauge = lens_sub_ptr(lens, optics_gauge);
+    if (gauge->additive == additive) return true;
+
+    optics_fail("mismatched gauge '%s' additive '%d' != '%d'",
+            lens_name(lens), gauge->additive, additive);
+    return false;
+}
+
+static void
+lens_gauge_set_typed(struct lens_gauge *gauge, optics_epoch_t epoch, double value)
 {
-    return lens_alloc(optics, optics_gauge, sizeof(struct lens_gauge), name);
+    (void) epoch;
+    atomic_store_explicit(&gauge->value, pun_dtoi(value), memory_order_relaxed);
 }
 
 static bool
 lens_gauge_set(struct optics_lens *lens, optics_epoch_t epoch, double value)
+{
+    struct lens_gauge *gauge = lens_sub_ptr(lens->lens, optics_gauge);
+    if (!gauge) return false;
+
+    lens_gauge_set_typed(gauge, epoch, value);
+    return true;
+}
+
+static void
+lens_gauge_add_typed(struct lens_gauge *gauge, optics_epoch_t epoch, double delta)
 {
     (void) epoch;
 
+    uint64_t old = atomic_load_explicit(&gauge->value, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(
+                    &gauge->value, &old, pun_dtoi(pun_itod(old) + delta),
+                    memory_order_relaxed, memory_order_relaxed));
+}
+
+static bool
+lens_gauge_add(struct optics_lens *lens, optics_epoch_t epoch, double delta)
+{
     struct lens_gauge *gauge = lens_sub_ptr(lens->lens, optics_gauge);
     if (!gauge) return false;
 
-    atomic_store_explicit(&gauge->value, pun_dtoi(value), memory_order_relaxed);
+    lens_gauge_add_typed(gauge, epoch, delta);
     return true;
 }
 
+// Only the last value of the array is visible to the poller so there's no point
+// in storing the others.
+static bool
+lens_gauge_set_last(
+        struct optics_lens *lens, optics_epoch_t epoch, const double *values, size_t n)
+{
+    if (!n) return lens_sub_ptr(lens->lens, optics_gauge) != NULL;
+    return lens_gauge_set(lens, epoch, values[n - 1]);
+}
+
+static atomic_uint_fast64_t *
+lens_gauge_inline(struct optics_lens *lens)
+{
+    struct lens_gauge *gauge = lens_sub_ptr(lens->lens, optics_gauge);
+    return gauge ? &gauge->value : NULL;
+}
+
 static enum optics_ret
 lens_gauge_read(struct optics_lens *lens, optics_epoch_t epoch, double *value)
 {
@@ -53,7 +128,8 @@ lens_gauge_read(struct optics_lens *lens, optics_epoch_t epoch, double *value)
     if (!gauge) return optics_err;
 
     uint64_t result = atomic_load_explicit(&gauge->value, memory_order_relaxed);
-    *value = pun_itod(result);
+    if (gauge->additive) *value += pun_itod(result);
+    else *value = pun_itod(result);
 
     return optics_ok;
 }
@@ -0,0 +1,341 @@
+/* lens_hdr.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+struct optics_packed lens_hdr_epoch
+{
+    atomic_size_t above;
+    atomic_uint_fast64_t max;
+    atomic_size_t counts[];
+};
+
+// The two epochs are laid out back to back after the header and hold
+// buckets_len counters each.
+struct optics_packed lens_hdr
+{
+    size_t precision;
+    size_t bits;
+    size_t unit;
+    size_t buckets_len;
+};
+
+
+// -----------------------------------------------------------------------------
+// buckets
+// -----------------------------------------------------------------------------
+
+// Number of bits needed to keep the relative error of a bucket below the given
+// number of significant decimal digits: 4 bits for 1 digit, 7 for 2 and 10 for
+// 3.
+static size_t lens_hdr_bits(size_t precision)
+{
+    uint64_t digits = 1;
+    for (size_t i = 0; i < precision; ++i) digits *= 10;
+    return 64 - clz(digits - 1);
+}
+
+// Buckets are split into groups of 2^bits buckets where the first two groups
+// linearly cover [0, 2^(bits+1)[ with buckets of width 1 and every subsequent
+// group covers the next power of two with buckets twice as wide as the
+// previous group. Group g > 0 therefore covers [2^(bits+g-1), 2^(bits+g)[ with
+// buckets of width 2^(g-1). The bucket of a value is given by the position of
+// its leading bit (the group) and the bits that follow it (the bucket within
+// the group).
+static inline size_t lens_hdr_index(size_t bits, uint64_t value)
+{
+    if (value < (1UL << bits)) return value;
+
+    size_t exp = 63 - clz(value);
+    size_t group = exp - bits + 1;
+    size_t sub = (value >> (exp - bits)) & ((1UL << bits) - 1);
+    return (group << bits) | sub;
+}
+
+// Returns the highest value that maps to the given bucket.
+static uint64_t lens_hdr_bucket_max(size_t bits, size_t index)
+{
+    size_t group = index >> bits;
+    uint64_t sub = index & ((1UL << bits) - 1);
+    if (!group) return sub;
+
+    uint64_t lower = ((1UL << bits) + sub) << (group - 1);
+    return lower + ((1UL << (group - 1)) - 1);
+}
+
+// Rounded up to a full group so that every value of the group of highest is
+// also covered.
+static size_t lens_hdr_buckets_len(size_t bits, size_t unit, uint64_t highest)
+{
+    size_t group = lens_hdr_index(bits, highest >> unit) >> bits;
+    return (group + 1) << bits;
+}
+
+static size_t lens_hdr_epoch_len(size_t buckets_len)
+{
+    return sizeof(struct lens_hdr_epoch) + buckets_len * sizeof(atomic_size_t);
+}
+
+static size_t lens_hdr_len(size_t buckets_len)
+{
+    return sizeof(struct lens_hdr) + 2 * lens_hdr_epoch_len(buckets_len);
+}
+
+static struct lens_hdr_epoch *
+lens_hdr_epoch(struct lens_hdr *hdr, optics_epoch_t epoch)
+{
+    uint8_t *epochs = (uint8_t *) (hdr + 1);
+    return (struct lens_hdr_epoch *) (epochs + epoch * lens_hdr_epoch_len(hdr->buckets_len));
+}
+
+
+// -----------------------------------------------------------------------------
+// impl
+// -----------------------------------------------------------------------------
+
+// Returns the number of buckets needed to cover [lowest, highest] or 0 if the
+// configuration is invalid or doesn't fit in the bucket budget.
+static size_t lens_hdr_check(size_t precision, uint64_t lowest, uint64_t highest)
+{
+    if (precision < optics_hdr_precision_min || precision > optics_hdr_precision_max) {
+        optics_fail("invalid hdr precision '%lu' not in [%d, %d]",
+                precision, optics_hdr_precision_min, optics_hdr_precision_max);
+        return 0;
+    }
+
+    if (!lowest) {
+        optics_fail("invalid hdr lowest value '0'");
+        return 0;
+    }
+
+    if (highest < 2 * lowest) {
+        optics_fail("invalid hdr highest value '%lu' < 2 * '%lu'", highest, lowest);
+        return 0;
+    }
+
+    size_t len = lens_hdr_buckets_len(lens_hdr_bits(precision), 63 - clz(lowest), highest);
+    if (len > optics_hdr_buckets_max) {
+        optics_fail("hdr range [%lu, %lu] at precision '%lu' needs '%lu' buckets > '%d'",
+                lowest, highest, precision, len, optics_hdr_buckets_max);
+        return 0;
+    }
+
+    return len;
+}
+
+static void
+lens_hdr_init(struct lens_hdr *hdr, size_t precision, uint64_t lowest, uint64_t highest)
+{
+    hdr->precision = precision;
+    hdr->bits = lens_hdr_bits(precision);
+    hdr->unit = 63 - clz(lowest);
+    hdr->buckets_len = lens_hdr_buckets_len(hdr->bits, hdr->unit, highest);
+}
+
+static struct lens *
+lens_hdr_alloc(
+        struct optics *optics,
+        const char *name,
+        size_t precision,
+        uint64_t lowest,
+        uint64_t highest)
+{
+    size_t buckets_len = lens_hdr_check(precision, lowest, highest);
+    if (!buckets_len) return NULL;
+
+    struct lens *lens = lens_alloc(optics, optics_hdr, lens_hdr_len(buckets_len), name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_hdr *hdr = lens_sub_ptr(lens, optics_hdr);
+    if (!hdr) goto fail_sub;
+
+    lens_hdr_init(hdr, precision, lowest, highest);
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+static void lens_hdr_record_max(struct lens_hdr_epoch *counters, uint64_t value)
+{
+    // The max rarely changes once an epoch is warmed up so the CAS is almost
+    // never reached.
+    uint64_t max = atomic_load_explicit(&counters->max, memory_order_relaxed);
+    while (value > max) {
+        if (atomic_compare_exchange_weak_explicit(&counters->max, &max, value,
+                        memory_order_relaxed, memory_order_relaxed))
+            break;
+    }
+}
+
+static void
+lens_hdr_record_typed(struct lens_hdr *hdr, optics_epoch_t epoch, uint64_t value)
+{
+    struct lens_hdr_epoch *counters = lens_hdr_epoch(hdr, epoch);
+
+    size_t index = lens_hdr_index(hdr->bits, value >> hdr->unit);
+    if (index < hdr->buckets_len)
+        atomic_fetch_add_explicit(&counters->counts[index], 1, memory_order_relaxed);
+    else atomic_fetch_add_explicit(&counters->above, 1, memory_order_relaxed);
+
+    lens_hdr_record_max(counters, value);
+}
+
+static bool
+lens_hdr_record(struct optics_lens *lens, optics_epoch_t epoch, uint64_t value)
+{
+    struct lens_hdr *hdr = lens_sub_ptr(lens->lens, optics_hdr);
+    if (!hdr) return false;
+
+    lens_hdr_record_typed(hdr, epoch, value);
+    return true;
+}
+
+// The bucket array is too large to be batched on the stack so only the max
+// and the above count are accumulated before being published.
+static bool
+lens_hdr_record_n(
+        struct optics_lens *lens, optics_epoch_t epoch, const uint64_t *values, size_t n)
+{
+    struct lens_hdr *hdr = lens_sub_ptr(lens->lens, optics_hdr);
+    if (!hdr) return false;
+    if (!n) return true;
+
+    struct lens_hdr_epoch *counters = lens_hdr_epoch(hdr, epoch);
+
+    uint64_t max = 0;
+    size_t above = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t index = lens_hdr_index(hdr->bits, values[i] >> hdr->unit);
+        if (index < hdr->buckets_len)
+            atomic_fetch_add_explicit(&counters->counts[index], 1, memory_order_relaxed);
+        else above++;
+
+        max = values[i] > max ? values[i] : max;
+    }
+
+    if (above) atomic_fetch_add_explicit(&counters->above, above, memory_order_relaxed);
+    lens_hdr_record_max(counters, max);
+
+    return true;
+}
+
+static enum optics_ret
+lens_hdr_read_typed(struct lens_hdr *hdr, optics_epoch_t epoch, struct optics_hdr *value)
+{
+    if (!value->buckets_len) {
+        value->precision = hdr->precision;
+        value->unit = hdr->unit;
+        value->buckets_len = hdr->buckets_len;
+    }
+    else if (value->precision != hdr->precision
+            || value->unit != hdr->unit
+            || value->buckets_len != hdr->buckets_len)
+    {
+        optics_fail("mismatched hdr config '%lu:%lu:%lu' != '%lu:%lu:%lu'",
+                value->precision, value->unit, value->buckets_len,
+                hdr->precision, hdr->unit, hdr->buckets_len);
+        return optics_err;
+    }
+
+    struct lens_hdr_epoch *counters = lens_hdr_epoch(hdr, epoch);
+
+    value->above += atomic_exchange_explicit(&counters->above, 0, memory_order_relaxed);
+    for (size_t i = 0; i < hdr->buckets_len; ++i) {
+        value->counts[i] +=
+            atomic_exchange_explicit(&counters->counts[i], 0, memory_order_relaxed);
+    }
+
+    uint64_t max = atomic_exchange_explicit(&counters->max, 0, memory_order_relaxed);
+    if (max > value->max) value->max = max;
+
+    return optics_ok;
+}
+
+static enum optics_ret
+lens_hdr_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_hdr *value)
+{
+    struct lens_hdr *hdr = lens_sub_ptr(lens->lens, optics_hdr);
+    if (!hdr) return optics_err;
+
+    return lens_hdr_read_typed(hdr, epoch, value);
+}
+
+static size_t lens_hdr_count(const struct optics_hdr *hdr)
+{
+    size_t count = hdr->above;
+    for (size_t i = 0; i < hdr->buckets_len; ++i) count += hdr->counts[i];
+    return count;
+}
+
+static uint64_t lens_hdr_percentile(const struct optics_hdr *hdr, double percentile)
+{
+    size_t count = lens_hdr_count(hdr);
+    if (!count) return 0;
+
+    size_t rank = (count * percentile) / 100;
+    if (rank >= count) rank = count - 1;
+
+    size_t seen = 0;
+    size_t bits = lens_hdr_bits(hdr->precision);
+    for (size_t i = 0; i < hdr->buckets_len; ++i) {
+        seen += hdr->counts[i];
+        if (seen <= rank) continue;
+
+        uint64_t value = lens_hdr_bucket_max(bits, i);
+        if (value >= (hdr->max >> hdr->unit)) return hdr->max;
+        return ((value + 1) << hdr->unit) - 1;
+    }
+
+    return hdr->max;
+}
+
+static bool
+lens_hdr_normalize(
+        const struct optics_poll *poll, optics_normalize_cb_t cb, void *ctx)
+{
+    size_t old;
+    bool ret = false;
+    const struct optics_hdr *hdr = &poll->value.hdr;
+
+    struct optics_key key = {0};
+    optics_key_push(&key, poll->key);
+
+    old = optics_key_push(&key, "count");
+    ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, lens_hdr_count(hdr)));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    static const struct { const char *name; double percentile; } percentiles[] = {
+        { "p50", 50 }, { "p90", 90 }, { "p99", 99 }, { "p999", 99.9 },
+    };
+
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+        old = optics_key_push(&key, percentiles[i].name);
+        ret = cb(ctx, poll->ts, key.data,
+                lens_hdr_percentile(hdr, percentiles[i].percentile));
+        optics_key_pop(&key, old);
+        if (!ret) return false;
+    }
+
+    old = optics_key_push(&key, "max");
+    ret = cb(ctx, poll->ts, key.data, hdr->max);
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    old = optics_key_push(&key, "above");
+    ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, hdr->above));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    return true;
+}
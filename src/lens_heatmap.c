@@ -0,0 +1,203 @@
+/* lens_heatmap.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+// Each axis has one cell per bucket along with a below and an above cell. Cells
+// use the [below, buckets..., above] layout of lens_histo_index so the cell of a
+// value is the number of bounds that are less than or equal to it which can be
+// computed without branches.
+enum { lens_heatmap_cells_max = optics_heatmap_buckets_max + 2 };
+
+struct optics_packed lens_heatmap
+{
+    size_t x_len;
+    size_t y_len;
+    uint64_t x_buckets[optics_heatmap_buckets_max + 1];
+    uint64_t y_buckets[optics_heatmap_buckets_max + 1];
+
+    // Bounds converted to doubles and padded to the max length with infinity
+    // which lets the compiler fully unroll and vectorize the cell lookup.
+    double x_bounds[optics_heatmap_buckets_max + 1];
+    double y_bounds[optics_heatmap_buckets_max + 1];
+
+    // 2 epochs of (x_len + 1) * (y_len + 1) cells stored row-major by x.
+    atomic_size_t counts[];
+};
+
+static size_t lens_heatmap_cells(size_t x_len, size_t y_len)
+{
+    return (x_len + 1) * (y_len + 1);
+}
+
+// The padding bounds are only reached by +inf which must still land in the
+// above cell of the axis rather than past the end of the row. NaN compares false
+// against every bound and lands in the below cell.
+static inline size_t lens_heatmap_index(const double *bounds, size_t len, double value)
+{
+    size_t index = 0;
+    for (size_t i = 0; i < optics_heatmap_buckets_max + 1; ++i)
+        index += value >= bounds[i];
+    return index < len ? index : len;
+}
+
+
+// -----------------------------------------------------------------------------
+// impl
+// -----------------------------------------------------------------------------
+
+static bool lens_heatmap_check_axis(const char *axis, const uint64_t *buckets, size_t len)
+{
+    if (len < 2 || len > optics_heatmap_buckets_max + 1) {
+        optics_fail("invalid heatmap %s bucket length '%lu' not in [2, %d]",
+                axis, len, optics_heatmap_buckets_max + 1);
+        return false;
+    }
+
+    for (size_t i = 0; i < len - 1; ++i) {
+        if (buckets[i] < buckets[i + 1]) continue;
+
+        optics_fail("invalid heatmap %s buckets '%lu:%lu' >= '%lu:%lu'",
+                axis, i, buckets[i], i + 1, buckets[i + 1]);
+        return false;
+    }
+
+    return true;
+}
+
+static struct lens *
+lens_heatmap_alloc(
+        struct optics *optics, const char *name,
+        const uint64_t *x_buckets, size_t x_len,
+        const uint64_t *y_buckets, size_t y_len)
+{
+    if (!lens_heatmap_check_axis("x", x_buckets, x_len)) goto fail_buckets;
+    if (!lens_heatmap_check_axis("y", y_buckets, y_len)) goto fail_buckets;
+
+    size_t len = sizeof(struct lens_heatmap);
+    len += 2 * lens_heatmap_cells(x_len, y_len) * sizeof(atomic_size_t);
+
+    struct lens *lens = lens_alloc(optics, optics_heatmap, len, name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_heatmap *heatmap = lens_sub_ptr(lens, optics_heatmap);
+    if (!heatmap) goto fail_sub;
+
+    heatmap->x_len = x_len;
+    heatmap->y_len = y_len;
+    memcpy(heatmap->x_buckets, x_buckets, x_len * sizeof(x_buckets[0]));
+    memcpy(heatmap->y_buckets, y_buckets, y_len * sizeof(y_buckets[0]));
+
+    for (size_t i = 0; i < optics_heatmap_buckets_max + 1; ++i) {
+        heatmap->x_bounds[i] = i < x_len ? x_buckets[i] : INFINITY;
+        heatmap->y_bounds[i] = i < y_len ? y_buckets[i] : INFINITY;
+    }
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+  fail_buckets:
+    return NULL;
+}
+
+static void lens_heatmap_inc_typed(
+        struct lens_heatmap *heatmap, optics_epoch_t epoch, double x, double y)
+{
+    size_t xi = lens_heatmap_index(heatmap->x_bounds, heatmap->x_len, x);
+    size_t yi = lens_heatmap_index(heatmap->y_bounds, heatmap->y_len, y);
+
+    size_t cells = lens_heatmap_cells(heatmap->x_len, heatmap->y_len);
+    atomic_size_t *cell = &heatmap->counts[epoch * cells + xi * (heatmap->y_len + 1) + yi];
+    atomic_fetch_add_explicit(cell, 1, memory_order_relaxed);
+}
+
+static bool lens_heatmap_inc(
+        struct optics_lens *lens, optics_epoch_t epoch, double x, double y)
+{
+    struct lens_heatmap *heatmap = lens_sub_ptr(lens->lens, optics_heatmap);
+    if (!heatmap) return false;
+
+    lens_heatmap_inc_typed(heatmap, epoch, x, y);
+    return true;
+}
+
+static enum optics_ret
+lens_heatmap_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_heatmap *value)
+{
+    struct lens_heatmap *heatmap = lens_sub_ptr(lens->lens, optics_heatmap);
+    if (!heatmap) return optics_err;
+
+    size_t x_bytes = heatmap->x_len * sizeof(heatmap->x_buckets[0]);
+    size_t y_bytes = heatmap->y_len * sizeof(heatmap->y_buckets[0]);
+
+    if (!value->x_len) {
+        value->x_len = heatmap->x_len;
+        value->y_len = heatmap->y_len;
+        memcpy(value->x_buckets, heatmap->x_buckets, x_bytes);
+        memcpy(value->y_buckets, heatmap->y_buckets, y_bytes);
+    }
+    else if (value->x_len != heatmap->x_len || value->y_len != heatmap->y_len ||
+            memcmp(value->x_buckets, heatmap->x_buckets, x_bytes) ||
+            memcmp(value->y_buckets, heatmap->y_buckets, y_bytes))
+    {
+        optics_fail("mismatched heatmap buckets");
+        return optics_err;
+    }
+
+    size_t cells = lens_heatmap_cells(heatmap->x_len, heatmap->y_len);
+    atomic_size_t *src = &heatmap->counts[epoch * cells];
+
+    // Each cell must be reset with an atomic exchange to avoid losing
+    // concurrent increments but the merge itself is a plain loop over the
+    // flat matrix which vectorizes.
+    size_t counts[lens_heatmap_cells_max * lens_heatmap_cells_max];
+    for (size_t i = 0; i < cells; ++i)
+        counts[i] = atomic_exchange_explicit(&src[i], 0, memory_order_relaxed);
+
+    for (size_t i = 0; i < cells; ++i) value->counts[i] += counts[i];
+
+    return optics_ok;
+}
+
+static size_t lens_heatmap_key_push(
+        struct optics_key *key, const uint64_t *buckets, size_t len, size_t index)
+{
+    if (!index) return optics_key_push(key, "below");
+    if (index == len) return optics_key_push(key, "above");
+    return optics_key_pushf(key, "bucket_%lu_%lu", buckets[index - 1], buckets[index]);
+}
+
+static bool
+lens_heatmap_normalize(
+        const struct optics_poll *poll, optics_normalize_cb_t cb, void *ctx)
+{
+    const struct optics_heatmap *heatmap = &poll->value.heatmap;
+
+    struct optics_key key = {0};
+    optics_key_push(&key, poll->key);
+
+    for (size_t x = 0; x <= heatmap->x_len; ++x) {
+        size_t x_old = lens_heatmap_key_push(&key, heatmap->x_buckets, heatmap->x_len, x);
+
+        for (size_t y = 0; y <= heatmap->y_len; ++y) {
+            size_t y_old = lens_heatmap_key_push(&key, heatmap->y_buckets, heatmap->y_len, y);
+
+            size_t count = heatmap->counts[x * (heatmap->y_len + 1) + y];
+            bool ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, count));
+
+            optics_key_pop(&key, y_old);
+            if (!ret) return false;
+        }
+
+        optics_key_pop(&key, x_old);
+    }
+
+    return true;
+}
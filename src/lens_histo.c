@@ -14,14 +14,55 @@ struct optics_packed lens_histo_epoch
     atomic_size_t counts[optics_histo_buckets_max];
 };
 
+struct optics_packed lens_histo_stripe
+{
+    struct lens_histo_epoch epochs[2];
+    uint8_t padding[32];
+};
+
+static_assert(sizeof(struct lens_histo_stripe) % 64 == 0,
+        "histo stripes should not share cache lines");
+
 struct optics_packed lens_histo
 {
     struct lens_histo_epoch epochs[2];
 
     uint64_t buckets[optics_histo_buckets_max + 1];
     size_t buckets_len;
+    size_t stripes;
+    bool exemplars;
+
+    // Only allocated for striped histos. The padding keeps the stripes aligned
+    // on cache lines which is what the lens header is aligned on.
+    uint8_t padding[7];
+    struct lens_histo_stripe stripe[];
 };
 
+static_assert(sizeof(struct lens_histo) % 64 == 0,
+        "histo stripes should be aligned on a cache line");
+
+// Exemplars are only allocated if requested and are stored after the stripes
+// as one tag per bucket and epoch in the layout of lens_histo_index. A tag of
+// 0 means that no tagged value was seen. Stripes share the tags since a tag is
+// only written once per bucket and epoch.
+typedef atomic_uint_fast64_t lens_histo_exemplars_t[optics_histo_buckets_max + 2];
+
+static size_t lens_histo_len(size_t stripes)
+{
+    if (!stripes) return offsetof(struct lens_histo, padding);
+    return sizeof(struct lens_histo) + stripes * sizeof(struct lens_histo_stripe);
+}
+
+static atomic_uint_fast64_t *
+lens_histo_exemplars(struct lens_histo *histo, optics_epoch_t epoch)
+{
+    if (!histo->exemplars) return NULL;
+
+    lens_histo_exemplars_t *exemplars =
+        (void *) ((uint8_t *) histo + lens_histo_len(histo->stripes));
+    return exemplars[epoch];
+}
+
 
 // -----------------------------------------------------------------------------
 // impl
@@ -30,7 +71,8 @@ struct optics_packed lens_histo
 static struct lens *
 lens_histo_alloc(
         struct optics *optics, const char *name,
-        const uint64_t *buckets, size_t buckets_len)
+        const uint64_t *buckets, size_t buckets_len,
+        size_t stripes, bool exemplars)
 {
     if (buckets_len < 2) {
         optics_fail("invalid histo bucket length '%lu' < '2'", buckets_len);
@@ -51,12 +93,17 @@ lens_histo_alloc(
         }
     }
 
-    struct lens *lens = lens_alloc(optics, optics_histo, sizeof(struct lens_histo), name);
+    size_t len = lens_histo_len(stripes);
+    if (exemplars) len += 2 * sizeof(lens_histo_exemplars_t);
+
+    struct lens *lens = lens_alloc(optics, optics_histo, len, name);
     if (!lens) goto fail_alloc;
 
     struct lens_histo *histo = lens_sub_ptr(lens, optics_histo);
     if (!histo) goto fail_sub;
 
+    histo->stripes = stripes;
+    histo->exemplars = exemplars;
     histo->buckets_len = buckets_len;
     memcpy(histo->buckets, buckets, buckets_len * sizeof(histo->buckets[0]));
 
@@ -69,26 +116,42 @@ lens_histo_alloc(
     return NULL;
 }
 
-static bool
-lens_histo_inc(struct optics_lens *lens, optics_epoch_t epoch, double value)
+// Only the first tag of an epoch is kept which means that the CAS is attempted
+// at most once per bucket and epoch. Every other tagged value pays for a relaxed
+// load of a cache line that is already owned by the counter increment.
+static inline void lens_histo_exemplar(atomic_uint_fast64_t *slot, uint64_t exemplar)
 {
-    (void) epoch;
+    if (atomic_load_explicit(slot, memory_order_relaxed)) return;
 
-    struct lens_histo *histo = lens_sub_ptr(lens->lens, optics_histo);
-    if (!histo) return false;
+    uint_fast64_t expected = 0;
+    atomic_compare_exchange_strong_explicit(
+            slot, &expected, exemplar, memory_order_relaxed, memory_order_relaxed);
+}
+
+static void
+lens_histo_inc_typed(
+        struct lens_histo *histo, optics_epoch_t epoch, double value, uint64_t exemplar)
+{
+    struct lens_histo_epoch *counters = &histo->epochs[epoch];
+    if (histo->stripes)
+        counters = &histo->stripe[lens_stripe(histo->stripes)].epochs[epoch];
 
+    size_t index = 0;
     atomic_size_t *bucket = NULL;
 
     if (value < histo->buckets[0])
-        bucket = &histo->epochs[epoch].below;
+        bucket = &counters->below;
 
-    else if (value >= histo->buckets[histo->buckets_len - 1])
-        bucket = &histo->epochs[epoch].above;
+    else if (value >= histo->buckets[histo->buckets_len - 1]) {
+        index = histo->buckets_len;
+        bucket = &counters->above;
+    }
 
     else {
         for (size_t i = 1; i < histo->buckets_len; ++i) {
             if (value < histo->buckets[i]) {
-                bucket = &histo->epochs[epoch].counts[i - 1];
+                index = i;
+                bucket = &counters->counts[i - 1];
                 break;
             }
         }
@@ -97,9 +160,136 @@ lens_histo_inc(struct optics_lens *lens, optics_epoch_t epoch, double value)
     optics_assert(!!bucket, "value outside of all bucket ranges");
 
     atomic_fetch_add_explicit(bucket, 1, memory_order_relaxed);
+
+    if (exemplar && histo->exemplars)
+        lens_histo_exemplar(&lens_histo_exemplars(histo, epoch)[index], exemplar);
+}
+
+static bool
+lens_histo_inc(
+        struct optics_lens *lens, optics_epoch_t epoch, double value, uint64_t exemplar)
+{
+    struct lens_histo *histo = lens_sub_ptr(lens->lens, optics_histo);
+    if (!histo) return false;
+
+    lens_histo_inc_typed(histo, epoch, value, exemplar);
+    return true;
+}
+
+// Index in the [below, counts..., above] layout used by the batch API. Since the
+// buckets are sorted, the index is the number of bucket bounds that are less
+// than or equal to the value.
+static size_t
+lens_histo_index(const uint64_t *buckets, size_t buckets_len, double value)
+{
+    size_t index = 0;
+    for (size_t i = 0; i < buckets_len; ++i)
+        index += value >= buckets[i];
+    return index;
+}
+
+static bool
+lens_histo_buckets(struct optics_lens *lens, uint64_t *buckets, size_t *buckets_len)
+{
+    struct lens_histo *histo = lens_sub_ptr(lens->lens, optics_histo);
+    if (!histo) return false;
+
+    *buckets_len = histo->buckets_len;
+    memcpy(buckets, histo->buckets, histo->buckets_len * sizeof(histo->buckets[0]));
+    return true;
+}
+
+// Counts use the same layout as lens_histo_index.
+static void
+lens_histo_add(struct lens_histo *histo, optics_epoch_t epoch, const size_t *counts)
+{
+    struct lens_histo_epoch *counters = &histo->epochs[epoch];
+    if (histo->stripes)
+        counters = &histo->stripe[lens_stripe(histo->stripes)].epochs[epoch];
+
+    size_t last = histo->buckets_len;
+    if (counts[0])
+        atomic_fetch_add_explicit(&counters->below, counts[0], memory_order_relaxed);
+    if (counts[last])
+        atomic_fetch_add_explicit(&counters->above, counts[last], memory_order_relaxed);
+
+    for (size_t i = 1; i < last; ++i) {
+        if (!counts[i]) continue;
+        atomic_fetch_add_explicit(
+                &counters->counts[i - 1], counts[i], memory_order_relaxed);
+    }
+}
+
+static bool
+lens_histo_commit(struct optics_lens *lens, optics_epoch_t epoch, const size_t *counts)
+{
+    struct lens_histo *histo = lens_sub_ptr(lens->lens, optics_histo);
+    if (!histo) return false;
+
+    lens_histo_add(histo, epoch, counts);
+    return true;
+}
+
+// Since the buckets are sorted, the number of values in a bucket is the number of
+// values above its lower bound minus the number above its upper bound. Counting
+// the values above each bound is a branch-free reduction that vectorizes well.
+static bool
+lens_histo_inc_n(
+        struct optics_lens *lens, optics_epoch_t epoch, const double *values, size_t n)
+{
+    struct lens_histo *histo = lens_sub_ptr(lens->lens, optics_histo);
+    if (!histo) return false;
+
+    size_t above[optics_histo_buckets_max + 1] = {0};
+    for (size_t i = 0; i < histo->buckets_len; ++i) {
+        double bound = histo->buckets[i];
+
+        size_t count = 0;
+        for (size_t j = 0; j < n; ++j) count += values[j] >= bound;
+        above[i] = count;
+    }
+
+    size_t last = histo->buckets_len;
+    size_t counts[optics_histo_buckets_max + 2];
+
+    counts[0] = n - above[0];
+    for (size_t i = 1; i < last; ++i) counts[i] = above[i - 1] - above[i];
+    counts[last] = above[last - 1];
+
+    lens_histo_add(histo, epoch, counts);
     return true;
 }
 
+static void
+lens_histo_read_epoch(
+        struct lens_histo_epoch *counters,
+        size_t buckets_len,
+        size_t sampling,
+        struct optics_histo *value)
+{
+    value->below +=
+        atomic_exchange_explicit(&counters->below, 0, memory_order_relaxed) * sampling;
+    value->above +=
+        atomic_exchange_explicit(&counters->above, 0, memory_order_relaxed) * sampling;
+    for (size_t i = 0; i < buckets_len - 1; ++i) {
+        value->counts[i] +=
+            atomic_exchange_explicit(&counters->counts[i], 0, memory_order_relaxed) * sampling;
+    }
+}
+
+// Same first-wins policy as the write path across regions.
+static void
+lens_histo_read_exemplars(
+        atomic_uint_fast64_t *exemplars, size_t buckets_len, struct optics_histo *value)
+{
+    for (size_t i = 0; i <= buckets_len; ++i) {
+        if (!atomic_load_explicit(&exemplars[i], memory_order_relaxed)) continue;
+
+        uint64_t exemplar = atomic_exchange_explicit(&exemplars[i], 0, memory_order_relaxed);
+        if (!value->exemplars[i]) value->exemplars[i] = exemplar;
+    }
+}
+
 static enum optics_ret
 lens_histo_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_histo *value)
 {
@@ -118,12 +308,16 @@ lens_histo_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_hi
             if (histo->buckets[i] != value->buckets[i]) return optics_err;
     }
 
-    struct lens_histo_epoch *counters = &histo->epochs[epoch];
-    value->below += atomic_exchange_explicit(&counters->below, 0, memory_order_relaxed);
-    value->above += atomic_exchange_explicit(&counters->above, 0, memory_order_relaxed);
-    for (size_t i = 0; i < histo->buckets_len - 1; ++i) {
-        value->counts[i] +=
-            atomic_exchange_explicit(&counters->counts[i], 0, memory_order_relaxed);
+    size_t sampling = lens_sampling(lens->lens);
+    lens_histo_read_epoch(&histo->epochs[epoch], histo->buckets_len, sampling, value);
+    for (size_t i = 0; i < histo->stripes; ++i) {
+        lens_histo_read_epoch(
+                &histo->stripe[i].epochs[epoch], histo->buckets_len, sampling, value);
+    }
+
+    if (histo->exemplars) {
+        lens_histo_read_exemplars(
+                lens_histo_exemplars(histo, epoch), histo->buckets_len, value);
     }
 
     return optics_ok;
@@ -158,5 +352,24 @@ lens_histo_normalize(
         if (!ret) return false;
     }
 
+    // Tags go in the key like the topk items as they can't be represented
+    // exactly by the value.
+    for (size_t i = 0; i <= histo->buckets_len; ++i) {
+        if (!histo->exemplars[i]) continue;
+
+        old = optics_key_push(&key, "exemplar");
+        if (!i) optics_key_push(&key, "below");
+        else if (i == histo->buckets_len) optics_key_push(&key, "above");
+        else {
+            optics_key_pushf(
+                    &key, "bucket_%lu_%lu", histo->buckets[i - 1], histo->buckets[i]);
+        }
+        optics_key_pushf(&key, "%lu", histo->exemplars[i]);
+
+        ret = cb(ctx, poll->ts, key.data, 1);
+        optics_key_pop(&key, old);
+        if (!ret) return false;
+    }
+
     return true;
 }
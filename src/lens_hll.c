@@ -0,0 +1,187 @@
+/* lens_hll.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+// Registers are packed 8 to a word which lets the reader reset an epoch with one
+// exchange per word instead of one per register.
+enum { lens_hll_word_registers = sizeof(uint64_t) };
+
+struct optics_packed lens_hll
+{
+    size_t precision;
+    atomic_uint_fast64_t words[]; // 2 epochs of 2^precision registers.
+};
+
+
+// -----------------------------------------------------------------------------
+// registers
+// -----------------------------------------------------------------------------
+
+static size_t lens_hll_words(size_t precision)
+{
+    return (1UL << precision) / lens_hll_word_registers;
+}
+
+// Finalizer of murmur3 which makes sure that every bit of the value affects the
+// register index and rank. Values like sequential ids would otherwise all land
+// in the same few registers.
+static inline uint64_t lens_hll_hash(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdUL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53UL;
+    value ^= value >> 33;
+    return value;
+}
+
+// The top precision bits of the hash select the register and the position of
+// the first set bit in the remaining bits is the rank.
+static inline void
+lens_hll_register(size_t precision, uint64_t hash, size_t *index, uint8_t *rank)
+{
+    *index = hash >> (64 - precision);
+
+    uint64_t rest = hash << precision;
+    *rank = rest ? clz(rest) + 1 : 64 - precision + 1;
+}
+
+static double lens_hll_alpha(size_t registers)
+{
+    switch (registers) {
+    case 16: return 0.673;
+    case 32: return 0.697;
+    case 64: return 0.709;
+    default: return 0.7213 / (1.0 + 1.079 / registers);
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// impl
+// -----------------------------------------------------------------------------
+
+static struct lens *
+lens_hll_alloc(struct optics *optics, const char *name, size_t precision)
+{
+    if (precision < optics_hll_precision_min || precision > optics_hll_precision_max) {
+        optics_fail("invalid hll precision '%lu' not in [%d, %d]",
+                precision, optics_hll_precision_min, optics_hll_precision_max);
+        return NULL;
+    }
+
+    size_t len = sizeof(struct lens_hll) + 2 * lens_hll_words(precision) * sizeof(uint64_t);
+    struct lens *lens = lens_alloc(optics, optics_hll, len, name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_hll *hll = lens_sub_ptr(lens, optics_hll);
+    if (!hll) goto fail_sub;
+
+    hll->precision = precision;
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+static void
+lens_hll_record_typed(struct lens_hll *hll, optics_epoch_t epoch, uint64_t value)
+{
+    size_t index;
+    uint8_t rank;
+    lens_hll_register(hll->precision, lens_hll_hash(value), &index, &rank);
+
+    atomic_uint_fast64_t *word =
+        &hll->words[epoch * lens_hll_words(hll->precision) + index / lens_hll_word_registers];
+    size_t shift = (index % lens_hll_word_registers) * 8;
+
+    // Registers saturate quickly so the CAS is rarely reached once an epoch is
+    // warmed up.
+    uint64_t old = atomic_load_explicit(word, memory_order_relaxed);
+    while (((old >> shift) & 0xFF) < rank) {
+        uint64_t new = (old & ~(0xFFUL << shift)) | ((uint64_t) rank << shift);
+        if (atomic_compare_exchange_weak_explicit(word, &old, new,
+                        memory_order_relaxed, memory_order_relaxed))
+            break;
+    }
+}
+
+static bool
+lens_hll_record(struct optics_lens *lens, optics_epoch_t epoch, uint64_t value)
+{
+    struct lens_hll *hll = lens_sub_ptr(lens->lens, optics_hll);
+    if (!hll) return false;
+
+    lens_hll_record_typed(hll, epoch, value);
+    return true;
+}
+
+static enum optics_ret
+lens_hll_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_hll *value)
+{
+    struct lens_hll *hll = lens_sub_ptr(lens->lens, optics_hll);
+    if (!hll) return optics_err;
+
+    if (!value->precision) value->precision = hll->precision;
+    else if (value->precision != hll->precision) {
+        optics_fail("mismatched hll precision '%lu' != '%lu'",
+                value->precision, hll->precision);
+        return optics_err;
+    }
+
+    size_t words = lens_hll_words(hll->precision);
+    atomic_uint_fast64_t *src = &hll->words[epoch * words];
+
+    // The union of two sets is the element-wise max of their registers.
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t word = atomic_exchange_explicit(&src[i], 0, memory_order_relaxed);
+        uint8_t *dst = &value->registers[i * lens_hll_word_registers];
+
+        for (size_t j = 0; j < lens_hll_word_registers; ++j) {
+            uint8_t rank = word >> (j * 8);
+            if (rank > dst[j]) dst[j] = rank;
+        }
+    }
+
+    return optics_ok;
+}
+
+static double lens_hll_estimate(const struct optics_hll *hll)
+{
+    if (!hll->precision) return 0;
+
+    size_t registers = 1UL << hll->precision;
+
+    size_t zeros = 0;
+    double sum = 0;
+    for (size_t i = 0; i < registers; ++i) {
+        sum += ldexp(1.0, -hll->registers[i]);
+        zeros += !hll->registers[i];
+    }
+
+    double estimate = lens_hll_alpha(registers) * registers * registers / sum;
+
+    // Small range correction which falls back to linear counting while there
+    // are still empty registers. With a 64 bits hash there's no need for a large
+    // range correction.
+    if (estimate <= 2.5 * registers && zeros)
+        estimate = registers * log((double) registers / zeros);
+
+    return estimate;
+}
+
+static bool
+lens_hll_normalize(
+        const struct optics_poll *poll, optics_normalize_cb_t cb, void *ctx)
+{
+    return cb(ctx, poll->ts, poll->key, lens_hll_estimate(&poll->value.hll));
+}
@@ -0,0 +1,88 @@
+/* lens_meter.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+// Only the counts live in the region. The moving averages are maintained by
+// the poller from the merged counts so that reads don't modify the region.
+struct optics_packed lens_meter
+{
+    atomic_int_fast64_t counters[2];
+};
+
+
+// -----------------------------------------------------------------------------
+// impl
+// -----------------------------------------------------------------------------
+
+static struct lens *
+lens_meter_alloc(struct optics *optics, const char *name)
+{
+    return lens_alloc(optics, optics_meter, sizeof(struct lens_meter), name);
+}
+
+static void
+lens_meter_mark_typed(struct lens_meter *meter, optics_epoch_t epoch, int64_t count)
+{
+    atomic_fetch_add_explicit(&meter->counters[epoch], count, memory_order_relaxed);
+}
+
+static bool
+lens_meter_mark(struct optics_lens *lens, optics_epoch_t epoch, int64_t count)
+{
+    struct lens_meter *meter = lens_sub_ptr(lens->lens, optics_meter);
+    if (!meter) return false;
+
+    lens_meter_mark_typed(meter, epoch, count);
+    return true;
+}
+
+static enum optics_ret
+lens_meter_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_meter *value)
+{
+    struct lens_meter *meter = lens_sub_ptr(lens->lens, optics_meter);
+    if (!meter) return optics_err;
+
+    value->count += atomic_exchange_explicit(&meter->counters[epoch], 0, memory_order_relaxed);
+    return optics_ok;
+}
+
+static bool
+lens_meter_normalize(
+        const struct optics_poll *poll, optics_normalize_cb_t cb, void *ctx)
+{
+    bool ret = false;
+    size_t old;
+
+    const struct optics_meter *meter = &poll->value.meter;
+
+    struct optics_key key = {0};
+    optics_key_push(&key, poll->key);
+
+    old = optics_key_push(&key, "count");
+    ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, meter->count));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    old = optics_key_push(&key, "rate_1");
+    ret = cb(ctx, poll->ts, key.data, meter->rate_1);
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    old = optics_key_push(&key, "rate_5");
+    ret = cb(ctx, poll->ts, key.data, meter->rate_5);
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    old = optics_key_push(&key, "rate_15");
+    ret = cb(ctx, poll->ts, key.data, meter->rate_15);
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    return true;
+}
@@ -7,6 +7,21 @@
 // struct
 // -----------------------------------------------------------------------------
 
+// Each stripe runs its own estimator starting from the shared multiplier and
+// only ever adjusts its own delta. The deltas are folded back into the shared
+// multiplier when the lens is read which means that writers on different cpus
+// never touch the same cache line.
+struct optics_packed lens_quantile_stripe
+{
+    atomic_int_fast64_t delta;
+    atomic_size_t updates;
+    atomic_size_t count[2];
+    uint8_t padding[32];
+};
+
+static_assert(sizeof(struct lens_quantile_stripe) == 64,
+        "quantile stripes should each be on their own cache line");
+
 struct optics_packed lens_quantile
 {
      double target_quantile;
@@ -14,8 +29,17 @@ struct optics_packed lens_quantile
      double adjustment_value;
      atomic_int_fast64_t multiplier;
      atomic_int_fast64_t count[2];
+     size_t stripes;
+
+     // Only allocated for striped quantiles. The padding keeps the stripes
+     // aligned on cache lines which is what the lens header is aligned on.
+     uint8_t padding[8];
+     struct lens_quantile_stripe stripe[];
 };
 
+static_assert(sizeof(struct lens_quantile) == 64,
+        "quantile stripes should be aligned on a cache line");
+
 // -----------------------------------------------------------------------------
 // impl
 // -----------------------------------------------------------------------------
@@ -26,9 +50,14 @@ lens_quantile_alloc(
         const char *name,
         double target_quantile,
         double original_estimate,
-        double adjustment_value)
+        double adjustment_value,
+        size_t stripes)
 {
-    struct lens *lens = lens_alloc(optics, optics_quantile, sizeof(struct lens_quantile), name);
+    size_t len = offsetof(struct lens_quantile, padding);
+    if (stripes)
+        len = sizeof(struct lens_quantile) + stripes * sizeof(struct lens_quantile_stripe);
+
+    struct lens *lens = lens_alloc(optics, optics_quantile, len, name);
     if (!lens) goto fail_alloc;
 
     struct lens_quantile *quantile = lens_sub_ptr(lens, optics_quantile);
@@ -37,6 +66,7 @@ lens_quantile_alloc(
     quantile->target_quantile = target_quantile;
     quantile->original_estimate = original_estimate;
     quantile->adjustment_value = adjustment_value;
+    quantile->stripes = stripes;
 
     return lens;
 
@@ -55,11 +85,40 @@ static double calculate_quantile(struct lens_quantile *quantile)
     return quantile->original_estimate + adjustment;
 }
 
-static bool
-lens_quantile_update(struct optics_lens *lens, optics_epoch_t epoch, double value)
+static void
+lens_quantile_update_striped(
+        struct lens_quantile *quantile, optics_epoch_t epoch, double value)
 {
-    struct lens_quantile *quantile = lens_sub_ptr(lens->lens, optics_quantile);
-    if (!quantile) return false;
+    struct lens_quantile_stripe *stripe = &quantile->stripe[lens_stripe(quantile->stripes)];
+
+    int64_t multiplier =
+        atomic_load_explicit(&quantile->multiplier, memory_order_relaxed) +
+        atomic_load_explicit(&stripe->delta, memory_order_relaxed);
+    double current_estimate =
+        quantile->original_estimate + multiplier * quantile->adjustment_value;
+    bool probability_check = rng_gen_prob(rng_global(), quantile->target_quantile);
+
+    if (value < current_estimate) {
+        if (!probability_check)
+            atomic_fetch_sub_explicit(&stripe->delta, 1, memory_order_relaxed);
+    }
+    else {
+        if (probability_check)
+            atomic_fetch_add_explicit(&stripe->delta, 1, memory_order_relaxed);
+    }
+
+    atomic_fetch_add_explicit(&stripe->updates, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stripe->count[epoch], 1, memory_order_relaxed);
+}
+
+static void
+lens_quantile_update_typed(
+        struct lens_quantile *quantile, optics_epoch_t epoch, double value)
+{
+    if (quantile->stripes) {
+        lens_quantile_update_striped(quantile, epoch, value);
+        return;
+    }
 
     double current_estimate = calculate_quantile(quantile);
     bool probability_check = rng_gen_prob(rng_global(), quantile->target_quantile);
@@ -76,10 +135,88 @@ lens_quantile_update(struct optics_lens *lens, optics_epoch_t epoch, double valu
     // Since we don't care too much how exact the count is (not used to modify
     // our estimates) then the write ordering doesn't matter so relaxed is fine.
     atomic_fetch_add_explicit(&quantile->count[epoch], 1, memory_order_relaxed);
+}
+
+static bool
+lens_quantile_update(struct optics_lens *lens, optics_epoch_t epoch, double value)
+{
+    struct lens_quantile *quantile = lens_sub_ptr(lens->lens, optics_quantile);
+    if (!quantile) return false;
 
+    lens_quantile_update_typed(quantile, epoch, value);
     return true;
 }
 
+// Adjustments to the multiplier are accumulated locally and published once at
+// the end which means that concurrent updates are only visible to the next call.
+static bool
+lens_quantile_update_n(
+        struct optics_lens *lens, optics_epoch_t epoch, const double *values, size_t n)
+{
+    struct lens_quantile *quantile = lens_sub_ptr(lens->lens, optics_quantile);
+    if (!quantile) return false;
+
+    struct lens_quantile_stripe *stripe = NULL;
+    if (quantile->stripes) stripe = &quantile->stripe[lens_stripe(quantile->stripes)];
+
+    struct rng *rng = rng_global();
+    int64_t multiplier = atomic_load_explicit(&quantile->multiplier, memory_order_relaxed);
+    if (stripe) multiplier += atomic_load_explicit(&stripe->delta, memory_order_relaxed);
+    int64_t delta = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        double current_estimate =
+            quantile->original_estimate + (multiplier + delta) * quantile->adjustment_value;
+        bool probability_check = rng_gen_prob(rng, quantile->target_quantile);
+
+        if (values[i] < current_estimate) {
+            if (!probability_check) delta--;
+        }
+        else {
+            if (probability_check) delta++;
+        }
+    }
+
+    if (stripe) {
+        if (delta) atomic_fetch_add_explicit(&stripe->delta, delta, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stripe->updates, n, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stripe->count[epoch], n, memory_order_relaxed);
+        return true;
+    }
+
+    if (delta)
+        atomic_fetch_add_explicit(&quantile->multiplier, delta, memory_order_relaxed);
+    atomic_fetch_add_explicit(&quantile->count[epoch], n, memory_order_relaxed);
+
+    return true;
+}
+
+// The stripes are independent estimators of the same quantile which started
+// from the same multiplier so they're merged by taking the mean of their deltas
+// weighted by the number of updates that went into each. With a single active
+// stripe this is equivalent to the unstriped estimator. A writer racing with
+// the fold can have its adjustment folded without its update being counted
+// which skews the weights by a negligible amount.
+static void lens_quantile_fold(struct lens_quantile *quantile)
+{
+    double sum = 0;
+    size_t total = 0;
+
+    for (size_t i = 0; i < quantile->stripes; ++i) {
+        struct lens_quantile_stripe *stripe = &quantile->stripe[i];
+
+        size_t updates = atomic_exchange_explicit(&stripe->updates, 0, memory_order_relaxed);
+        if (!updates) continue;
+
+        int64_t delta = atomic_exchange_explicit(&stripe->delta, 0, memory_order_relaxed);
+        sum += (double) delta * updates;
+        total += updates;
+    }
+
+    if (!total) return;
+    atomic_fetch_add_explicit(&quantile->multiplier, llround(sum / total), memory_order_relaxed);
+}
+
 static enum optics_ret
 lens_quantile_read(
         struct optics_lens *lens, optics_epoch_t epoch, struct optics_quantile *value)
@@ -87,8 +224,14 @@ lens_quantile_read(
     struct lens_quantile *quantile = lens_sub_ptr(lens->lens, optics_quantile);
     if (!quantile) return optics_err;
 
+    lens_quantile_fold(quantile);
+
     double sample = calculate_quantile(quantile);
     size_t count = atomic_exchange_explicit(&quantile->count[epoch], 0, memory_order_relaxed);
+    for (size_t i = 0; i < quantile->stripes; ++i) {
+        atomic_size_t *stripe = &quantile->stripe[i].count[epoch];
+        count += atomic_exchange_explicit(stripe, 0, memory_order_relaxed);
+    }
 
     if (!value->quantile) {
         value->quantile = quantile->target_quantile;
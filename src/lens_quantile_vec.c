@@ -0,0 +1,239 @@
+/* lens_quantile_vec.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+// Runs the estimator of lens_quantile for several target quantiles at once. The
+// probability checks of all the targets are made against a single random
+// number by precomputing the thresholds of rng_gen_prob which turns an update
+// into a short branchless loop over the targets.
+struct optics_packed lens_quantile_vec
+{
+    size_t len;
+    double original_estimate;
+    double adjustment_value;
+
+    double targets[optics_quantile_vec_len_max];
+    uint64_t thresholds[optics_quantile_vec_len_max];
+
+    atomic_int_fast64_t multipliers[optics_quantile_vec_len_max];
+    atomic_size_t count[2];
+};
+
+
+// -----------------------------------------------------------------------------
+// impl
+// -----------------------------------------------------------------------------
+
+static struct lens *
+lens_quantile_vec_alloc(
+        struct optics *optics,
+        const char *name,
+        const double *targets,
+        size_t len,
+        double original_estimate,
+        double adjustment_value)
+{
+    if (!len || len > optics_quantile_vec_len_max) {
+        optics_fail("invalid quantile vec length '%lu' not in [1, %d]",
+                len, optics_quantile_vec_len_max);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < len; ++i) {
+        if (targets[i] > 0 && targets[i] < 1) continue;
+
+        optics_fail("invalid quantile vec target '%g' not in ]0, 1[", targets[i]);
+        return NULL;
+    }
+
+    struct lens *lens = lens_alloc(
+            optics, optics_quantile_vec, sizeof(struct lens_quantile_vec), name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_quantile_vec *vec = lens_sub_ptr(lens, optics_quantile_vec);
+    if (!vec) goto fail_sub;
+
+    vec->len = len;
+    vec->original_estimate = original_estimate;
+    vec->adjustment_value = adjustment_value;
+
+    for (size_t i = 0; i < len; ++i) {
+        vec->targets[i] = targets[i];
+        vec->thresholds[i] = targets[i] * rng_max();
+    }
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+// Accumulates into deltas the adjustments of every target for the given value
+// and random number which is equivalent to one lens_quantile update per target.
+static inline void lens_quantile_vec_adjust(
+        const struct lens_quantile_vec *vec,
+        const int64_t *multipliers,
+        int64_t *deltas,
+        double value,
+        uint64_t rng)
+{
+    for (size_t i = 0; i < vec->len; ++i) {
+        double estimate = vec->original_estimate +
+            (multipliers[i] + deltas[i]) * vec->adjustment_value;
+
+        int64_t below = value < estimate;
+        int64_t hit = rng <= vec->thresholds[i];
+        deltas[i] += (hit & (below ^ 1)) - ((hit ^ 1) & below);
+    }
+}
+
+static void lens_quantile_vec_load(
+        struct lens_quantile_vec *vec, int64_t *multipliers)
+{
+    for (size_t i = 0; i < vec->len; ++i)
+        multipliers[i] = atomic_load_explicit(&vec->multipliers[i], memory_order_relaxed);
+}
+
+static void lens_quantile_vec_publish(
+        struct lens_quantile_vec *vec, optics_epoch_t epoch, const int64_t *deltas, size_t n)
+{
+    for (size_t i = 0; i < vec->len; ++i) {
+        if (!deltas[i]) continue;
+        atomic_fetch_add_explicit(&vec->multipliers[i], deltas[i], memory_order_relaxed);
+    }
+
+    atomic_fetch_add_explicit(&vec->count[epoch], n, memory_order_relaxed);
+}
+
+static void
+lens_quantile_vec_update_typed(
+        struct lens_quantile_vec *vec, optics_epoch_t epoch, double value)
+{
+    int64_t multipliers[optics_quantile_vec_len_max];
+    int64_t deltas[optics_quantile_vec_len_max] = {0};
+
+    lens_quantile_vec_load(vec, multipliers);
+    lens_quantile_vec_adjust(vec, multipliers, deltas, value, rng_gen(rng_global()));
+    lens_quantile_vec_publish(vec, epoch, deltas, 1);
+}
+
+static bool
+lens_quantile_vec_update(struct optics_lens *lens, optics_epoch_t epoch, double value)
+{
+    struct lens_quantile_vec *vec = lens_sub_ptr(lens->lens, optics_quantile_vec);
+    if (!vec) return false;
+
+    lens_quantile_vec_update_typed(vec, epoch, value);
+    return true;
+}
+
+// Same as lens_quantile_update_n: the adjustments are published once at the end
+// so concurrent updates are only visible to the next call.
+static bool
+lens_quantile_vec_update_n(
+        struct optics_lens *lens, optics_epoch_t epoch, const double *values, size_t n)
+{
+    struct lens_quantile_vec *vec = lens_sub_ptr(lens->lens, optics_quantile_vec);
+    if (!vec) return false;
+    if (!n) return true;
+
+    struct rng *rng = rng_global();
+    int64_t multipliers[optics_quantile_vec_len_max];
+    int64_t deltas[optics_quantile_vec_len_max] = {0};
+
+    lens_quantile_vec_load(vec, multipliers);
+    for (size_t i = 0; i < n; ++i)
+        lens_quantile_vec_adjust(vec, multipliers, deltas, values[i], rng_gen(rng));
+    lens_quantile_vec_publish(vec, epoch, deltas, n);
+
+    return true;
+}
+
+// Unlike lens_quantile, the samples of a source are kept or replaced as a whole
+// to keep the quantiles consistent with each other. Each source is kept with a
+// probability proportional to the number of values it represents.
+static enum optics_ret
+lens_quantile_vec_read(
+        struct optics_lens *lens, optics_epoch_t epoch, struct optics_quantile_vec *value)
+{
+    struct lens_quantile_vec *vec = lens_sub_ptr(lens->lens, optics_quantile_vec);
+    if (!vec) return optics_err;
+
+    size_t targets_len = vec->len * sizeof(vec->targets[0]);
+    if (!value->len) {
+        value->len = vec->len;
+        memcpy(value->quantiles, vec->targets, targets_len);
+    }
+    else if (value->len != vec->len || memcmp(value->quantiles, vec->targets, targets_len)) {
+        optics_fail("mismatched quantile vec targets");
+        return optics_err;
+    }
+
+    size_t count = atomic_exchange_explicit(&vec->count[epoch], 0, memory_order_relaxed);
+
+    bool pick = !value->count ||
+        rng_gen_prob(rng_global(), (double) count / (value->count + count));
+
+    if (pick) {
+        int64_t multipliers[optics_quantile_vec_len_max];
+        lens_quantile_vec_load(vec, multipliers);
+
+        for (size_t i = 0; i < vec->len; ++i) {
+            value->samples[i] =
+                vec->original_estimate + multipliers[i] * vec->adjustment_value;
+        }
+    }
+    value->count += count;
+
+    return optics_ok;
+}
+
+// Quantiles are named after their percentile with the decimal point dropped
+// (e.g. 0.999 -> p999).
+static size_t lens_quantile_vec_key_push(struct optics_key *key, double quantile)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%g", quantile * 100);
+
+    char name[sizeof(buffer) + 1] = { 'p' };
+    for (size_t i = 0, j = 1; buffer[i]; ++i) {
+        if (buffer[i] != '.') name[j++] = buffer[i];
+    }
+
+    return optics_key_push(key, name);
+}
+
+static bool
+lens_quantile_vec_normalize(
+        const struct optics_poll *poll, optics_normalize_cb_t cb, void *ctx)
+{
+    bool ret = false;
+    size_t old;
+
+    const struct optics_quantile_vec *vec = &poll->value.quantile_vec;
+
+    struct optics_key key = {0};
+    optics_key_push(&key, poll->key);
+
+    old = optics_key_push(&key, "count");
+    ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, vec->count));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    for (size_t i = 0; i < vec->len; ++i) {
+        old = lens_quantile_vec_key_push(&key, vec->quantiles[i]);
+        ret = cb(ctx, poll->ts, key.data, vec->samples[i]);
+        optics_key_pop(&key, old);
+        if (!ret) return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,216 @@
+/* lens_sketch.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+struct optics_packed lens_sketch_epoch
+{
+    atomic_size_t counts[optics_sketch_buckets_max];
+};
+
+struct optics_packed lens_sketch
+{
+    double alpha;
+    double lowest;
+
+    // Cached to keep the record path down to a log, a multiply and an add.
+    double log_lowest;
+    double multiplier;
+
+    struct lens_sketch_epoch epochs[2];
+};
+
+
+// -----------------------------------------------------------------------------
+// buckets
+// -----------------------------------------------------------------------------
+
+// Bucket i covers ]lowest * gamma^(i-1), lowest * gamma^i] where gamma is
+// (1 + alpha) / (1 - alpha) which bounds the relative error of any value
+// returned for that bucket to alpha. The first and last bucket respectively
+// collapse everything below and above the range covered by the bucket budget
+// and don't offer any guarantees.
+
+static double lens_sketch_gamma(double alpha)
+{
+    return (1 + alpha) / (1 - alpha);
+}
+
+static inline size_t lens_sketch_index(const struct lens_sketch *sketch, double value)
+{
+    // Also takes care of NaNs.
+    if (!(value > sketch->lowest)) return 0;
+
+    double index = ceil((log(value) - sketch->log_lowest) * sketch->multiplier);
+    return index < optics_sketch_buckets_max - 1 ? index : optics_sketch_buckets_max - 1;
+}
+
+static double lens_sketch_value(const struct optics_sketch *sketch, size_t index)
+{
+    if (!index) return sketch->lowest;
+
+    double gamma = lens_sketch_gamma(sketch->alpha);
+    return sketch->lowest * pow(gamma, index) * (2 / (gamma + 1));
+}
+
+
+// -----------------------------------------------------------------------------
+// impl
+// -----------------------------------------------------------------------------
+
+static struct lens *
+lens_sketch_alloc(struct optics *optics, const char *name, double alpha, double lowest)
+{
+    if (!(alpha > 0 && alpha < 1)) {
+        optics_fail("invalid sketch alpha '%g' not in ]0, 1[", alpha);
+        return NULL;
+    }
+
+    if (!(lowest > 0)) {
+        optics_fail("invalid sketch lowest value '%g' <= 0", lowest);
+        return NULL;
+    }
+
+    struct lens *lens = lens_alloc(optics, optics_sketch, sizeof(struct lens_sketch), name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_sketch *sketch = lens_sub_ptr(lens, optics_sketch);
+    if (!sketch) goto fail_sub;
+
+    sketch->alpha = alpha;
+    sketch->lowest = lowest;
+    sketch->log_lowest = log(lowest);
+    sketch->multiplier = 1 / log(lens_sketch_gamma(alpha));
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+static void
+lens_sketch_record_typed(struct lens_sketch *sketch, optics_epoch_t epoch, double value)
+{
+    size_t index = lens_sketch_index(sketch, value);
+    atomic_fetch_add_explicit(
+            &sketch->epochs[epoch].counts[index], 1, memory_order_relaxed);
+}
+
+static bool
+lens_sketch_record(struct optics_lens *lens, optics_epoch_t epoch, double value)
+{
+    struct lens_sketch *sketch = lens_sub_ptr(lens->lens, optics_sketch);
+    if (!sketch) return false;
+
+    lens_sketch_record_typed(sketch, epoch, value);
+    return true;
+}
+
+static bool
+lens_sketch_record_n(
+        struct optics_lens *lens, optics_epoch_t epoch, const double *values, size_t n)
+{
+    struct lens_sketch *sketch = lens_sub_ptr(lens->lens, optics_sketch);
+    if (!sketch) return false;
+
+    size_t counts[optics_sketch_buckets_max] = {0};
+    for (size_t i = 0; i < n; ++i)
+        counts[lens_sketch_index(sketch, values[i])]++;
+
+    struct lens_sketch_epoch *counters = &sketch->epochs[epoch];
+    for (size_t i = 0; i < optics_sketch_buckets_max; ++i) {
+        if (!counts[i]) continue;
+        atomic_fetch_add_explicit(&counters->counts[i], counts[i], memory_order_relaxed);
+    }
+
+    return true;
+}
+
+static enum optics_ret
+lens_sketch_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_sketch *value)
+{
+    struct lens_sketch *sketch = lens_sub_ptr(lens->lens, optics_sketch);
+    if (!sketch) return optics_err;
+
+    if (!value->alpha) {
+        value->alpha = sketch->alpha;
+        value->lowest = sketch->lowest;
+    }
+    else if (value->alpha != sketch->alpha || value->lowest != sketch->lowest) {
+        optics_fail("mismatched sketch config '%g:%g' != '%g:%g'",
+                value->alpha, value->lowest, sketch->alpha, sketch->lowest);
+        return optics_err;
+    }
+
+    // Buckets line up exactly across sketches with the same config so merging
+    // is a simple sum.
+    struct lens_sketch_epoch *counters = &sketch->epochs[epoch];
+    for (size_t i = 0; i < optics_sketch_buckets_max; ++i) {
+        value->counts[i] +=
+            atomic_exchange_explicit(&counters->counts[i], 0, memory_order_relaxed);
+    }
+
+    return optics_ok;
+}
+
+static size_t lens_sketch_count(const struct optics_sketch *sketch)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < optics_sketch_buckets_max; ++i) count += sketch->counts[i];
+    return count;
+}
+
+static double lens_sketch_percentile(const struct optics_sketch *sketch, double percentile)
+{
+    size_t count = lens_sketch_count(sketch);
+    if (!count) return 0;
+
+    size_t rank = (count * percentile) / 100;
+    if (rank >= count) rank = count - 1;
+
+    size_t seen = 0;
+    for (size_t i = 0; i < optics_sketch_buckets_max; ++i) {
+        seen += sketch->counts[i];
+        if (seen > rank) return lens_sketch_value(sketch, i);
+    }
+
+    return lens_sketch_value(sketch, optics_sketch_buckets_max - 1);
+}
+
+static bool
+lens_sketch_normalize(
+        const struct optics_poll *poll, optics_normalize_cb_t cb, void *ctx)
+{
+    size_t old;
+    bool ret = false;
+    const struct optics_sketch *sketch = &poll->value.sketch;
+
+    struct optics_key key = {0};
+    optics_key_push(&key, poll->key);
+
+    old = optics_key_push(&key, "count");
+    ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, lens_sketch_count(sketch)));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    static const struct { const char *name; double percentile; } percentiles[] = {
+        { "p50", 50 }, { "p90", 90 }, { "p99", 99 }, { "p999", 99.9 },
+    };
+
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+        old = optics_key_push(&key, percentiles[i].name);
+        ret = cb(ctx, poll->ts, key.data,
+                lens_sketch_percentile(sketch, percentiles[i].percentile));
+        optics_key_pop(&key, old);
+        if (!ret) return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,226 @@
+/* lens_summary.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+// Doubles are stored as their bit patterns since C11 atomics don't provide
+// arithmetic on floating point types.
+struct optics_packed lens_summary_epoch
+{
+    atomic_uint_fast64_t count;
+    atomic_uint_fast64_t sum;
+    atomic_uint_fast64_t sumsq;
+    atomic_uint_fast64_t min;
+    atomic_uint_fast64_t max;
+};
+
+struct optics_packed lens_summary
+{
+    struct lens_summary_epoch epochs[2];
+};
+
+
+// -----------------------------------------------------------------------------
+// atomics
+// -----------------------------------------------------------------------------
+
+static inline void lens_summary_add(atomic_uint_fast64_t *dst, double value)
+{
+    uint64_t old = atomic_load_explicit(dst, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(dst, &old, pun_dtoi(pun_itod(old) + value),
+                    memory_order_relaxed, memory_order_relaxed));
+}
+
+// The common case is that the value doesn't change the bound so we avoid the
+// CAS entirely by checking first.
+static inline void lens_summary_min(atomic_uint_fast64_t *dst, double value)
+{
+    uint64_t old = atomic_load_explicit(dst, memory_order_relaxed);
+    while (value < pun_itod(old)) {
+        if (atomic_compare_exchange_weak_explicit(dst, &old, pun_dtoi(value),
+                        memory_order_relaxed, memory_order_relaxed))
+            break;
+    }
+}
+
+static inline void lens_summary_max(atomic_uint_fast64_t *dst, double value)
+{
+    uint64_t old = atomic_load_explicit(dst, memory_order_relaxed);
+    while (value > pun_itod(old)) {
+        if (atomic_compare_exchange_weak_explicit(dst, &old, pun_dtoi(value),
+                        memory_order_relaxed, memory_order_relaxed))
+            break;
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// impl
+// -----------------------------------------------------------------------------
+
+static void lens_summary_reset(struct lens_summary_epoch *summary)
+{
+    atomic_store_explicit(&summary->min, pun_dtoi(INFINITY), memory_order_relaxed);
+    atomic_store_explicit(&summary->max, pun_dtoi(-INFINITY), memory_order_relaxed);
+}
+
+static struct lens *
+lens_summary_alloc(struct optics *optics, const char *name)
+{
+    struct lens *lens = lens_alloc(optics, optics_summary, sizeof(struct lens_summary), name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_summary *summary = lens_sub_ptr(lens, optics_summary);
+    if (!summary) goto fail_sub;
+
+    for (size_t i = 0; i < 2; ++i) lens_summary_reset(&summary->epochs[i]);
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+static void
+lens_summary_record_typed(struct lens_summary *summary, optics_epoch_t epoch, double value)
+{
+    struct lens_summary_epoch *counters = &summary->epochs[epoch];
+
+    atomic_fetch_add_explicit(&counters->count, 1, memory_order_relaxed);
+    lens_summary_add(&counters->sum, value);
+    lens_summary_add(&counters->sumsq, value * value);
+    lens_summary_min(&counters->min, value);
+    lens_summary_max(&counters->max, value);
+}
+
+static bool
+lens_summary_record(struct optics_lens *lens, optics_epoch_t epoch, double value)
+{
+    struct lens_summary *summary = lens_sub_ptr(lens->lens, optics_summary);
+    if (!summary) return false;
+
+    lens_summary_record_typed(summary, epoch, value);
+    return true;
+}
+
+static bool
+lens_summary_record_n(
+        struct optics_lens *lens, optics_epoch_t epoch, const double *values, size_t n)
+{
+    struct lens_summary *summary = lens_sub_ptr(lens->lens, optics_summary);
+    if (!summary) return false;
+    if (!n) return true;
+
+    double sum = 0, sumsq = 0, min = INFINITY, max = -INFINITY;
+    for (size_t i = 0; i < n; ++i) {
+        sum += values[i];
+        sumsq += values[i] * values[i];
+        if (values[i] < min) min = values[i];
+        if (values[i] > max) max = values[i];
+    }
+
+    struct lens_summary_epoch *counters = &summary->epochs[epoch];
+
+    atomic_fetch_add_explicit(&counters->count, n, memory_order_relaxed);
+    lens_summary_add(&counters->sum, sum);
+    lens_summary_add(&counters->sumsq, sumsq);
+    lens_summary_min(&counters->min, min);
+    lens_summary_max(&counters->max, max);
+
+    return true;
+}
+
+static enum optics_ret
+lens_summary_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_summary *value)
+{
+    struct lens_summary *summary = lens_sub_ptr(lens->lens, optics_summary);
+    if (!summary) return optics_err;
+
+    struct lens_summary_epoch *counters = &summary->epochs[epoch];
+
+    uint64_t count = atomic_exchange_explicit(&counters->count, 0, memory_order_relaxed);
+    double sum = pun_itod(atomic_exchange_explicit(&counters->sum, 0, memory_order_relaxed));
+    double sumsq = pun_itod(atomic_exchange_explicit(&counters->sumsq, 0, memory_order_relaxed));
+    double min = pun_itod(atomic_exchange_explicit(
+                    &counters->min, pun_dtoi(INFINITY), memory_order_relaxed));
+    double max = pun_itod(atomic_exchange_explicit(
+                    &counters->max, pun_dtoi(-INFINITY), memory_order_relaxed));
+
+    if (!count) return optics_ok;
+
+    // The bounds of an empty value are meaningless so overwrite them.
+    if (!value->count) { value->min = min; value->max = max; }
+    else {
+        if (min < value->min) value->min = min;
+        if (max > value->max) value->max = max;
+    }
+
+    value->count += count;
+    value->sum += sum;
+    value->sumsq += sumsq;
+
+    return optics_ok;
+}
+
+static double lens_summary_mean(const struct optics_summary *summary)
+{
+    return summary->count ? summary->sum / summary->count : 0;
+}
+
+// Population standard deviation. Rounding errors can push the variance slightly
+// below zero when every value is identical.
+static double lens_summary_stddev(const struct optics_summary *summary)
+{
+    if (!summary->count) return 0;
+
+    double mean = lens_summary_mean(summary);
+    double variance = summary->sumsq / summary->count - mean * mean;
+    return variance > 0 ? sqrt(variance) : 0;
+}
+
+static bool
+lens_summary_normalize(
+        const struct optics_poll *poll, optics_normalize_cb_t cb, void *ctx)
+{
+    bool ret = false;
+    size_t old;
+
+    const struct optics_summary *summary = &poll->value.summary;
+
+    struct optics_key key = {0};
+    optics_key_push(&key, poll->key);
+
+    old = optics_key_push(&key, "count");
+    ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, summary->count));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    old = optics_key_push(&key, "mean");
+    ret = cb(ctx, poll->ts, key.data, lens_summary_mean(summary));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    old = optics_key_push(&key, "stddev");
+    ret = cb(ctx, poll->ts, key.data, lens_summary_stddev(summary));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    old = optics_key_push(&key, "min");
+    ret = cb(ctx, poll->ts, key.data, summary->min);
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    old = optics_key_push(&key, "max");
+    ret = cb(ctx, poll->ts, key.data, summary->max);
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    return true;
+}
@@ -0,0 +1,294 @@
+/* lens_topk.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+// Items are identified by their hash which is never 0 for a claimed slot. The
+// generation is odd while a writer changes the item of the slot or while a
+// reader copies it out. Incrementing an item that is already tracked doesn't
+// touch the generation.
+struct optics_packed lens_topk_slot
+{
+    atomic_size_t gen;
+    atomic_uint_fast64_t hash;
+    atomic_uint_fast64_t count;
+    char item[optics_topk_item_max_len];
+};
+
+struct optics_packed lens_topk_epoch
+{
+    struct lens_topk_slot slots[optics_topk_items_max];
+};
+
+struct optics_packed lens_topk
+{
+    size_t k;
+    struct lens_topk_epoch epochs[2];
+};
+
+static_assert(!(optics_topk_items_max & (optics_topk_items_max - 1)),
+        "optics_topk_items_max must be a power of 2");
+
+
+// -----------------------------------------------------------------------------
+// slots
+// -----------------------------------------------------------------------------
+
+static bool lens_topk_slot_lock(struct lens_topk_slot *slot)
+{
+    size_t gen = atomic_load_explicit(&slot->gen, memory_order_relaxed);
+    if (gen & 1) return false;
+
+    return atomic_compare_exchange_strong_explicit(&slot->gen, &gen, gen + 1,
+            memory_order_acquire, memory_order_relaxed);
+}
+
+static void lens_topk_slot_unlock(struct lens_topk_slot *slot)
+{
+    atomic_fetch_add_explicit(&slot->gen, 1, memory_order_release);
+}
+
+// Same bounded spin as lens_read_lock for slots held by straggling writers.
+static bool lens_topk_slot_read_lock(struct lens_topk_slot *slot)
+{
+    for (size_t i = 0; i < lens_read_spins; ++i) {
+        if (lens_topk_slot_lock(slot)) return true;
+    }
+    return false;
+}
+
+// Replaces the item of the slot if it's still identified by the expected hash.
+// Returns false if the slot changed or is locked in which case it must be
+// looked at again.
+static bool lens_topk_slot_claim(
+        struct lens_topk_slot *slot,
+        uint64_t expected,
+        uint64_t hash,
+        const char *item,
+        size_t len)
+{
+    if (!lens_topk_slot_lock(slot)) return false;
+
+    bool claimed = atomic_load_explicit(&slot->hash, memory_order_relaxed) == expected;
+    if (claimed) {
+        memcpy(slot->item, item, len + 1);
+        atomic_store_explicit(&slot->hash, hash, memory_order_release);
+    }
+
+    lens_topk_slot_unlock(slot);
+    return claimed;
+}
+
+
+// -----------------------------------------------------------------------------
+// impl
+// -----------------------------------------------------------------------------
+
+static struct lens *
+lens_topk_alloc(struct optics *optics, const char *name, size_t k)
+{
+    if (!k || k > optics_topk_items_max) {
+        optics_fail("invalid topk size '%lu' not in [1, %d]", k, optics_topk_items_max);
+        return NULL;
+    }
+
+    struct lens *lens = lens_alloc(optics, optics_topk, sizeof(struct lens_topk), name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_topk *topk = lens_sub_ptr(lens, optics_topk);
+    if (!topk) goto fail_sub;
+
+    topk->k = k;
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+// Items are hashed into an open addressed table where slots are never emptied
+// so a tracked item is always found before the first empty slot of its probe
+// sequence. Reads only reset the counts which leaves the items of the previous
+// intervals to be evicted first.
+//
+// Space-saving: an item that isn't tracked replaces the item with the lowest
+// count and inherits its count. Counts can therefore only be overestimated and
+// any item whose true count is above total / optics_topk_items_max is
+// guaranteed to be tracked.
+static void lens_topk_insert(
+        struct lens_topk_epoch *topk, uint64_t hash, const char *item, size_t len, uint64_t value)
+{
+    const size_t mask = optics_topk_items_max - 1;
+
+    while (true) {
+        struct lens_topk_slot *min = NULL;
+        uint64_t min_hash = 0;
+        uint64_t min_count = UINT64_MAX;
+
+        size_t i = 0;
+        for (; i < optics_topk_items_max; ++i) {
+            struct lens_topk_slot *slot = &topk->slots[(hash + i) & mask];
+            uint64_t slot_hash = atomic_load_explicit(&slot->hash, memory_order_acquire);
+
+            if (slot_hash == hash) {
+                atomic_fetch_add_explicit(&slot->count, value, memory_order_relaxed);
+                return;
+            }
+
+            if (!slot_hash) {
+                if (!lens_topk_slot_claim(slot, 0, hash, item, len)) break;
+                atomic_fetch_add_explicit(&slot->count, value, memory_order_relaxed);
+                return;
+            }
+
+            uint64_t count = atomic_load_explicit(&slot->count, memory_order_relaxed);
+            if (count < min_count) {
+                min = slot;
+                min_hash = slot_hash;
+                min_count = count;
+            }
+        }
+
+        // Another writer is claiming the empty slot, possibly for the same
+        // item, so we need to wait for it to settle before moving on.
+        if (i < optics_topk_items_max) continue;
+
+        if (lens_topk_slot_claim(min, min_hash, hash, item, len)) {
+            atomic_fetch_add_explicit(&min->count, value, memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+static bool lens_topk_inc_typed(
+        struct lens_topk *topk, optics_epoch_t epoch, const char *item, uint64_t value)
+{
+    size_t len = strnlen(item, optics_topk_item_max_len);
+    if (len == optics_topk_item_max_len) {
+        optics_fail("topk item '%.*s...' exceeds max length '%d'",
+                optics_topk_item_max_len - 1, item, optics_topk_item_max_len - 1);
+        return false;
+    }
+
+    uint64_t hash = htable_hash(item);
+    if (!hash) hash = 1;
+
+    lens_topk_insert(&topk->epochs[epoch], hash, item, len, value);
+    return true;
+}
+
+static bool lens_topk_inc(
+        struct optics_lens *lens, optics_epoch_t epoch, const char *item, uint64_t value)
+{
+    struct lens_topk *topk = lens_sub_ptr(lens->lens, optics_topk);
+    if (!topk) return false;
+
+    return lens_topk_inc_typed(topk, epoch, item, value);
+}
+
+// Merging two space-saving summaries sums the counts of common items and keeps
+// the largest counts if the union doesn't fit.
+static void lens_topk_merge(struct optics_topk *value, const struct optics_topk_item *entry)
+{
+    size_t min = 0;
+    for (size_t i = 0; i < value->len; ++i) {
+        struct optics_topk_item *item = &value->items[i];
+
+        if (!strcmp(item->item, entry->item)) {
+            item->count += entry->count;
+            return;
+        }
+
+        if (item->count < value->items[min].count) min = i;
+    }
+
+    struct optics_topk_item *item;
+    if (value->len < optics_topk_items_max) item = &value->items[value->len++];
+    else if (value->items[min].count < entry->count) item = &value->items[min];
+    else return;
+
+    item->count = entry->count;
+    memcpy(item->item, entry->item, sizeof(item->item));
+}
+
+// Insertion sort is plenty for the handful of items we track and keeps the
+// items ordered by decreasing count for the consumers of the value.
+static void lens_topk_sort(struct optics_topk *value)
+{
+    for (size_t i = 1; i < value->len; ++i) {
+        struct optics_topk_item item = value->items[i];
+
+        size_t j = i;
+        for (; j > 0 && value->items[j - 1].count < item.count; --j)
+            value->items[j] = value->items[j - 1];
+        value->items[j] = item;
+    }
+}
+
+static enum optics_ret
+lens_topk_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_topk *value)
+{
+    struct lens_topk *topk = lens_sub_ptr(lens->lens, optics_topk);
+    if (!topk) return optics_err;
+
+    if (!value->k) value->k = topk->k;
+
+    // Every slot is locked before any count is reset so that the value either
+    // covers the entire epoch or nothing at all.
+    struct lens_topk_epoch *counters = &topk->epochs[epoch];
+    for (size_t i = 0; i < optics_topk_items_max; ++i) {
+        if (lens_topk_slot_read_lock(&counters->slots[i])) continue;
+
+        while (i > 0) lens_topk_slot_unlock(&counters->slots[--i]);
+        return optics_busy;
+    }
+
+    // Locked slots only hold back item changes while tracked items keep being
+    // incremented so a straggling writer can't lose its count.
+    size_t len = 0;
+    struct optics_topk_item items[optics_topk_items_max];
+    for (size_t i = 0; i < optics_topk_items_max; ++i) {
+        struct lens_topk_slot *slot = &counters->slots[i];
+
+        uint64_t count = atomic_exchange_explicit(&slot->count, 0, memory_order_relaxed);
+        if (count) {
+            items[len].count = count;
+            memcpy(items[len].item, slot->item, sizeof(items[len].item));
+            len++;
+        }
+
+        lens_topk_slot_unlock(slot);
+    }
+
+    for (size_t i = 0; i < len; ++i) lens_topk_merge(value, &items[i]);
+    lens_topk_sort(value);
+
+    return optics_ok;
+}
+
+static bool
+lens_topk_normalize(
+        const struct optics_poll *poll, optics_normalize_cb_t cb, void *ctx)
+{
+    const struct optics_topk *topk = &poll->value.topk;
+
+    struct optics_key key = {0};
+    optics_key_push(&key, poll->key);
+
+    size_t len = topk->len < topk->k ? topk->len : topk->k;
+    for (size_t i = 0; i < len; ++i) {
+        size_t old = optics_key_push_sanitized(&key, topk->items[i].item);
+        bool ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, topk->items[i].count));
+        optics_key_pop(&key, old);
+        if (!ret) return false;
+    }
+
+    return true;
+}
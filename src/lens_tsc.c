@@ -0,0 +1,138 @@
+/* lens_tsc.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+
+// -----------------------------------------------------------------------------
+// struct
+// -----------------------------------------------------------------------------
+
+// Reading the tsc takes a handful of cycles so there's no point in tracking the
+// lowest few bits of a delta. The highest value covers several minutes on
+// modern cpus.
+static const size_t lens_tsc_precision = 2;
+static const uint64_t lens_tsc_lowest = 16;
+static const uint64_t lens_tsc_highest = 1UL << 40;
+
+// Recording is a plain hdr record of the cycles. The conversion to time units
+// is deferred to the poller which keeps floating point math and the
+// calibration off the recording path. The hdr follows the struct.
+struct optics_packed lens_tsc
+{
+    double scale;
+};
+
+static struct lens_hdr * lens_tsc_hdr(struct lens_tsc *tsc)
+{
+    return (struct lens_hdr *) (tsc + 1);
+}
+
+
+// -----------------------------------------------------------------------------
+// impl
+// -----------------------------------------------------------------------------
+
+static struct lens *
+lens_tsc_alloc(struct optics *optics, const char *name, double scale)
+{
+    if (!(scale > 0) || isinf(scale)) {
+        optics_fail("invalid tsc scale '%g'", scale);
+        return NULL;
+    }
+
+    size_t buckets_len = lens_hdr_check(lens_tsc_precision, lens_tsc_lowest, lens_tsc_highest);
+    optics_assert(buckets_len, "invalid tsc hdr config");
+
+    size_t len = sizeof(struct lens_tsc) + lens_hdr_len(buckets_len);
+    struct lens *lens = lens_alloc(optics, optics_tsc, len, name);
+    if (!lens) goto fail_alloc;
+
+    struct lens_tsc *tsc = lens_sub_ptr(lens, optics_tsc);
+    if (!tsc) goto fail_sub;
+
+    tsc->scale = scale;
+    lens_hdr_init(lens_tsc_hdr(tsc), lens_tsc_precision, lens_tsc_lowest, lens_tsc_highest);
+
+    return lens;
+
+  fail_sub:
+    lens_free(optics, lens);
+  fail_alloc:
+    return NULL;
+}
+
+static void
+lens_tsc_record_typed(struct lens_tsc *tsc, optics_epoch_t epoch, uint64_t cycles)
+{
+    lens_hdr_record_typed(lens_tsc_hdr(tsc), epoch, cycles);
+}
+
+static bool
+lens_tsc_record(struct optics_lens *lens, optics_epoch_t epoch, uint64_t cycles)
+{
+    struct lens_tsc *tsc = lens_sub_ptr(lens->lens, optics_tsc);
+    if (!tsc) return false;
+
+    lens_tsc_record_typed(tsc, epoch, cycles);
+    return true;
+}
+
+// Regions calibrate their tsc independently so lenses merged from multiple
+// regions will have slightly different scales. The differences are well below
+// the precision of the histogram so the first scale read wins.
+static enum optics_ret
+lens_tsc_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_tsc *value)
+{
+    struct lens_tsc *tsc = lens_sub_ptr(lens->lens, optics_tsc);
+    if (!tsc) return optics_err;
+
+    if (!value->scale) value->scale = tsc->scale;
+    return lens_hdr_read_typed(lens_tsc_hdr(tsc), epoch, &value->cycles);
+}
+
+static double lens_tsc_percentile(const struct optics_tsc *tsc, double percentile)
+{
+    return lens_hdr_percentile(&tsc->cycles, percentile) * tsc->scale;
+}
+
+static double lens_tsc_max(const struct optics_tsc *tsc)
+{
+    return tsc->cycles.max * tsc->scale;
+}
+
+static bool
+lens_tsc_normalize(
+        const struct optics_poll *poll, optics_normalize_cb_t cb, void *ctx)
+{
+    size_t old;
+    bool ret = false;
+    const struct optics_tsc *tsc = &poll->value.tsc;
+
+    struct optics_key key = {0};
+    optics_key_push(&key, poll->key);
+
+    old = optics_key_push(&key, "count");
+    ret = cb(ctx, poll->ts, key.data, lens_rescale(poll, lens_hdr_count(&tsc->cycles)));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    static const struct { const char *name; double percentile; } percentiles[] = {
+        { "p50", 50 }, { "p90", 90 }, { "p99", 99 }, { "p999", 99.9 },
+    };
+
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+        old = optics_key_push(&key, percentiles[i].name);
+        ret = cb(ctx, poll->ts, key.data,
+                lens_tsc_percentile(tsc, percentiles[i].percentile));
+        optics_key_pop(&key, old);
+        if (!ret) return false;
+    }
+
+    old = optics_key_push(&key, "max");
+    ret = cb(ctx, poll->ts, key.data, lens_tsc_max(tsc));
+    optics_key_pop(&key, old);
+    if (!ret) return false;
+
+    return true;
+}
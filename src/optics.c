@@ -4,6 +4,7 @@
 */
 
 #include "optics_priv.h"
+#include "optics_inline.h"
 #include "utils/compiler.h"
 #include "utils/errors.h"
 #include "utils/type_pun.h"
@@ -15,12 +16,14 @@
 #include "utils/bits.h"
 #include "utils/log.h"
 #include "utils/socket.h"
+#include "utils/thread.h"
 
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdatomic.h>
+#include <math.h>
 #include <bsd/string.h>
 
 #include <sys/mman.h>
@@ -48,7 +51,7 @@ static const size_t page_len = 4096UL;
 static const size_t cache_line_len = 64UL;
 
 static const uint64_t magic = 0x044b33f12afe7de0UL;
-static const uint64_t version = 2;
+static const uint64_t version = optics_inline_abi;
 
 
 // -----------------------------------------------------------------------------
@@ -96,6 +99,11 @@ struct optics_packed optics_header
 
     char prefix[optics_name_max_len];
 
+    // Nanoseconds per tsc tick stored as the bits of a double. Calibrating
+    // takes about a millisecond so it's deferred to the first lens that needs
+    // it and then shared with every process that opens the region.
+    atomic_uint_fast64_t tsc_nanos;
+
     struct alloc alloc;
 };
 
@@ -497,6 +505,16 @@ const char * optics_lens_name(struct optics_lens *l)
     return lens_name(l->lens);
 }
 
+bool optics_lens_set_sampling(struct optics_lens *l, size_t sampling)
+{
+    return lens_set_sampling(l->lens, sampling);
+}
+
+size_t optics_lens_sampling(struct optics_lens *l)
+{
+    return lens_sampling(l->lens);
+}
+
 
 // -----------------------------------------------------------------------------
 // counter
@@ -504,7 +522,7 @@ const char * optics_lens_name(struct optics_lens *l)
 
 struct optics_lens * optics_counter_alloc(struct optics *optics, const char *name)
 {
-    struct lens *counter = lens_counter_alloc(optics, name);
+    struct lens *counter = lens_counter_alloc(optics, name, 0);
     if (!counter) return NULL;
 
     struct optics_lens *lens = optics_lens_alloc(optics, counter);
@@ -516,7 +534,31 @@ struct optics_lens * optics_counter_alloc(struct optics *optics, const char *nam
 
 struct optics_lens * optics_counter_alloc_get(struct optics *optics, const char *name)
 {
-    struct lens *counter = lens_counter_alloc(optics, name);
+    struct lens *counter = lens_counter_alloc(optics, name, 0);
+    if (!counter) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, counter);
+    if (lens->lens != counter) lens_free(optics, counter);
+
+    return lens;
+}
+
+struct optics_lens * optics_counter_alloc_striped(struct optics *optics, const char *name)
+{
+    struct lens *counter = lens_counter_alloc(optics, name, lens_stripes());
+    if (!counter) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, counter);
+    if (lens) return lens;
+
+    lens_free(optics, counter);
+    return NULL;
+}
+
+struct optics_lens * optics_counter_alloc_get_striped(
+        struct optics *optics, const char *name)
+{
+    struct lens *counter = lens_counter_alloc(optics, name, lens_stripes());
     if (!counter) return NULL;
 
     struct optics_lens *lens = optics_lens_alloc_get(optics, counter);
@@ -527,9 +569,35 @@ struct optics_lens * optics_counter_alloc_get(struct optics *optics, const char
 
 bool optics_counter_inc(struct optics_lens *lens, int64_t value)
 {
+    if (!lens_sample(lens->lens)) return true;
     return lens_counter_inc(lens, optics_epoch(lens->optics), value);
 }
 
+bool optics_counter_typed(struct optics_lens *lens, optics_counter_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->counter = lens_sub_ptr(lens->lens, optics_counter);
+    return handle->counter != NULL;
+}
+
+void optics_counter_typed_inc(optics_counter_t handle, int64_t value)
+{
+    if (!lens_sample(lens_head_ptr(handle.counter))) return;
+    lens_counter_inc_typed(handle.counter, optics_epoch(handle.optics), value);
+}
+
+bool optics_counter_inc_n(struct optics_lens *lens, const int64_t *values, size_t n)
+{
+    if (!lens_sampled(lens->lens))
+        return lens_counter_inc_n(lens, optics_epoch(lens->optics), values, n);
+
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (lens_sample(lens->lens)) sum += values[i];
+    }
+    return lens_counter_inc(lens, optics_epoch(lens->optics), sum);
+}
+
 enum optics_ret
 optics_counter_read(struct optics_lens *lens, optics_epoch_t epoch, int64_t *value)
 {
@@ -542,7 +610,7 @@ optics_counter_read(struct optics_lens *lens, optics_epoch_t epoch, int64_t *val
 
 struct optics_lens * optics_quantile_alloc(struct optics *optics, const char *name, double target_quantile, double estimate, double adjustment_value )
 {
-    struct lens *quantile = lens_quantile_alloc(optics, name, target_quantile, estimate, adjustment_value);
+    struct lens *quantile = lens_quantile_alloc(optics, name, target_quantile, estimate, adjustment_value, 0);
     if (!quantile) return NULL;
 
     struct optics_lens *lens = optics_lens_alloc(optics, quantile);
@@ -560,7 +628,42 @@ struct optics_lens * optics_quantile_alloc_get(
         double adjustment_value)
 {
     struct lens *quantile =
-        lens_quantile_alloc(optics, name, target_quantile, estimate, adjustment_value);
+        lens_quantile_alloc(optics, name, target_quantile, estimate, adjustment_value, 0);
+    if (!quantile) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, quantile);
+    if (lens->lens != quantile) lens_free(optics, quantile);
+
+    return lens;
+}
+
+struct optics_lens * optics_quantile_alloc_striped(
+        struct optics *optics,
+        const char *name,
+        double target_quantile,
+        double estimate,
+        double adjustment_value)
+{
+    struct lens *quantile = lens_quantile_alloc(
+            optics, name, target_quantile, estimate, adjustment_value, lens_stripes());
+    if (!quantile) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, quantile);
+    if (lens) return lens;
+
+    lens_free(optics, quantile);
+    return NULL;
+}
+
+struct optics_lens * optics_quantile_alloc_get_striped(
+        struct optics *optics,
+        const char *name,
+        double target_quantile,
+        double estimate,
+        double adjustment_value)
+{
+    struct lens *quantile = lens_quantile_alloc(
+            optics, name, target_quantile, estimate, adjustment_value, lens_stripes());
     if (!quantile) return NULL;
 
     struct optics_lens *lens = optics_lens_alloc_get(optics, quantile);
@@ -573,6 +676,23 @@ bool optics_quantile_update(struct optics_lens *lens, double value){
     return lens_quantile_update(lens, optics_epoch(lens->optics), value);
 }
 
+bool optics_quantile_typed(struct optics_lens *lens, optics_quantile_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->quantile = lens_sub_ptr(lens->lens, optics_quantile);
+    return handle->quantile != NULL;
+}
+
+void optics_quantile_typed_update(optics_quantile_t handle, double value)
+{
+    lens_quantile_update_typed(handle.quantile, optics_epoch(handle.optics), value);
+}
+
+bool optics_quantile_update_n(struct optics_lens *lens, const double *values, size_t n)
+{
+    return lens_quantile_update_n(lens, optics_epoch(lens->optics), values, n);
+}
+
 enum optics_ret optics_quantile_read(
         struct optics_lens *lens, optics_epoch_t epoch, struct optics_quantile *value)
 {
@@ -586,7 +706,7 @@ enum optics_ret optics_quantile_read(
 
 struct optics_lens * optics_gauge_alloc(struct optics *optics, const char *name)
 {
-    struct lens *gauge = lens_gauge_alloc(optics, name);
+    struct lens *gauge = lens_gauge_alloc(optics, name, false);
     if (!gauge) return NULL;
 
     struct optics_lens *lens = optics_lens_alloc(optics, gauge);
@@ -598,13 +718,44 @@ struct optics_lens * optics_gauge_alloc(struct optics *optics, const char *name)
 
 struct optics_lens * optics_gauge_alloc_get(struct optics *optics, const char *name)
 {
-    struct lens *gauge = lens_gauge_alloc(optics, name);
+    struct lens *gauge = lens_gauge_alloc(optics, name, false);
     if (!gauge) return NULL;
 
     struct optics_lens *lens = optics_lens_alloc_get(optics, gauge);
-    if (lens->lens != gauge) lens_free(optics, gauge);
+    if (lens->lens == gauge) return lens;
 
-    return lens;
+    lens_free(optics, gauge);
+    if (lens_gauge_check_additive(lens->lens, false)) return lens;
+
+    optics_lens_close(lens);
+    return NULL;
+}
+
+struct optics_lens * optics_gauge_alloc_additive(struct optics *optics, const char *name)
+{
+    struct lens *gauge = lens_gauge_alloc(optics, name, true);
+    if (!gauge) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, gauge);
+    if (lens) return lens;
+
+    lens_free(optics, gauge);
+    return NULL;
+}
+
+struct optics_lens * optics_gauge_alloc_get_additive(struct optics *optics, const char *name)
+{
+    struct lens *gauge = lens_gauge_alloc(optics, name, true);
+    if (!gauge) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, gauge);
+    if (lens->lens == gauge) return lens;
+
+    lens_free(optics, gauge);
+    if (lens_gauge_check_additive(lens->lens, true)) return lens;
+
+    optics_lens_close(lens);
+    return NULL;
 }
 
 bool optics_gauge_set(struct optics_lens *lens, double value)
@@ -612,6 +763,33 @@ bool optics_gauge_set(struct optics_lens *lens, double value)
     return lens_gauge_set(lens, optics_epoch(lens->optics), value);
 }
 
+bool optics_gauge_add(struct optics_lens *lens, double delta)
+{
+    return lens_gauge_add(lens, optics_epoch(lens->optics), delta);
+}
+
+bool optics_gauge_typed(struct optics_lens *lens, optics_gauge_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->gauge = lens_sub_ptr(lens->lens, optics_gauge);
+    return handle->gauge != NULL;
+}
+
+void optics_gauge_typed_set(optics_gauge_t handle, double value)
+{
+    lens_gauge_set_typed(handle.gauge, optics_epoch(handle.optics), value);
+}
+
+void optics_gauge_typed_add(optics_gauge_t handle, double delta)
+{
+    lens_gauge_add_typed(handle.gauge, optics_epoch(handle.optics), delta);
+}
+
+bool optics_gauge_set_last(struct optics_lens *lens, const double *values, size_t n)
+{
+    return lens_gauge_set_last(lens, optics_epoch(lens->optics), values, n);
+}
+
 enum optics_ret
 optics_gauge_read(struct optics_lens *lens, optics_epoch_t epoch, double *value)
 {
@@ -625,7 +803,7 @@ optics_gauge_read(struct optics_lens *lens, optics_epoch_t epoch, double *value)
 
 struct optics_lens * optics_dist_alloc(struct optics *optics, const char *name)
 {
-    struct lens *dist = lens_dist_alloc(optics, name);
+    struct lens *dist = lens_dist_alloc(optics, name, optics_dist_samples, false, 0, 0, 0);
     if (!dist) return NULL;
 
     struct optics_lens *lens = optics_lens_alloc(optics, dist);
@@ -637,7 +815,95 @@ struct optics_lens * optics_dist_alloc(struct optics *optics, const char *name)
 
 struct optics_lens * optics_dist_alloc_get(struct optics *optics, const char *name)
 {
-    struct lens *dist = lens_dist_alloc(optics, name);
+    struct lens *dist = lens_dist_alloc(optics, name, optics_dist_samples, false, 0, 0, 0);
+    if (!dist) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, dist);
+    if (lens->lens != dist) lens_free(optics, dist);
+
+    return lens;
+}
+
+struct optics_lens * optics_dist_alloc_striped(struct optics *optics, const char *name)
+{
+    struct lens *dist =
+        lens_dist_alloc(optics, name, optics_dist_samples, false, 0, 0, lens_stripes());
+    if (!dist) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, dist);
+    if (lens) return lens;
+
+    lens_free(optics, dist);
+    return NULL;
+}
+
+struct optics_lens * optics_dist_alloc_get_striped(
+        struct optics *optics, const char *name)
+{
+    struct lens *dist =
+        lens_dist_alloc(optics, name, optics_dist_samples, false, 0, 0, lens_stripes());
+    if (!dist) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, dist);
+    if (lens->lens != dist) lens_free(optics, dist);
+
+    return lens;
+}
+
+struct optics_lens * optics_dist_alloc_sized(
+        struct optics *optics, const char *name, size_t reservoir_len, bool compact)
+{
+    struct lens *dist = lens_dist_alloc(optics, name, reservoir_len, compact, 0, 0, 0);
+    if (!dist) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, dist);
+    if (lens) return lens;
+
+    lens_free(optics, dist);
+    return NULL;
+}
+
+struct optics_lens * optics_dist_alloc_get_sized(
+        struct optics *optics, const char *name, size_t reservoir_len, bool compact)
+{
+    struct lens *dist = lens_dist_alloc(optics, name, reservoir_len, compact, 0, 0, 0);
+    if (!dist) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, dist);
+    if (lens->lens != dist) lens_free(optics, dist);
+
+    return lens;
+}
+
+struct optics_lens * optics_dist_alloc_decayed(
+        struct optics *optics, const char *name, double half_life)
+{
+    if (!(half_life > 0)) {
+        optics_fail("invalid dist half-life '%g'", half_life);
+        return NULL;
+    }
+
+    struct lens *dist = lens_dist_alloc(optics, name,
+            optics_dist_samples, false, half_life, optics_tsc_nanos(optics), 0);
+    if (!dist) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, dist);
+    if (lens) return lens;
+
+    lens_free(optics, dist);
+    return NULL;
+}
+
+struct optics_lens * optics_dist_alloc_get_decayed(
+        struct optics *optics, const char *name, double half_life)
+{
+    if (!(half_life > 0)) {
+        optics_fail("invalid dist half-life '%g'", half_life);
+        return NULL;
+    }
+
+    struct lens *dist = lens_dist_alloc(optics, name,
+            optics_dist_samples, false, half_life, optics_tsc_nanos(optics), 0);
     if (!dist) return NULL;
 
     struct optics_lens *lens = optics_lens_alloc_get(optics, dist);
@@ -648,7 +914,46 @@ struct optics_lens * optics_dist_alloc_get(struct optics *optics, const char *na
 
 bool optics_dist_record(struct optics_lens *lens, double value)
 {
-    return lens_dist_record(lens, optics_epoch(lens->optics), value);
+    if (!lens_sample(lens->lens)) return true;
+    return lens_dist_record(lens, optics_epoch(lens->optics), value, 0);
+}
+
+bool optics_dist_record_exemplar(struct optics_lens *lens, double value, uint64_t exemplar)
+{
+    if (!lens_sample(lens->lens)) return true;
+    return lens_dist_record(lens, optics_epoch(lens->optics), value, exemplar);
+}
+
+bool optics_dist_typed(struct optics_lens *lens, optics_dist_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->dist = lens_sub_ptr(lens->lens, optics_dist);
+    return handle->dist != NULL;
+}
+
+void optics_dist_typed_record(optics_dist_t handle, double value)
+{
+    if (!lens_sample(lens_head_ptr(handle.dist))) return;
+    lens_dist_record_typed(handle.dist, optics_epoch(handle.optics), value, 0);
+}
+
+void optics_dist_typed_record_exemplar(optics_dist_t handle, double value, uint64_t exemplar)
+{
+    if (!lens_sample(lens_head_ptr(handle.dist))) return;
+    lens_dist_record_typed(handle.dist, optics_epoch(handle.optics), value, exemplar);
+}
+
+bool optics_dist_record_n(struct optics_lens *lens, const double *values, size_t n)
+{
+    optics_epoch_t epoch = optics_epoch(lens->optics);
+    if (!lens_sampled(lens->lens)) return lens_dist_record_n(lens, epoch, values, n);
+
+    double sampled[lens_sample_chunk];
+    for (size_t i = 0; i < n; i += lens_sample_chunk) {
+        size_t len = lens_sample_n(lens->lens, values + i, n - i, sampled);
+        if (!lens_dist_record_n(lens, epoch, sampled, len)) return false;
+    }
+    return true;
 }
 
 enum optics_ret
@@ -665,7 +970,7 @@ optics_dist_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_d
 struct optics_lens * optics_histo_alloc(
         struct optics *optics, const char *name, const uint64_t *buckets, size_t buckets_len)
 {
-    struct lens *histo = lens_histo_alloc(optics, name, buckets, buckets_len);
+    struct lens *histo = lens_histo_alloc(optics, name, buckets, buckets_len, 0, false);
     if (!histo) return NULL;
 
     struct optics_lens *lens = optics_lens_alloc(optics, histo);
@@ -678,7 +983,57 @@ struct optics_lens * optics_histo_alloc(
 struct optics_lens * optics_histo_alloc_get(
         struct optics *optics, const char *name, const uint64_t *buckets, size_t buckets_len)
 {
-    struct lens *histo = lens_histo_alloc(optics, name, buckets, buckets_len);
+    struct lens *histo = lens_histo_alloc(optics, name, buckets, buckets_len, 0, false);
+    if (!histo) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, histo);
+    if (lens->lens != histo) lens_free(optics, histo);
+
+    return lens;
+}
+
+struct optics_lens * optics_histo_alloc_striped(
+        struct optics *optics, const char *name, const uint64_t *buckets, size_t buckets_len)
+{
+    struct lens *histo = lens_histo_alloc(optics, name, buckets, buckets_len, lens_stripes(), false);
+    if (!histo) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, histo);
+    if (lens) return lens;
+
+    lens_free(optics, histo);
+    return NULL;
+}
+
+struct optics_lens * optics_histo_alloc_get_striped(
+        struct optics *optics, const char *name, const uint64_t *buckets, size_t buckets_len)
+{
+    struct lens *histo = lens_histo_alloc(optics, name, buckets, buckets_len, lens_stripes(), false);
+    if (!histo) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, histo);
+    if (lens->lens != histo) lens_free(optics, histo);
+
+    return lens;
+}
+
+struct optics_lens * optics_histo_alloc_exemplars(
+        struct optics *optics, const char *name, const uint64_t *buckets, size_t buckets_len)
+{
+    struct lens *histo = lens_histo_alloc(optics, name, buckets, buckets_len, 0, true);
+    if (!histo) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, histo);
+    if (lens) return lens;
+
+    lens_free(optics, histo);
+    return NULL;
+}
+
+struct optics_lens * optics_histo_alloc_get_exemplars(
+        struct optics *optics, const char *name, const uint64_t *buckets, size_t buckets_len)
+{
+    struct lens *histo = lens_histo_alloc(optics, name, buckets, buckets_len, 0, true);
     if (!histo) return NULL;
 
     struct optics_lens *lens = optics_lens_alloc_get(optics, histo);
@@ -689,7 +1044,46 @@ struct optics_lens * optics_histo_alloc_get(
 
 bool optics_histo_inc(struct optics_lens *lens, double value)
 {
-    return lens_histo_inc(lens, optics_epoch(lens->optics), value);
+    if (!lens_sample(lens->lens)) return true;
+    return lens_histo_inc(lens, optics_epoch(lens->optics), value, 0);
+}
+
+bool optics_histo_inc_exemplar(struct optics_lens *lens, double value, uint64_t exemplar)
+{
+    if (!lens_sample(lens->lens)) return true;
+    return lens_histo_inc(lens, optics_epoch(lens->optics), value, exemplar);
+}
+
+bool optics_histo_typed(struct optics_lens *lens, optics_histo_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->histo = lens_sub_ptr(lens->lens, optics_histo);
+    return handle->histo != NULL;
+}
+
+void optics_histo_typed_inc(optics_histo_t handle, double value)
+{
+    if (!lens_sample(lens_head_ptr(handle.histo))) return;
+    lens_histo_inc_typed(handle.histo, optics_epoch(handle.optics), value, 0);
+}
+
+void optics_histo_typed_inc_exemplar(optics_histo_t handle, double value, uint64_t exemplar)
+{
+    if (!lens_sample(lens_head_ptr(handle.histo))) return;
+    lens_histo_inc_typed(handle.histo, optics_epoch(handle.optics), value, exemplar);
+}
+
+bool optics_histo_inc_n(struct optics_lens *lens, const double *values, size_t n)
+{
+    optics_epoch_t epoch = optics_epoch(lens->optics);
+    if (!lens_sampled(lens->lens)) return lens_histo_inc_n(lens, epoch, values, n);
+
+    double sampled[lens_sample_chunk];
+    for (size_t i = 0; i < n; i += lens_sample_chunk) {
+        size_t len = lens_sample_n(lens->lens, values + i, n - i, sampled);
+        if (!lens_histo_inc_n(lens, epoch, sampled, len)) return false;
+    }
+    return true;
 }
 
 enum optics_ret
@@ -700,7 +1094,668 @@ optics_histo_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_
 
 
 // -----------------------------------------------------------------------------
-// value
+// hdr
+// -----------------------------------------------------------------------------
+
+struct optics_lens * optics_hdr_alloc(
+        struct optics *optics,
+        const char *name,
+        size_t precision,
+        uint64_t lowest,
+        uint64_t highest)
+{
+    struct lens *hdr = lens_hdr_alloc(optics, name, precision, lowest, highest);
+    if (!hdr) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, hdr);
+    if (lens) return lens;
+
+    lens_free(optics, hdr);
+    return NULL;
+}
+
+struct optics_lens * optics_hdr_alloc_get(
+        struct optics *optics,
+        const char *name,
+        size_t precision,
+        uint64_t lowest,
+        uint64_t highest)
+{
+    struct lens *hdr = lens_hdr_alloc(optics, name, precision, lowest, highest);
+    if (!hdr) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, hdr);
+    if (lens->lens != hdr) lens_free(optics, hdr);
+
+    return lens;
+}
+
+bool optics_hdr_record(struct optics_lens *lens, uint64_t value)
+{
+    return lens_hdr_record(lens, optics_epoch(lens->optics), value);
+}
+
+bool optics_hdr_typed(struct optics_lens *lens, optics_hdr_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->hdr = lens_sub_ptr(lens->lens, optics_hdr);
+    return handle->hdr != NULL;
+}
+
+void optics_hdr_typed_record(optics_hdr_t handle, uint64_t value)
+{
+    lens_hdr_record_typed(handle.hdr, optics_epoch(handle.optics), value);
+}
+
+bool optics_hdr_record_n(struct optics_lens *lens, const uint64_t *values, size_t n)
+{
+    return lens_hdr_record_n(lens, optics_epoch(lens->optics), values, n);
+}
+
+enum optics_ret
+optics_hdr_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_hdr *value)
+{
+    return lens_hdr_read(lens, epoch, value);
+}
+
+uint64_t optics_hdr_percentile(const struct optics_hdr *hdr, double percentile)
+{
+    return lens_hdr_percentile(hdr, percentile);
+}
+
+
+// -----------------------------------------------------------------------------
+// sketch
+// -----------------------------------------------------------------------------
+
+struct optics_lens * optics_sketch_alloc(
+        struct optics *optics, const char *name, double alpha, double lowest)
+{
+    struct lens *sketch = lens_sketch_alloc(optics, name, alpha, lowest);
+    if (!sketch) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, sketch);
+    if (lens) return lens;
+
+    lens_free(optics, sketch);
+    return NULL;
+}
+
+struct optics_lens * optics_sketch_alloc_get(
+        struct optics *optics, const char *name, double alpha, double lowest)
+{
+    struct lens *sketch = lens_sketch_alloc(optics, name, alpha, lowest);
+    if (!sketch) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, sketch);
+    if (lens->lens != sketch) lens_free(optics, sketch);
+
+    return lens;
+}
+
+bool optics_sketch_record(struct optics_lens *lens, double value)
+{
+    return lens_sketch_record(lens, optics_epoch(lens->optics), value);
+}
+
+bool optics_sketch_typed(struct optics_lens *lens, optics_sketch_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->sketch = lens_sub_ptr(lens->lens, optics_sketch);
+    return handle->sketch != NULL;
+}
+
+void optics_sketch_typed_record(optics_sketch_t handle, double value)
+{
+    lens_sketch_record_typed(handle.sketch, optics_epoch(handle.optics), value);
+}
+
+bool optics_sketch_record_n(struct optics_lens *lens, const double *values, size_t n)
+{
+    return lens_sketch_record_n(lens, optics_epoch(lens->optics), values, n);
+}
+
+enum optics_ret
+optics_sketch_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_sketch *value)
+{
+    return lens_sketch_read(lens, epoch, value);
+}
+
+double optics_sketch_percentile(const struct optics_sketch *sketch, double percentile)
+{
+    return lens_sketch_percentile(sketch, percentile);
+}
+
+
+// -----------------------------------------------------------------------------
+// hll
+// -----------------------------------------------------------------------------
+
+struct optics_lens * optics_hll_alloc(struct optics *optics, const char *name, size_t precision)
+{
+    struct lens *hll = lens_hll_alloc(optics, name, precision);
+    if (!hll) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, hll);
+    if (lens) return lens;
+
+    lens_free(optics, hll);
+    return NULL;
+}
+
+struct optics_lens * optics_hll_alloc_get(
+        struct optics *optics, const char *name, size_t precision)
+{
+    struct lens *hll = lens_hll_alloc(optics, name, precision);
+    if (!hll) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, hll);
+    if (lens->lens != hll) lens_free(optics, hll);
+
+    return lens;
+}
+
+bool optics_hll_record(struct optics_lens *lens, uint64_t value)
+{
+    return lens_hll_record(lens, optics_epoch(lens->optics), value);
+}
+
+bool optics_hll_typed(struct optics_lens *lens, optics_hll_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->hll = lens_sub_ptr(lens->lens, optics_hll);
+    return handle->hll != NULL;
+}
+
+void optics_hll_typed_record(optics_hll_t handle, uint64_t value)
+{
+    lens_hll_record_typed(handle.hll, optics_epoch(handle.optics), value);
+}
+
+enum optics_ret
+optics_hll_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_hll *value)
+{
+    return lens_hll_read(lens, epoch, value);
+}
+
+double optics_hll_estimate(const struct optics_hll *hll)
+{
+    return lens_hll_estimate(hll);
+}
+
+
+// -----------------------------------------------------------------------------
+// topk
+// -----------------------------------------------------------------------------
+
+struct optics_lens * optics_topk_alloc(struct optics *optics, const char *name, size_t k)
+{
+    struct lens *topk = lens_topk_alloc(optics, name, k);
+    if (!topk) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, topk);
+    if (lens) return lens;
+
+    lens_free(optics, topk);
+    return NULL;
+}
+
+struct optics_lens * optics_topk_alloc_get(struct optics *optics, const char *name, size_t k)
+{
+    struct lens *topk = lens_topk_alloc(optics, name, k);
+    if (!topk) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, topk);
+    if (lens->lens != topk) lens_free(optics, topk);
+
+    return lens;
+}
+
+bool optics_topk_inc(struct optics_lens *lens, const char *item, uint64_t value)
+{
+    return lens_topk_inc(lens, optics_epoch(lens->optics), item, value);
+}
+
+bool optics_topk_typed(struct optics_lens *lens, optics_topk_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->topk = lens_sub_ptr(lens->lens, optics_topk);
+    return handle->topk != NULL;
+}
+
+bool optics_topk_typed_inc(optics_topk_t handle, const char *item, uint64_t value)
+{
+    return lens_topk_inc_typed(handle.topk, optics_epoch(handle.optics), item, value);
+}
+
+enum optics_ret
+optics_topk_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_topk *value)
+{
+    return lens_topk_read(lens, epoch, value);
+}
+
+
+// -----------------------------------------------------------------------------
+// summary
+// -----------------------------------------------------------------------------
+
+struct optics_lens * optics_summary_alloc(struct optics *optics, const char *name)
+{
+    struct lens *summary = lens_summary_alloc(optics, name);
+    if (!summary) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, summary);
+    if (lens) return lens;
+
+    lens_free(optics, summary);
+    return NULL;
+}
+
+struct optics_lens * optics_summary_alloc_get(struct optics *optics, const char *name)
+{
+    struct lens *summary = lens_summary_alloc(optics, name);
+    if (!summary) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, summary);
+    if (lens->lens != summary) lens_free(optics, summary);
+
+    return lens;
+}
+
+bool optics_summary_record(struct optics_lens *lens, double value)
+{
+    return lens_summary_record(lens, optics_epoch(lens->optics), value);
+}
+
+bool optics_summary_record_n(struct optics_lens *lens, const double *values, size_t n)
+{
+    return lens_summary_record_n(lens, optics_epoch(lens->optics), values, n);
+}
+
+bool optics_summary_typed(struct optics_lens *lens, optics_summary_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->summary = lens_sub_ptr(lens->lens, optics_summary);
+    return handle->summary != NULL;
+}
+
+void optics_summary_typed_record(optics_summary_t handle, double value)
+{
+    lens_summary_record_typed(handle.summary, optics_epoch(handle.optics), value);
+}
+
+enum optics_ret
+optics_summary_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_summary *value)
+{
+    return lens_summary_read(lens, epoch, value);
+}
+
+double optics_summary_mean(const struct optics_summary *summary)
+{
+    return lens_summary_mean(summary);
+}
+
+double optics_summary_stddev(const struct optics_summary *summary)
+{
+    return lens_summary_stddev(summary);
+}
+
+
+// -----------------------------------------------------------------------------
+// counter vec
+// -----------------------------------------------------------------------------
+
+struct optics_lens * optics_counter_vec_alloc(
+        struct optics *optics, const char *name, const char **labels, size_t len)
+{
+    struct lens *vec = lens_counter_vec_alloc(optics, name, labels, len);
+    if (!vec) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, vec);
+    if (lens) return lens;
+
+    lens_free(optics, vec);
+    return NULL;
+}
+
+struct optics_lens * optics_counter_vec_alloc_get(
+        struct optics *optics, const char *name, const char **labels, size_t len)
+{
+    struct lens *vec = lens_counter_vec_alloc(optics, name, labels, len);
+    if (!vec) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, vec);
+    if (lens->lens != vec) lens_free(optics, vec);
+
+    return lens;
+}
+
+bool optics_counter_vec_inc(struct optics_lens *lens, size_t index, int64_t value)
+{
+    return lens_counter_vec_inc(lens, optics_epoch(lens->optics), index, value);
+}
+
+bool optics_counter_vec_typed(struct optics_lens *lens, optics_counter_vec_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->vec = lens_sub_ptr(lens->lens, optics_counter_vec);
+    return handle->vec != NULL;
+}
+
+bool optics_counter_vec_typed_inc(optics_counter_vec_t handle, size_t index, int64_t value)
+{
+    return lens_counter_vec_inc_typed(handle.vec, optics_epoch(handle.optics), index, value);
+}
+
+enum optics_ret optics_counter_vec_read(
+        struct optics_lens *lens, optics_epoch_t epoch, struct optics_counter_vec *value)
+{
+    return lens_counter_vec_read(lens, epoch, value);
+}
+
+
+// -----------------------------------------------------------------------------
+// heatmap
+// -----------------------------------------------------------------------------
+
+struct optics_lens * optics_heatmap_alloc(
+        struct optics *optics, const char *name,
+        const uint64_t *x_buckets, size_t x_len,
+        const uint64_t *y_buckets, size_t y_len)
+{
+    struct lens *heatmap =
+        lens_heatmap_alloc(optics, name, x_buckets, x_len, y_buckets, y_len);
+    if (!heatmap) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, heatmap);
+    if (lens) return lens;
+
+    lens_free(optics, heatmap);
+    return NULL;
+}
+
+struct optics_lens * optics_heatmap_alloc_get(
+        struct optics *optics, const char *name,
+        const uint64_t *x_buckets, size_t x_len,
+        const uint64_t *y_buckets, size_t y_len)
+{
+    struct lens *heatmap =
+        lens_heatmap_alloc(optics, name, x_buckets, x_len, y_buckets, y_len);
+    if (!heatmap) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, heatmap);
+    if (lens->lens != heatmap) lens_free(optics, heatmap);
+
+    return lens;
+}
+
+bool optics_heatmap_inc(struct optics_lens *lens, double x, double y)
+{
+    return lens_heatmap_inc(lens, optics_epoch(lens->optics), x, y);
+}
+
+bool optics_heatmap_typed(struct optics_lens *lens, optics_heatmap_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->heatmap = lens_sub_ptr(lens->lens, optics_heatmap);
+    return handle->heatmap != NULL;
+}
+
+void optics_heatmap_typed_inc(optics_heatmap_t handle, double x, double y)
+{
+    lens_heatmap_inc_typed(handle.heatmap, optics_epoch(handle.optics), x, y);
+}
+
+enum optics_ret optics_heatmap_read(
+        struct optics_lens *lens, optics_epoch_t epoch, struct optics_heatmap *value)
+{
+    return lens_heatmap_read(lens, epoch, value);
+}
+
+
+// -----------------------------------------------------------------------------
+// event
+// -----------------------------------------------------------------------------
+
+struct optics_lens * optics_event_alloc(struct optics *optics, const char *name, size_t capacity)
+{
+    struct lens *event = lens_event_alloc(optics, name, capacity);
+    if (!event) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, event);
+    if (lens) return lens;
+
+    lens_free(optics, event);
+    return NULL;
+}
+
+struct optics_lens * optics_event_alloc_get(
+        struct optics *optics, const char *name, size_t capacity)
+{
+    struct lens *event = lens_event_alloc(optics, name, capacity);
+    if (!event) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, event);
+    if (lens->lens != event) lens_free(optics, event);
+
+    return lens;
+}
+
+bool optics_event_record(struct optics_lens *lens, uint64_t id, double value)
+{
+    return lens_event_record(lens, optics_epoch(lens->optics), id, value);
+}
+
+bool optics_event_typed(struct optics_lens *lens, optics_event_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->event = lens_sub_ptr(lens->lens, optics_event);
+    return handle->event != NULL;
+}
+
+void optics_event_typed_record(optics_event_t handle, uint64_t id, double value)
+{
+    lens_event_record_typed(handle.event, optics_epoch(handle.optics), id, value);
+}
+
+enum optics_ret
+optics_event_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_event *value)
+{
+    return lens_event_read(lens, epoch, value);
+}
+
+
+// -----------------------------------------------------------------------------
+// tsc
+// -----------------------------------------------------------------------------
+
+// Concurrent calibrations come up with slightly different values so the first
+// one to be published wins.
+double optics_tsc_nanos(struct optics *optics)
+{
+    uint64_t nanos = atomic_load_explicit(&optics->header->tsc_nanos, memory_order_relaxed);
+    if (nanos) return pun_itod(nanos);
+
+    uint64_t calibrated = pun_dtoi(clock_rdtsc_nanos());
+    if (atomic_compare_exchange_strong_explicit(&optics->header->tsc_nanos, &nanos,
+                    calibrated, memory_order_relaxed, memory_order_relaxed))
+        return pun_itod(calibrated);
+
+    return pun_itod(nanos);
+}
+
+struct optics_lens * optics_tsc_alloc(struct optics *optics, const char *name, double scale)
+{
+    struct lens *tsc = lens_tsc_alloc(optics, name, optics_tsc_nanos(optics) * scale);
+    if (!tsc) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, tsc);
+    if (lens) return lens;
+
+    lens_free(optics, tsc);
+    return NULL;
+}
+
+struct optics_lens * optics_tsc_alloc_get(struct optics *optics, const char *name, double scale)
+{
+    struct lens *tsc = lens_tsc_alloc(optics, name, optics_tsc_nanos(optics) * scale);
+    if (!tsc) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, tsc);
+    if (lens->lens != tsc) lens_free(optics, tsc);
+
+    return lens;
+}
+
+bool optics_tsc_record(struct optics_lens *lens, uint64_t cycles)
+{
+    return lens_tsc_record(lens, optics_epoch(lens->optics), cycles);
+}
+
+bool optics_tsc_typed(struct optics_lens *lens, optics_tsc_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->tsc = lens_sub_ptr(lens->lens, optics_tsc);
+    return handle->tsc != NULL;
+}
+
+void optics_tsc_typed_record(optics_tsc_t handle, uint64_t cycles)
+{
+    lens_tsc_record_typed(handle.tsc, optics_epoch(handle.optics), cycles);
+}
+
+enum optics_ret
+optics_tsc_read(struct optics_lens *lens, optics_epoch_t epoch, struct optics_tsc *value)
+{
+    return lens_tsc_read(lens, epoch, value);
+}
+
+double optics_tsc_percentile(const struct optics_tsc *tsc, double percentile)
+{
+    return lens_tsc_percentile(tsc, percentile);
+}
+
+double optics_tsc_max(const struct optics_tsc *tsc)
+{
+    return lens_tsc_max(tsc);
+}
+
+
+// -----------------------------------------------------------------------------
+// meter
+// -----------------------------------------------------------------------------
+
+struct optics_lens * optics_meter_alloc(struct optics *optics, const char *name)
+{
+    struct lens *meter = lens_meter_alloc(optics, name);
+    if (!meter) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, meter);
+    if (lens) return lens;
+
+    lens_free(optics, meter);
+    return NULL;
+}
+
+struct optics_lens * optics_meter_alloc_get(struct optics *optics, const char *name)
+{
+    struct lens *meter = lens_meter_alloc(optics, name);
+    if (!meter) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, meter);
+    if (lens->lens != meter) lens_free(optics, meter);
+
+    return lens;
+}
+
+bool optics_meter_mark(struct optics_lens *lens, int64_t count)
+{
+    return lens_meter_mark(lens, optics_epoch(lens->optics), count);
+}
+
+bool optics_meter_typed(struct optics_lens *lens, optics_meter_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->meter = lens_sub_ptr(lens->lens, optics_meter);
+    return handle->meter != NULL;
+}
+
+void optics_meter_typed_mark(optics_meter_t handle, int64_t count)
+{
+    lens_meter_mark_typed(handle.meter, optics_epoch(handle.optics), count);
+}
+
+enum optics_ret optics_meter_read(
+        struct optics_lens *lens, optics_epoch_t epoch, struct optics_meter *value)
+{
+    return lens_meter_read(lens, epoch, value);
+}
+
+
+// -----------------------------------------------------------------------------
+// quantile vec
+// -----------------------------------------------------------------------------
+
+struct optics_lens * optics_quantile_vec_alloc(
+        struct optics *optics, const char *name,
+        const double *quantiles, size_t len, double estimate, double adjustment_value)
+{
+    struct lens *vec = lens_quantile_vec_alloc(
+            optics, name, quantiles, len, estimate, adjustment_value);
+    if (!vec) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc(optics, vec);
+    if (lens) return lens;
+
+    lens_free(optics, vec);
+    return NULL;
+}
+
+struct optics_lens * optics_quantile_vec_alloc_get(
+        struct optics *optics, const char *name,
+        const double *quantiles, size_t len, double estimate, double adjustment_value)
+{
+    struct lens *vec = lens_quantile_vec_alloc(
+            optics, name, quantiles, len, estimate, adjustment_value);
+    if (!vec) return NULL;
+
+    struct optics_lens *lens = optics_lens_alloc_get(optics, vec);
+    if (lens->lens != vec) lens_free(optics, vec);
+
+    return lens;
+}
+
+bool optics_quantile_vec_update(struct optics_lens *lens, double value)
+{
+    return lens_quantile_vec_update(lens, optics_epoch(lens->optics), value);
+}
+
+bool optics_quantile_vec_update_n(struct optics_lens *lens, const double *values, size_t n)
+{
+    return lens_quantile_vec_update_n(lens, optics_epoch(lens->optics), values, n);
+}
+
+bool optics_quantile_vec_typed(struct optics_lens *lens, optics_quantile_vec_t *handle)
+{
+    handle->optics = lens->optics;
+    handle->vec = lens_sub_ptr(lens->lens, optics_quantile_vec);
+    return handle->vec != NULL;
+}
+
+void optics_quantile_vec_typed_update(optics_quantile_vec_t handle, double value)
+{
+    lens_quantile_vec_update_typed(handle.vec, optics_epoch(handle.optics), value);
+}
+
+enum optics_ret optics_quantile_vec_read(
+        struct optics_lens *lens, optics_epoch_t epoch, struct optics_quantile_vec *value)
+{
+    return lens_quantile_vec_read(lens, epoch, value);
+}
+
+
+// -----------------------------------------------------------------------------
+// value
 // -----------------------------------------------------------------------------
 
 bool optics_poll_normalize(
@@ -712,6 +1767,17 @@ bool optics_poll_normalize(
     case optics_dist: return lens_dist_normalize(poll, cb, ctx);
     case optics_histo: return lens_histo_normalize(poll, cb, ctx);
     case optics_quantile: return lens_quantile_normalize(poll, cb, ctx);
+    case optics_hdr: return lens_hdr_normalize(poll, cb, ctx);
+    case optics_sketch: return lens_sketch_normalize(poll, cb, ctx);
+    case optics_hll: return lens_hll_normalize(poll, cb, ctx);
+    case optics_topk: return lens_topk_normalize(poll, cb, ctx);
+    case optics_summary: return lens_summary_normalize(poll, cb, ctx);
+    case optics_counter_vec: return lens_counter_vec_normalize(poll, cb, ctx);
+    case optics_heatmap: return lens_heatmap_normalize(poll, cb, ctx);
+    case optics_event: return lens_event_normalize(poll, cb, ctx);
+    case optics_tsc: return lens_tsc_normalize(poll, cb, ctx);
+    case optics_meter: return lens_meter_normalize(poll, cb, ctx);
+    case optics_quantile_vec: return lens_quantile_vec_normalize(poll, cb, ctx);
     default:
         optics_fail("unknown lens type '%d'", poll->type);
         return false;
@@ -719,9 +1785,57 @@ bool optics_poll_normalize(
 }
 
 
+// -----------------------------------------------------------------------------
+// inline
+// -----------------------------------------------------------------------------
+
+static bool optics_inline_check(struct optics *optics, uint64_t abi)
+{
+    if (abi == optics->header->version) return true;
+
+    optics_fail("inline abi '%lu' doesn't match region version '%lu'",
+            abi, optics->header->version);
+    return false;
+}
+
+bool optics_inline_counter_open_abi(
+        struct optics_lens *lens, struct optics_inline_counter *counter, uint64_t abi)
+{
+    if (!optics_inline_check(lens->optics, abi)) return false;
+
+    counter->epoch = &lens->optics->header->epoch;
+    counter->value = lens_counter_inline(lens);
+    return counter->value != NULL;
+}
+
+bool optics_inline_gauge_open_abi(
+        struct optics_lens *lens, struct optics_inline_gauge *gauge, uint64_t abi)
+{
+    if (!optics_inline_check(lens->optics, abi)) return false;
+
+    gauge->value = lens_gauge_inline(lens);
+    return gauge->value != NULL;
+}
+
+extern inline void optics_inline_counter_inc(
+        const struct optics_inline_counter *counter, int64_t value);
+extern inline void optics_inline_gauge_set(
+        const struct optics_inline_gauge *gauge, double value);
+extern inline void optics_inline_gauge_add(
+        const struct optics_inline_gauge *gauge, double delta);
+
+
 // -----------------------------------------------------------------------------
 // misc
 // -----------------------------------------------------------------------------
 
 extern inline void optics_timer_start(optics_timer_t *t0);
 extern inline double optics_timer_elapsed(optics_timer_t *t0, double scale);
+extern inline uint64_t optics_rdtsc(void);
+
+
+// -----------------------------------------------------------------------------
+// implementation
+// -----------------------------------------------------------------------------
+
+#include "batch.c"
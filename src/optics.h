@@ -32,6 +32,46 @@ enum {
     // since there's no way to achieve a constant error bound with reservoir
     // sampling, we tweaked it to stay on the low side of memory consumption.
     optics_dist_samples = 200,
+
+    // Bounds on the reservoir size of dists allocated with an explicit size.
+    optics_dist_samples_min = 16,
+    optics_dist_samples_max = 1024,
+
+    // Bounds on the significant decimal digits of an hdr lens along with the
+    // largest bucket array that can be used to cover its range which is as
+    // much as the two epochs of a lens can hold in the largest allocation.
+    optics_hdr_precision_min = 1,
+    optics_hdr_precision_max = 3,
+    optics_hdr_buckets_max = 3968,
+
+    // Bucket budget of the sketch lens. With an alpha of 0.01 this covers
+    // values over four orders of magnitude above the lowest value.
+    optics_sketch_buckets_max = 512,
+
+    // Bounds on the number of registers of the hll lens expressed as a power
+    // of two. The standard error of the estimate is 1.04 / sqrt(2^precision).
+    optics_hll_precision_min = 4,
+    optics_hll_precision_max = 12,
+    optics_hll_registers_max = 1 << optics_hll_precision_max,
+
+    // Number of items tracked by the topk lens and the maximum length of an
+    // item including its null terminator.
+    optics_topk_items_max = 64,
+    optics_topk_item_max_len = 48,
+
+    // Bounds on the number of slots of a counter vec lens and on the length of
+    // their labels including the null terminator.
+    optics_counter_vec_slots_max = 256,
+    optics_counter_vec_label_max_len = 24,
+
+    // Maximum number of buckets on each axis of a heatmap lens.
+    optics_heatmap_buckets_max = 16,
+
+    // Maximum number of events that an event lens can hold per epoch.
+    optics_event_capacity_max = 256,
+
+    // Maximum number of quantiles tracked by a quantile vec lens.
+    optics_quantile_vec_len_max = 8,
 };
 
 typedef uint64_t optics_ts_t;
@@ -91,6 +131,17 @@ enum optics_lens_type
     optics_dist,
     optics_histo,
     optics_quantile,
+    optics_hdr,
+    optics_sketch,
+    optics_hll,
+    optics_topk,
+    optics_summary,
+    optics_counter_vec,
+    optics_heatmap,
+    optics_event,
+    optics_tsc,
+    optics_meter,
+    optics_quantile_vec,
 };
 
 enum optics_ret
@@ -107,13 +158,36 @@ const char * optics_lens_name(struct optics_lens *);
 void optics_lens_close(struct optics_lens *);
 bool optics_lens_free(struct optics_lens *);
 
+// Sampled lenses only record one event out of sampling on average, picked at
+// random by a thread-local countdown, and reads scale their counts back up so
+// lenses sampled at different rates can be merged. Only supported by counters,
+// dists and histos and should be set before the lens is recorded into. Inline
+// counters can't be opened on sampled lenses.
+bool optics_lens_set_sampling(struct optics_lens *, size_t sampling);
+size_t optics_lens_sampling(struct optics_lens *);
+
 struct optics_lens * optics_counter_alloc(struct optics *, const char *name);
 struct optics_lens * optics_counter_alloc_get(struct optics *, const char *name);
 bool optics_counter_inc(struct optics_lens *, int64_t value);
+bool optics_counter_inc_n(struct optics_lens *, const int64_t *values, size_t n);
+
+// Striped lenses give each cpu its own cache line to record in which avoids
+// contention on heavily used lenses at the cost of a larger memory footprint
+// and a slower read.
+struct optics_lens * optics_counter_alloc_striped(struct optics *, const char *name);
+struct optics_lens * optics_counter_alloc_get_striped(struct optics *, const char *name);
 
 struct optics_lens * optics_gauge_alloc(struct optics *, const char *name);
 struct optics_lens * optics_gauge_alloc_get(struct optics *, const char *name);
 bool optics_gauge_set(struct optics_lens *, double value);
+bool optics_gauge_set_last(struct optics_lens *, const double *values, size_t n);
+bool optics_gauge_add(struct optics_lens *, double delta);
+
+// Additive gauges are meant to be updated with optics_gauge_add by multiple
+// processes (e.g. in-flight requests). The poller sums their values instead of
+// keeping the last one read.
+struct optics_lens * optics_gauge_alloc_additive(struct optics *, const char *name);
+struct optics_lens * optics_gauge_alloc_get_additive(struct optics *, const char *name);
 
 struct optics_dist
 {
@@ -122,12 +196,60 @@ struct optics_dist
     double p90;
     double p99;
     double max;
-    double samples[optics_dist_samples];
+
+    // Number of values backing the reservoir which is lower than n for sampled
+    // lenses as n is scaled back up by their sampling rate.
+    size_t recorded;
+
+    // Size of the reservoir of the lens which bounds the number of valid
+    // samples.
+    size_t reservoir_len;
+    double samples[optics_dist_samples_max];
+
+    // Half-life of forward decayed dists and log of the decayed weight of the
+    // samples as of the read.
+    double half_life;
+    double weight;
+
+    // Tag of the largest value recorded with an exemplar along with that value.
+    // A tag of 0 means that no tagged value was recorded.
+    uint64_t exemplar;
+    double exemplar_value;
 };
 
 struct optics_lens * optics_dist_alloc(struct optics *, const char *name);
 struct optics_lens * optics_dist_alloc_get(struct optics *, const char *name);
 bool optics_dist_record(struct optics_lens *, double value);
+bool optics_dist_record_n(struct optics_lens *, const double *values, size_t n);
+
+// Records the value along with a non-zero exemplar tag (e.g. a request id) which
+// is reported if the value ends up being the largest tagged value of the epoch.
+// Values recorded through optics_dist_record_n or a batch carry no tag and are
+// never reported as exemplars.
+bool optics_dist_record_exemplar(struct optics_lens *, double value, uint64_t exemplar);
+
+// Striped dists are capped to a smaller number of stripes than the other
+// striped lenses as each stripe carries two full reservoirs.
+struct optics_lens * optics_dist_alloc_striped(struct optics *, const char *name);
+struct optics_lens * optics_dist_alloc_get_striped(struct optics *, const char *name);
+
+// Reservoir of reservoir_len samples in [optics_dist_samples_min,
+// optics_dist_samples_max] which trades the accuracy of the percentiles for
+// memory. Compact dists store their samples as floats which halves the size of
+// their reservoir.
+struct optics_lens * optics_dist_alloc_sized(
+        struct optics *, const char *name, size_t reservoir_len, bool compact);
+struct optics_lens * optics_dist_alloc_get_sized(
+        struct optics *, const char *name, size_t reservoir_len, bool compact);
+
+// Forward decayed reservoir where the weight of a record halves every
+// half_life seconds relative to the more recent records. Biases the
+// percentiles towards the end of the poll interval. Timestamps are taken with
+// optics_rdtsc and batches are not supported.
+struct optics_lens * optics_dist_alloc_decayed(
+        struct optics *, const char *name, double half_life);
+struct optics_lens * optics_dist_alloc_get_decayed(
+        struct optics *, const char *name, double half_life);
 
 struct optics_histo
 {
@@ -136,6 +258,10 @@ struct optics_histo
 
     size_t below, above;
     size_t counts[optics_histo_buckets_max];
+
+    // Exemplar tag of each bucket in the [below, counts..., above] layout where
+    // a tag of 0 means that the bucket has no exemplar.
+    uint64_t exemplars[optics_histo_buckets_max + 2];
 };
 
 struct optics_lens * optics_histo_alloc(
@@ -143,6 +269,25 @@ struct optics_lens * optics_histo_alloc(
 struct optics_lens * optics_histo_alloc_get(
         struct optics *, const char *name, const uint64_t *buckets, size_t buckets_len);
 bool optics_histo_inc(struct optics_lens *, double value);
+bool optics_histo_inc_n(struct optics_lens *, const double *values, size_t n);
+
+// Histos only keep exemplars if allocated with the exemplars variants as the
+// tags add a slot per bucket and epoch.
+struct optics_lens * optics_histo_alloc_exemplars(
+        struct optics *, const char *name, const uint64_t *buckets, size_t buckets_len);
+struct optics_lens * optics_histo_alloc_get_exemplars(
+        struct optics *, const char *name, const uint64_t *buckets, size_t buckets_len);
+
+// Increments the bucket of the value and tags it with a non-zero exemplar (e.g.
+// a request id) if the bucket doesn't already have one for this epoch. The tag
+// is ignored if the histo wasn't allocated with exemplars. Values incremented
+// through optics_histo_inc_n or a batch carry no tag.
+bool optics_histo_inc_exemplar(struct optics_lens *, double value, uint64_t exemplar);
+
+struct optics_lens * optics_histo_alloc_striped(
+        struct optics *, const char *name, const uint64_t *buckets, size_t buckets_len);
+struct optics_lens * optics_histo_alloc_get_striped(
+        struct optics *, const char *name, const uint64_t *buckets, size_t buckets_len);
 
 struct optics_quantile
 {
@@ -157,6 +302,335 @@ struct optics_lens * optics_quantile_alloc(
 struct optics_lens * optics_quantile_alloc_get(
     struct optics *, const char *name, double quantile, double estimate, double adjustment_value);
 bool optics_quantile_update(struct optics_lens *, double value);
+bool optics_quantile_update_n(struct optics_lens *, const double *values, size_t n);
+
+// Each cpu adjusts its own estimate which is merged with the others when the
+// lens is read. Avoids contention on hot lenses at the cost of a cache line per
+// stripe.
+struct optics_lens * optics_quantile_alloc_striped(
+    struct optics *, const char *name, double quantile, double estimate, double adjustment_value);
+struct optics_lens * optics_quantile_alloc_get_striped(
+    struct optics *, const char *name, double quantile, double estimate, double adjustment_value);
+
+// Log-linear histogram where the relative error of percentiles is bounded by
+// the given number of significant decimal digits over the range [lowest,
+// highest]. Values are tracked at the resolution of lowest rounded down to a
+// power of two and values past the range are counted as above.
+struct optics_hdr
+{
+    size_t precision;
+    size_t unit;
+    size_t buckets_len;
+
+    size_t above;
+    uint64_t max;
+    size_t counts[optics_hdr_buckets_max];
+};
+
+// Like HDR histograms, the buckets are sized from the precision and the ratio
+// of highest to lowest and configurations that need more than
+// optics_hdr_buckets_max buckets are rejected. As a rough guide, a precision of
+// 1 covers the full 64 bits, 2 covers a ratio of 2^37 and 3 covers a ratio of
+// 2^12.
+struct optics_lens * optics_hdr_alloc(
+        struct optics *, const char *name,
+        size_t precision, uint64_t lowest, uint64_t highest);
+struct optics_lens * optics_hdr_alloc_get(
+        struct optics *, const char *name,
+        size_t precision, uint64_t lowest, uint64_t highest);
+bool optics_hdr_record(struct optics_lens *, uint64_t value);
+bool optics_hdr_record_n(struct optics_lens *, const uint64_t *values, size_t n);
+
+uint64_t optics_hdr_percentile(const struct optics_hdr *, double percentile);
+
+// DDSketch where percentiles have a relative error bounded by alpha for values
+// within the range covered by the bucket budget starting from lowest. Values
+// outside of that range are collapsed in the first or last bucket. Sketches
+// with the same configuration merge exactly.
+struct optics_sketch
+{
+    double alpha;
+    double lowest;
+    size_t counts[optics_sketch_buckets_max];
+};
+
+struct optics_lens * optics_sketch_alloc(
+        struct optics *, const char *name, double alpha, double lowest);
+struct optics_lens * optics_sketch_alloc_get(
+        struct optics *, const char *name, double alpha, double lowest);
+bool optics_sketch_record(struct optics_lens *, double value);
+bool optics_sketch_record_n(struct optics_lens *, const double *values, size_t n);
+
+double optics_sketch_percentile(const struct optics_sketch *, double percentile);
+
+// HyperLogLog estimate of the number of distinct values recorded. Values are
+// hashed before being recorded so they don't need to be well distributed.
+// Estimates from lenses with the same precision merge exactly.
+struct optics_hll
+{
+    size_t precision;
+    uint8_t registers[optics_hll_registers_max];
+};
+
+struct optics_lens * optics_hll_alloc(struct optics *, const char *name, size_t precision);
+struct optics_lens * optics_hll_alloc_get(struct optics *, const char *name, size_t precision);
+bool optics_hll_record(struct optics_lens *, uint64_t value);
+
+double optics_hll_estimate(const struct optics_hll *);
+
+// Space-saving heavy hitters which tracks the optics_topk_items_max most
+// frequent items in a fixed amount of memory and reports the k largest. Counts
+// can be overestimated for items that were evicted at some point. Items are
+// sorted by decreasing count.
+struct optics_topk_item
+{
+    char item[optics_topk_item_max_len];
+    uint64_t count;
+};
+
+struct optics_topk
+{
+    size_t k;
+    size_t len;
+    struct optics_topk_item items[optics_topk_items_max];
+};
+
+struct optics_lens * optics_topk_alloc(struct optics *, const char *name, size_t k);
+struct optics_lens * optics_topk_alloc_get(struct optics *, const char *name, size_t k);
+bool optics_topk_inc(struct optics_lens *, const char *item, uint64_t value);
+
+// Exact count, sum, sum of squares and bounds of the recorded values. Recording
+// never blocks and values from multiple lenses merge exactly.
+struct optics_summary
+{
+    size_t count;
+    double sum;
+    double sumsq;
+    double min;
+    double max;
+};
+
+struct optics_lens * optics_summary_alloc(struct optics *, const char *name);
+struct optics_lens * optics_summary_alloc_get(struct optics *, const char *name);
+bool optics_summary_record(struct optics_lens *, double value);
+bool optics_summary_record_n(struct optics_lens *, const double *values, size_t n);
+
+double optics_summary_mean(const struct optics_summary *);
+double optics_summary_stddev(const struct optics_summary *);
+
+// Array of counters indexed by small integers (e.g. status codes or shards)
+// stored in a single lens. Each slot is emitted as <lens>.<label> where labels
+// default to the index of the slot if none are provided.
+struct optics_counter_vec
+{
+    size_t len;
+    int64_t counts[optics_counter_vec_slots_max];
+    char labels[optics_counter_vec_slots_max][optics_counter_vec_label_max_len];
+};
+
+struct optics_lens * optics_counter_vec_alloc(
+        struct optics *, const char *name, const char **labels, size_t len);
+struct optics_lens * optics_counter_vec_alloc_get(
+        struct optics *, const char *name, const char **labels, size_t len);
+bool optics_counter_vec_inc(struct optics_lens *, size_t index, int64_t value);
+
+// Two dimensional histogram which counts (x, y) pairs. Each axis is bucketed
+// like a histo lens along with a below and above cell. Counts are stored
+// row-major by x with y_len + 1 cells per row where index 0 is below the first
+// bound and index len is above the last one.
+struct optics_heatmap
+{
+    size_t x_len, y_len;
+    uint64_t x_buckets[optics_heatmap_buckets_max + 1];
+    uint64_t y_buckets[optics_heatmap_buckets_max + 1];
+    size_t counts[(optics_heatmap_buckets_max + 2) * (optics_heatmap_buckets_max + 2)];
+};
+
+struct optics_lens * optics_heatmap_alloc(
+        struct optics *, const char *name,
+        const uint64_t *x_buckets, size_t x_len,
+        const uint64_t *y_buckets, size_t y_len);
+struct optics_lens * optics_heatmap_alloc_get(
+        struct optics *, const char *name,
+        const uint64_t *x_buckets, size_t x_len,
+        const uint64_t *y_buckets, size_t y_len);
+bool optics_heatmap_inc(struct optics_lens *, double x, double y);
+
+// Raw events (e.g. the id of a slow request along with its latency) recorded in
+// a fixed-size ring that is drained by the poller on every epoch. Events
+// recorded once the ring is full are dropped and counted.
+struct optics_event_item
+{
+    uint64_t id;
+    double value;
+};
+
+struct optics_event
+{
+    size_t len;
+    size_t dropped;
+    struct optics_event_item events[optics_event_capacity_max];
+};
+
+struct optics_lens * optics_event_alloc(struct optics *, const char *name, size_t capacity);
+struct optics_lens * optics_event_alloc_get(struct optics *, const char *name, size_t capacity);
+bool optics_event_record(struct optics_lens *, uint64_t id, double value);
+
+// Timer fed with raw tsc cycle deltas (see optics_rdtsc) which are only
+// converted to time when polled using the tsc frequency calibrated when the
+// first tsc lens of the region is allocated. Scale is one of the optics_sec,
+// optics_msec, etc. constants. Cycles are recorded in an hdr histogram with a
+// precision of 2 significant digits over [16, 2^40] cycles.
+struct optics_tsc
+{
+    double scale; // units per cycle.
+    struct optics_hdr cycles;
+};
+
+struct optics_lens * optics_tsc_alloc(struct optics *, const char *name, double scale);
+struct optics_lens * optics_tsc_alloc_get(struct optics *, const char *name, double scale);
+bool optics_tsc_record(struct optics_lens *, uint64_t cycles);
+
+// Calibrates the tsc of the region on the first call which busy-waits for
+// about a millisecond.
+double optics_tsc_nanos(struct optics *);
+
+double optics_tsc_percentile(const struct optics_tsc *, double percentile);
+double optics_tsc_max(const struct optics_tsc *);
+
+// Counter which also reports exponentially weighted moving averages of its
+// per-second rate over the last 1, 5 and 15 polls. The averages are maintained
+// by the poller from the count merged across all processes so they're the rate
+// of the whole host rather than a sum of per-process rates.
+struct optics_meter
+{
+    int64_t count;
+    double rate_1;
+    double rate_5;
+    double rate_15;
+};
+
+struct optics_lens * optics_meter_alloc(struct optics *, const char *name);
+struct optics_lens * optics_meter_alloc_get(struct optics *, const char *name);
+bool optics_meter_mark(struct optics_lens *, int64_t count);
+
+// Estimates several quantiles with the same estimator as the quantile lens
+// while only drawing a single random number per update. All estimates start
+// from the same estimate and move by the same adjustment value.
+struct optics_quantile_vec
+{
+    size_t len;
+    double quantiles[optics_quantile_vec_len_max];
+    double samples[optics_quantile_vec_len_max];
+    size_t count;
+};
+
+struct optics_lens * optics_quantile_vec_alloc(
+        struct optics *, const char *name,
+        const double *quantiles, size_t len, double estimate, double adjustment_value);
+struct optics_lens * optics_quantile_vec_alloc_get(
+        struct optics *, const char *name,
+        const double *quantiles, size_t len, double estimate, double adjustment_value);
+bool optics_quantile_vec_update(struct optics_lens *, double value);
+bool optics_quantile_vec_update_n(struct optics_lens *, const double *values, size_t n);
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+// Typed handles resolve the type of a lens once when they're opened and cache a
+// pointer to its data which removes the type check from the record path. They
+// are plain values that can be freely copied and are only valid for as long as
+// the lens they were opened from.
+
+typedef struct { struct optics *optics; struct lens_counter *counter; } optics_counter_t;
+bool optics_counter_typed(struct optics_lens *, optics_counter_t *);
+void optics_counter_typed_inc(optics_counter_t, int64_t value);
+
+typedef struct { struct optics *optics; struct lens_gauge *gauge; } optics_gauge_t;
+bool optics_gauge_typed(struct optics_lens *, optics_gauge_t *);
+void optics_gauge_typed_set(optics_gauge_t, double value);
+void optics_gauge_typed_add(optics_gauge_t, double delta);
+
+typedef struct { struct optics *optics; struct lens_dist *dist; } optics_dist_t;
+bool optics_dist_typed(struct optics_lens *, optics_dist_t *);
+void optics_dist_typed_record(optics_dist_t, double value);
+void optics_dist_typed_record_exemplar(optics_dist_t, double value, uint64_t exemplar);
+
+typedef struct { struct optics *optics; struct lens_histo *histo; } optics_histo_t;
+bool optics_histo_typed(struct optics_lens *, optics_histo_t *);
+void optics_histo_typed_inc(optics_histo_t, double value);
+void optics_histo_typed_inc_exemplar(optics_histo_t, double value, uint64_t exemplar);
+
+typedef struct { struct optics *optics; struct lens_quantile *quantile; } optics_quantile_t;
+bool optics_quantile_typed(struct optics_lens *, optics_quantile_t *);
+void optics_quantile_typed_update(optics_quantile_t, double value);
+
+typedef struct { struct optics *optics; struct lens_hdr *hdr; } optics_hdr_t;
+bool optics_hdr_typed(struct optics_lens *, optics_hdr_t *);
+void optics_hdr_typed_record(optics_hdr_t, uint64_t value);
+
+typedef struct { struct optics *optics; struct lens_sketch *sketch; } optics_sketch_t;
+bool optics_sketch_typed(struct optics_lens *, optics_sketch_t *);
+void optics_sketch_typed_record(optics_sketch_t, double value);
+
+typedef struct { struct optics *optics; struct lens_hll *hll; } optics_hll_t;
+bool optics_hll_typed(struct optics_lens *, optics_hll_t *);
+void optics_hll_typed_record(optics_hll_t, uint64_t value);
+
+typedef struct { struct optics *optics; struct lens_topk *topk; } optics_topk_t;
+bool optics_topk_typed(struct optics_lens *, optics_topk_t *);
+bool optics_topk_typed_inc(optics_topk_t, const char *item, uint64_t value);
+
+typedef struct { struct optics *optics; struct lens_summary *summary; } optics_summary_t;
+bool optics_summary_typed(struct optics_lens *, optics_summary_t *);
+void optics_summary_typed_record(optics_summary_t, double value);
+
+typedef struct { struct optics *optics; struct lens_counter_vec *vec; } optics_counter_vec_t;
+bool optics_counter_vec_typed(struct optics_lens *, optics_counter_vec_t *);
+bool optics_counter_vec_typed_inc(optics_counter_vec_t, size_t index, int64_t value);
+
+typedef struct { struct optics *optics; struct lens_heatmap *heatmap; } optics_heatmap_t;
+bool optics_heatmap_typed(struct optics_lens *, optics_heatmap_t *);
+void optics_heatmap_typed_inc(optics_heatmap_t, double x, double y);
+
+typedef struct { struct optics *optics; struct lens_event *event; } optics_event_t;
+bool optics_event_typed(struct optics_lens *, optics_event_t *);
+void optics_event_typed_record(optics_event_t, uint64_t id, double value);
+
+typedef struct { struct optics *optics; struct lens_tsc *tsc; } optics_tsc_t;
+bool optics_tsc_typed(struct optics_lens *, optics_tsc_t *);
+void optics_tsc_typed_record(optics_tsc_t, uint64_t cycles);
+
+typedef struct { struct optics *optics; struct lens_meter *meter; } optics_meter_t;
+bool optics_meter_typed(struct optics_lens *, optics_meter_t *);
+void optics_meter_typed_mark(optics_meter_t, int64_t count);
+
+typedef struct { struct optics *optics; struct lens_quantile_vec *vec; } optics_quantile_vec_t;
+bool optics_quantile_vec_typed(struct optics_lens *, optics_quantile_vec_t *);
+void optics_quantile_vec_typed_update(optics_quantile_vec_t, double value);
+
+
+// -----------------------------------------------------------------------------
+// batch
+// -----------------------------------------------------------------------------
+
+// Accumulates records for a counter, dist or histo lens in local memory without
+// any atomic operations. Values are committed to the lens when a change of
+// epoch is detected on the next record or when flushed explicitly. Batches are
+// not thread-safe so each thread should have its own and since commits are only
+// triggered by records, idle threads should flush their batches periodically.
+// The lens must outlive the batch.
+
+struct optics_batch;
+
+struct optics_batch * optics_batch_alloc(struct optics_lens *);
+void optics_batch_free(struct optics_batch *);
+bool optics_batch_flush(struct optics_batch *);
+
+bool optics_batch_counter_inc(struct optics_batch *, int64_t value);
+bool optics_batch_histo_inc(struct optics_batch *, double value);
+bool optics_batch_dist_record(struct optics_batch *, double value);
 
 
 // -----------------------------------------------------------------------------
@@ -171,6 +645,7 @@ struct optics_key
 
 size_t optics_key_push(struct optics_key *key, const char *suffix);
 size_t optics_key_pushf(struct optics_key *key, const char *fmt, ...);
+size_t optics_key_push_sanitized(struct optics_key *key, const char *suffix);
 void optics_key_pop(struct optics_key *key, size_t pos);
 
 
@@ -195,13 +670,28 @@ inline double optics_timer_elapsed(optics_timer_t *t0, double scale)
     struct timespec t1;
     if (clock_gettime(CLOCK_MONOTONIC, &t1)) abort();
 
-    const uint64_t nano_sec = 1UL * 1000 * 1000 * 1000;
+    const int64_t nano_sec = 1L * 1000 * 1000 * 1000;
+
+    // The nanos difference goes negative when the seconds roll over which
+    // borrows from the seconds difference.
+    int64_t nanos =
+        (t1.tv_sec - t0->tv_sec) * nano_sec + (t1.tv_nsec - t0->tv_nsec);
+    return nanos * scale;
+}
 
-    uint64_t secs = t1.tv_sec - t0->tv_sec;
-    uint64_t nanos = secs ?
-        (nano_sec - t1.tv_nsec) + t0->tv_nsec :
-        (uint64_t) (t1.tv_nsec - t0->tv_nsec);
-    return (secs * nano_sec + nanos) * scale;
+// Reads the tsc of the current cpu which is far cheaper than a clock_gettime
+// call. Deltas are meant to be recorded in a tsc lens. Platforms without a tsc
+// fall back on the monotonic clock in nanoseconds which the calibration picks
+// up like any other tick rate.
+inline uint64_t optics_rdtsc(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts)) abort();
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+#endif
 }
 
 
@@ -216,8 +706,21 @@ union optics_poll_value
      struct optics_dist dist;
      struct optics_histo histo;
      struct optics_quantile quantile;
+     struct optics_hdr hdr;
+     struct optics_sketch sketch;
+     struct optics_hll hll;
+     struct optics_topk topk;
+     struct optics_summary summary;
+     struct optics_counter_vec counter_vec;
+     struct optics_heatmap heatmap;
+     struct optics_event event;
+     struct optics_tsc tsc;
+     struct optics_meter meter;
+     struct optics_quantile_vec quantile_vec;
 };
 
+// The poller only allocates enough space for the value of the lens type so the
+// value must remain the last field and polls can't be copied by value.
 struct optics_poll
 {
     const char *host;
@@ -225,10 +728,11 @@ struct optics_poll
     const char *key;
 
     enum optics_lens_type type;
-    union optics_poll_value value;
 
     optics_ts_t ts;
     optics_ts_t elapsed;
+
+    union optics_poll_value value;
 };
 
 typedef bool (*optics_normalize_cb_t) (
@@ -0,0 +1,84 @@
+/* optics_inline.h
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+
+   Header-only record path for the hottest lenses. Opening an inline handle
+   resolves the lens into raw pointers into the region which can then be
+   recorded into without calling into the library: one epoch load and one
+   atomic operation.
+
+   Handles are only valid for as long as the lens they were opened from.
+*/
+
+#pragma once
+
+#include "optics.h"
+
+#include <stdatomic.h>
+
+
+// -----------------------------------------------------------------------------
+// abi
+// -----------------------------------------------------------------------------
+
+// Layout of the region that the inline functions were compiled against. It is
+// the version stored in the region header and opening a handle on a region with
+// a different version fails.
+enum { optics_inline_abi = 3 };
+
+
+// -----------------------------------------------------------------------------
+// counter
+// -----------------------------------------------------------------------------
+
+// Striped counters are not supported.
+struct optics_inline_counter
+{
+    atomic_size_t *epoch;
+    atomic_int_fast64_t *value;
+};
+
+bool optics_inline_counter_open_abi(
+        struct optics_lens *, struct optics_inline_counter *, uint64_t abi);
+
+#define optics_inline_counter_open(lens, counter)                       \
+    optics_inline_counter_open_abi(lens, counter, optics_inline_abi)
+
+inline void optics_inline_counter_inc(
+        const struct optics_inline_counter *counter, int64_t value)
+{
+    size_t epoch = atomic_load_explicit(counter->epoch, memory_order_acquire) & 1;
+    atomic_fetch_add_explicit(&counter->value[epoch], value, memory_order_relaxed);
+}
+
+
+// -----------------------------------------------------------------------------
+// gauge
+// -----------------------------------------------------------------------------
+
+struct optics_inline_gauge
+{
+    atomic_uint_fast64_t *value;
+};
+
+bool optics_inline_gauge_open_abi(
+        struct optics_lens *, struct optics_inline_gauge *, uint64_t abi);
+
+#define optics_inline_gauge_open(lens, gauge)                           \
+    optics_inline_gauge_open_abi(lens, gauge, optics_inline_abi)
+
+inline void optics_inline_gauge_set(const struct optics_inline_gauge *gauge, double value)
+{
+    uint64_t raw = (union { uint64_t i; double d; }) { .d = value }.i;
+    atomic_store_explicit(gauge->value, raw, memory_order_relaxed);
+}
+
+inline void optics_inline_gauge_add(const struct optics_inline_gauge *gauge, double delta)
+{
+    typedef union { uint64_t i; double d; } pun_t;
+
+    uint64_t old = atomic_load_explicit(gauge->value, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(
+                    gauge->value, &old, (pun_t) { .d = (pun_t) { .i = old }.d + delta }.i,
+                    memory_order_relaxed, memory_order_relaxed));
+}
@@ -41,4 +41,29 @@ enum optics_ret optics_histo_read(
 enum optics_ret optics_quantile_read(
         struct optics_lens *, optics_epoch_t epoch, struct optics_quantile *value);
 
+enum optics_ret optics_hdr_read(
+        struct optics_lens *, optics_epoch_t epoch, struct optics_hdr *value);
+
+enum optics_ret optics_sketch_read(
+        struct optics_lens *, optics_epoch_t epoch, struct optics_sketch *value);
+
+enum optics_ret optics_hll_read(
+        struct optics_lens *, optics_epoch_t epoch, struct optics_hll *value);
+enum optics_ret optics_topk_read(
+        struct optics_lens *, optics_epoch_t epoch, struct optics_topk *value);
+enum optics_ret optics_summary_read(
+        struct optics_lens *, optics_epoch_t epoch, struct optics_summary *value);
+enum optics_ret optics_counter_vec_read(
+        struct optics_lens *, optics_epoch_t epoch, struct optics_counter_vec *value);
+enum optics_ret optics_heatmap_read(
+        struct optics_lens *, optics_epoch_t epoch, struct optics_heatmap *value);
+enum optics_ret optics_event_read(
+        struct optics_lens *, optics_epoch_t epoch, struct optics_event *value);
+enum optics_ret optics_tsc_read(
+        struct optics_lens *, optics_epoch_t epoch, struct optics_tsc *value);
+enum optics_ret optics_meter_read(
+        struct optics_lens *, optics_epoch_t epoch, struct optics_meter *value);
+enum optics_ret optics_quantile_vec_read(
+        struct optics_lens *, optics_epoch_t epoch, struct optics_quantile_vec *value);
+
 
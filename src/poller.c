@@ -43,8 +43,12 @@ struct optics_poller
     
     size_t backends_len;
     struct backend backends[poller_max_backends];
+
+    struct htable meters;
 };
 
+static void poller_meter_reset(struct optics_poller *poller);
+
 
 // -----------------------------------------------------------------------------
 // open/close
@@ -73,6 +77,7 @@ void optics_poller_free(struct optics_poller *poller)
         if (backend->free) backend->free(backend->ctx);
     }
 
+    poller_meter_reset(poller);
     free(poller);
 }
 
@@ -135,4 +140,5 @@ static void poller_backend_record(
 // -----------------------------------------------------------------------------
 
 #include "poller_thread.c"
+#include "poller_meter.c"
 #include "poller_poll.c"
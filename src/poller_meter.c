@@ -0,0 +1,69 @@
+/* poller_meter.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include <math.h>
+
+
+// -----------------------------------------------------------------------------
+// config
+// -----------------------------------------------------------------------------
+
+// Number of polls covered by each moving average.
+static const double poller_meter_windows[] = { 1, 5, 15 };
+enum { poller_meter_windows_len = sizeof(poller_meter_windows) / sizeof(poller_meter_windows[0]) };
+
+
+// -----------------------------------------------------------------------------
+// meter
+// -----------------------------------------------------------------------------
+
+// Moving averages of a meter key which outlive the polls. Keys of meters that
+// are no longer polled keep their state until the poller is freed.
+struct poller_meter
+{
+    double rates[poller_meter_windows_len];
+};
+
+static void poller_meter_reset(struct optics_poller *poller)
+{
+    struct htable_bucket *bucket = htable_next(&poller->meters, NULL);
+    for (; bucket; bucket = htable_next(&poller->meters, bucket))
+        free(pun_itop(bucket->value));
+
+    htable_reset(&poller->meters);
+}
+
+// Each poll is one interval of the moving averages which are seeded with the
+// first rate to avoid a long ramp up from zero. The rate is computed from the
+// count merged across all the processes so it's never summed.
+static void poller_meter_update(
+        struct optics_poller *poller, const char *key, struct optics_poll *poll)
+{
+    struct optics_meter *value = &poll->value.meter;
+    double rate = (double) value->count / poll->elapsed;
+
+    struct poller_meter *meter = NULL;
+    struct htable_ret ret = htable_get(&poller->meters, key);
+
+    if (ret.ok) {
+        meter = pun_itop(ret.value);
+        for (size_t i = 0; i < poller_meter_windows_len; ++i) {
+            double alpha = 1 - exp(-1 / poller_meter_windows[i]);
+            meter->rates[i] += alpha * (rate - meter->rates[i]);
+        }
+    }
+    else {
+        meter = calloc(1, sizeof(*meter));
+        optics_assert_alloc(meter);
+        for (size_t i = 0; i < poller_meter_windows_len; ++i) meter->rates[i] = rate;
+
+        ret = htable_put(&poller->meters, key, pun_ptoi(meter));
+        optics_assert(ret.ok, "unable to insert '%s' in meter table", key);
+    }
+
+    value->rate_1 = meter->rates[0];
+    value->rate_5 = meter->rates[1];
+    value->rate_15 = meter->rates[2];
+}
@@ -46,6 +46,31 @@ struct poller_poll_ctx
 // -----------------------------------------------------------------------------
 
 
+// Values vary wildly in size between lens types so we avoid allocating and
+// zeroing the full union for every lens.
+static size_t poller_value_len(enum optics_lens_type type)
+{
+    switch (type) {
+    case optics_counter: return sizeof(int64_t);
+    case optics_gauge: return sizeof(double);
+    case optics_dist: return sizeof(struct optics_dist);
+    case optics_histo: return sizeof(struct optics_histo);
+    case optics_quantile: return sizeof(struct optics_quantile);
+    case optics_hdr: return sizeof(struct optics_hdr);
+    case optics_sketch: return sizeof(struct optics_sketch);
+    case optics_hll: return sizeof(struct optics_hll);
+    case optics_topk: return sizeof(struct optics_topk);
+    case optics_summary: return sizeof(struct optics_summary);
+    case optics_counter_vec: return sizeof(struct optics_counter_vec);
+    case optics_heatmap: return sizeof(struct optics_heatmap);
+    case optics_event: return sizeof(struct optics_event);
+    case optics_tsc: return sizeof(struct optics_tsc);
+    case optics_meter: return sizeof(struct optics_meter);
+    case optics_quantile_vec: return sizeof(struct optics_quantile_vec);
+    default: return sizeof(union optics_poll_value);
+    }
+}
+
 static struct optics_poll *poller_get_value(
         struct poller_poll_ctx *ctx,
         struct optics_lens *lens,
@@ -62,19 +87,19 @@ static struct optics_poll *poller_get_value(
         return poll;
     }
 
-    struct optics_poll *poll = calloc(1, sizeof(*poll));
+    enum optics_lens_type type = optics_lens_type(lens);
+    struct optics_poll *poll =
+        calloc(1, offsetof(struct optics_poll, value) + poller_value_len(type));
     optics_assert_alloc(poll);
 
-    *poll = (struct optics_poll) {
-        .type = optics_lens_type(lens),
+    poll->type = type;
 
-        .host = ctx->host,
-        .prefix = ctx->prefix,
-        .key = optics_lens_name(lens),
+    poll->host = ctx->host;
+    poll->prefix = ctx->prefix;
+    poll->key = optics_lens_name(lens);
 
-        .ts = ctx->ts,
-        .elapsed = ctx->elapsed,
-    };
+    poll->ts = ctx->ts;
+    poll->elapsed = ctx->elapsed;
 
     ret = htable_put(ctx->values, key->data, pun_ptoi(poll));
     optics_assert(ret.ok, "unable to insert '%s' in value table", key->data);
@@ -114,6 +139,50 @@ static enum optics_ret poller_poll_lens(void *ctx_, struct optics_lens *lens)
         ret = optics_quantile_read(lens, ctx->epoch, &poll->value.quantile);
         break;
 
+    case optics_hdr:
+        ret = optics_hdr_read(lens, ctx->epoch, &poll->value.hdr);
+        break;
+
+    case optics_sketch:
+        ret = optics_sketch_read(lens, ctx->epoch, &poll->value.sketch);
+        break;
+
+    case optics_hll:
+        ret = optics_hll_read(lens, ctx->epoch, &poll->value.hll);
+        break;
+
+    case optics_topk:
+        ret = optics_topk_read(lens, ctx->epoch, &poll->value.topk);
+        break;
+
+    case optics_summary:
+        ret = optics_summary_read(lens, ctx->epoch, &poll->value.summary);
+        break;
+
+    case optics_counter_vec:
+        ret = optics_counter_vec_read(lens, ctx->epoch, &poll->value.counter_vec);
+        break;
+
+    case optics_heatmap:
+        ret = optics_heatmap_read(lens, ctx->epoch, &poll->value.heatmap);
+        break;
+
+    case optics_event:
+        ret = optics_event_read(lens, ctx->epoch, &poll->value.event);
+        break;
+
+    case optics_tsc:
+        ret = optics_tsc_read(lens, ctx->epoch, &poll->value.tsc);
+        break;
+
+    case optics_meter:
+        ret = optics_meter_read(lens, ctx->epoch, &poll->value.meter);
+        break;
+
+    case optics_quantile_vec:
+        ret = optics_quantile_vec_read(lens, ctx->epoch, &poll->value.quantile_vec);
+        break;
+
     default:
         optics_fail("unknown poller type '%d'", poll->type);
         ret = optics_err;
@@ -214,6 +283,8 @@ bool optics_poller_poll_at(struct optics_poller *poller, optics_ts_t ts)
     struct htable_bucket *bucket;
     for (bucket = htable_next(&values, NULL); bucket; bucket = htable_next(&values, bucket)) {
         struct optics_poll *poll = pun_itop(bucket->value);
+        if (poll->type == optics_meter) poller_meter_update(poller, bucket->key, poll);
+
         poller_backend_record(poller, optics_poll_metric, poll);
         free(poll);
     }
@@ -6,6 +6,7 @@
 #include "optics.h"
 
 #include <bsd/string.h>
+#include <ctype.h>
 
 // -----------------------------------------------------------------------------
 // key
@@ -41,6 +42,21 @@ size_t optics_key_pushf(struct optics_key *key, const char *fmt, ...)
     return optics_key_push(key, suffix);
 }
 
+// Values recorded at runtime (topk items, labels) can't be trusted to be valid
+// key components so they're sanitized before being pushed: a '.' would split
+// the component in the carbon path and whitespace would split the carbon line.
+size_t optics_key_push_sanitized(struct optics_key *key, const char *suffix)
+{
+    size_t old = optics_key_push(key, suffix);
+
+    for (size_t i = old ? old + 1 : 0; i < key->len; ++i) {
+        unsigned char c = key->data[i];
+        if (c == '.' || isspace(c) || iscntrl(c)) key->data[i] = '_';
+    }
+
+    return old;
+}
+
 void optics_key_pop(struct optics_key *key, size_t pos)
 {
     optics_assert(pos <= key->len, "invalid key pop: %lu > %lu", pos, key->len);
@@ -16,6 +16,15 @@ size_t cpus()
     optics_abort();
 }
 
+// Falls back on the thread id if the kernel can't tell us which cpu we're on
+// which is good enough to spread threads across the per-cpu lens stripes.
+size_t cpu_current()
+{
+    int cpu = sched_getcpu();
+    if (optics_likely(cpu >= 0)) return cpu;
+    return tid();
+}
+
 
 // -----------------------------------------------------------------------------
 // tid
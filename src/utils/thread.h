@@ -10,6 +10,7 @@
 // -----------------------------------------------------------------------------
 
 size_t cpus();
+size_t cpu_current();
 size_t tid();
 
 void run_threads(void (*fn) (size_t, void *), void *data, size_t n);
@@ -32,6 +32,29 @@ uint64_t clock_rdtsc()
     return msb << 32 | lsb;
 }
 
+// Returns the number of nanoseconds per tick of optics_rdtsc by timing
+// the counter against the monotonic clock. Assumes an invariant tsc which is
+// the norm on any amd64 cpu from the last decade. Preemptions during the
+// calibration are harmless since both clocks keep ticking while we're away.
+double clock_rdtsc_nanos()
+{
+    static const uint64_t calibration_nanos = 1UL * 1000 * 1000;
+
+    struct timespec t0, t1;
+    clock_monotonic(&t0);
+    uint64_t c0 = optics_rdtsc();
+
+    uint64_t nanos = 0;
+    uint64_t c1 = c0;
+    do {
+        clock_monotonic(&t1);
+        c1 = optics_rdtsc();
+        nanos = (t1.tv_sec - t0.tv_sec) * 1000000000UL + (t1.tv_nsec - t0.tv_nsec);
+    } while (nanos < calibration_nanos);
+
+    return (double) nanos / (c1 - c0);
+}
+
 
 // -----------------------------------------------------------------------------
 // sleep
@@ -25,6 +25,7 @@ typedef uint64_t optics_ts_t;
 
 optics_ts_t clock_wall();
 optics_ts_t clock_rdtsc();
+double clock_rdtsc_nanos();
 
 inline void clock_monotonic(struct timespec *ts)
 {
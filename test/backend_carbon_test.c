@@ -108,6 +108,105 @@ optics_test_head(backend_carbon_internal_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// exemplar
+// -----------------------------------------------------------------------------
+
+optics_test_head(backend_carbon_exemplar_test)
+{
+    const char *port = "12346";
+    struct carbon *carbon = carbon_start(port);
+
+    struct optics *optics = optics_create(test_name);
+    optics_set_prefix(optics, "prefix");
+
+    struct optics_lens *dist = optics_dist_alloc(optics, "dist");
+    const uint64_t buckets[] = {1, 2, 3};
+    struct optics_lens *histo = optics_histo_alloc_exemplars(optics, "histo", buckets, 3);
+
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_dump_carbon(poller, "127.0.0.1", port);
+
+    for (size_t it = 0; it < 10; ++it) {
+        for (size_t i = 0; i < 99; ++i) optics_dist_record(dist, i);
+        optics_dist_record_exemplar(dist, 99, 42);
+        for (size_t i = 0; i < 99; ++i) optics_histo_inc(histo, i % 5);
+        optics_histo_inc_exemplar(histo, 4, 7);
+
+        if (!optics_poller_poll(poller)) optics_abort();
+        nsleep(1 * 1000 * 1000);
+
+        struct htable result = {0};
+        carbon_parse(carbon, &result);
+        assert_htable_equal(&result, 0,
+                make_kv("prefix.host.dist.p50", 50),
+                make_kv("prefix.host.dist.p90", 90),
+                make_kv("prefix.host.dist.p99", 99),
+                make_kv("prefix.host.dist.max", 99),
+                make_kv("prefix.host.dist.count", 100),
+                make_kv("prefix.host.dist.exemplar.42", 99),
+                make_kv("prefix.host.histo.bucket_1_2", 20),
+                make_kv("prefix.host.histo.bucket_2_3", 20),
+                make_kv("prefix.host.histo.below", 20),
+                make_kv("prefix.host.histo.above", 40),
+                make_kv("prefix.host.histo.exemplar.above.7", 1));
+
+        htable_reset(&result);
+    }
+
+    optics_poller_free(poller);
+    optics_lens_close(dist);
+    optics_lens_close(histo);
+    optics_close(optics);
+    carbon_stop(carbon);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// topk
+// -----------------------------------------------------------------------------
+
+optics_test_head(backend_carbon_topk_test)
+{
+    const char *port = "12347";
+    struct carbon *carbon = carbon_start(port);
+
+    struct optics *optics = optics_create(test_name);
+    optics_set_prefix(optics, "prefix");
+
+    struct optics_lens *topk = optics_topk_alloc(optics, "topk", 10);
+
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_dump_carbon(poller, "127.0.0.1", port);
+
+    for (size_t it = 0; it < 10; ++it) {
+        // Items that would otherwise break the carbon path or line.
+        optics_topk_inc(topk, "a.b", 2);
+        optics_topk_inc(topk, "c d", 1);
+
+        if (!optics_poller_poll(poller)) optics_abort();
+        nsleep(1 * 1000 * 1000);
+
+        struct htable result = {0};
+        carbon_parse(carbon, &result);
+        assert_htable_equal(&result, 0,
+                make_kv("prefix.host.topk.a_b", 2),
+                make_kv("prefix.host.topk.c_d", 1));
+
+        htable_reset(&result);
+    }
+
+    optics_poller_free(poller);
+    optics_lens_close(topk);
+    optics_close(optics);
+    carbon_stop(carbon);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // external
 // -----------------------------------------------------------------------------
@@ -156,6 +255,8 @@ int main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(backend_carbon_internal_test),
+        cmocka_unit_test(backend_carbon_exemplar_test),
+        cmocka_unit_test(backend_carbon_topk_test),
         cmocka_unit_test(backend_carbon_external_test),
     };
 
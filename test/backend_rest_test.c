@@ -52,6 +52,82 @@ optics_test_head(backend_rest_basics_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// exemplar
+// -----------------------------------------------------------------------------
+
+optics_test_head(backend_rest_exemplar_test)
+{
+    enum { port = 64124 };
+    const char *path = "/metrics/json";
+
+    struct optics *optics = optics_create(test_name);
+    optics_set_prefix(optics, "optics.tests");
+
+    struct optics_lens *dist = optics_dist_alloc(optics, "dist");
+    const uint64_t buckets[] = {1, 2, 3};
+    struct optics_lens *histo = optics_histo_alloc_exemplars(optics, "histo", buckets, 3);
+
+    struct crest *crest = crest_new();
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_dump_rest(poller, crest);
+    crest_bind(crest, port);
+
+    for (size_t it = 0; it < 10; ++it) {
+        for (size_t i = 0; i < 99; ++i) optics_dist_record(dist, i);
+        optics_dist_record_exemplar(dist, 99, 42);
+        optics_histo_inc_exemplar(histo, 2, 7);
+
+        if (!optics_poller_poll(poller)) optics_abort();
+
+        assert_http_code(port, "GET", path, 200);
+    }
+
+    crest_free(crest);
+    optics_poller_free(poller);
+    optics_lens_close(dist);
+    optics_lens_close(histo);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// topk
+// -----------------------------------------------------------------------------
+
+optics_test_head(backend_rest_topk_test)
+{
+    enum { port = 64125 };
+    const char *path = "/metrics/json";
+
+    struct optics *optics = optics_create(test_name);
+    optics_set_prefix(optics, "optics.tests");
+
+    struct optics_lens *topk = optics_topk_alloc(optics, "topk", 10);
+
+    struct crest *crest = crest_new();
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_dump_rest(poller, crest);
+    crest_bind(crest, port);
+
+    for (size_t it = 0; it < 10; ++it) {
+        // Items need to be escaped to produce valid json.
+        optics_topk_inc(topk, "\"quoted\\item\"", 1);
+
+        if (!optics_poller_poll(poller)) optics_abort();
+
+        assert_http_code(port, "GET", path, 200);
+    }
+
+    crest_free(crest);
+    optics_poller_free(poller);
+    optics_lens_close(topk);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // setup
 // -----------------------------------------------------------------------------
@@ -60,6 +136,8 @@ int main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(backend_rest_basics_test),
+        cmocka_unit_test(backend_rest_exemplar_test),
+        cmocka_unit_test(backend_rest_topk_test),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
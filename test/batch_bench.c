@@ -0,0 +1,192 @@
+/* batch_bench.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "bench.h"
+
+
+struct batch_bench
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+};
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define calc_len(buckets) (sizeof(buckets) / sizeof(typeof((buckets)[0])))
+
+static struct optics_lens *make_histo_lens(struct optics * optics)
+{
+    uint64_t buckets[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    return optics_histo_alloc(optics, "my_histo", buckets, calc_len(buckets));
+}
+
+
+// -----------------------------------------------------------------------------
+// counter
+// -----------------------------------------------------------------------------
+
+void run_counter_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct batch_bench *bench = data;
+    struct optics_batch *batch = optics_batch_alloc(bench->lens);
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i)
+        optics_batch_counter_inc(batch, 1);
+
+    optics_batch_flush(batch);
+    optics_bench_stop(b);
+
+    optics_batch_free(batch);
+}
+
+optics_test_head(batch_counter_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+
+    struct batch_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_counter_bench, &bench);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(batch_counter_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+
+    struct batch_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_counter_bench, &bench);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// histo
+// -----------------------------------------------------------------------------
+
+void run_histo_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    struct batch_bench *bench = data;
+    struct optics_batch *batch = optics_batch_alloc(bench->lens);
+
+    optics_bench_start(b);
+
+    size_t value = id;
+    for (size_t i = 0; i < n; ++i)
+        optics_batch_histo_inc(batch, ++value % 9);
+
+    optics_batch_flush(batch);
+    optics_bench_stop(b);
+
+    optics_batch_free(batch);
+}
+
+optics_test_head(batch_histo_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = make_histo_lens(optics);
+
+    struct batch_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_histo_bench, &bench);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(batch_histo_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = make_histo_lens(optics);
+
+    struct batch_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_histo_bench, &bench);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// dist
+// -----------------------------------------------------------------------------
+
+void run_dist_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct batch_bench *bench = data;
+    struct optics_batch *batch = optics_batch_alloc(bench->lens);
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i)
+        optics_batch_dist_record(batch, i);
+
+    optics_batch_flush(batch);
+    optics_bench_stop(b);
+
+    optics_batch_free(batch);
+}
+
+optics_test_head(batch_dist_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc(optics, "my_dist");
+
+    struct batch_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_dist_bench, &bench);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(batch_dist_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc(optics, "my_dist");
+
+    struct batch_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_dist_bench, &bench);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(batch_counter_bench_st),
+        cmocka_unit_test(batch_counter_bench_mt),
+        cmocka_unit_test(batch_histo_bench_st),
+        cmocka_unit_test(batch_histo_bench_mt),
+        cmocka_unit_test(batch_dist_bench_st),
+        cmocka_unit_test(batch_dist_bench_mt),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
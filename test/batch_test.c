@@ -0,0 +1,266 @@
+/* batch_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define calc_len(buckets) (sizeof(buckets) / sizeof(typeof((buckets)[0])))
+
+#define assert_counter_read(lens, epoch, exp)                           \
+    do {                                                                \
+        int64_t value = 0;                                              \
+        assert_int_equal(optics_counter_read(lens, epoch, &value), optics_ok); \
+        assert_int_equal(value, exp);                                   \
+    } while (false)
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(batch_type_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    {
+        struct optics_lens *lens = optics_gauge_alloc(optics, "gauge");
+        assert_null(optics_batch_alloc(lens));
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_quantile_alloc(optics, "quantile", 0.5, 0, 1);
+        assert_null(optics_batch_alloc(lens));
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_counter_alloc(optics, "counter");
+        struct optics_batch *batch = optics_batch_alloc(lens);
+
+        assert_false(optics_batch_dist_record(batch, 1));
+        assert_false(optics_batch_histo_inc(batch, 1));
+        assert_true(optics_batch_counter_inc(batch, 1));
+
+        optics_batch_free(batch);
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// counter
+// -----------------------------------------------------------------------------
+
+optics_test_head(batch_counter_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "counter");
+    struct optics_batch *batch = optics_batch_alloc(lens);
+
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    for (size_t i = 0; i < 10; ++i) optics_batch_counter_inc(batch, 2);
+    assert_counter_read(lens, epoch, 0);
+
+    assert_true(optics_batch_flush(batch));
+    assert_counter_read(lens, epoch, 20);
+    assert_true(optics_batch_flush(batch));
+    assert_counter_read(lens, epoch, 0);
+
+    // Records are committed to the epoch they were recorded in once we notice
+    // that the epoch changed.
+    optics_batch_counter_inc(batch, 5);
+    epoch = optics_epoch_inc(optics);
+    assert_counter_read(lens, epoch, 0);
+
+    optics_batch_counter_inc(batch, 1);
+    assert_counter_read(lens, epoch, 5);
+    assert_counter_read(lens, epoch ^ 1, 0);
+
+    optics_batch_free(batch);
+    assert_counter_read(lens, epoch ^ 1, 1);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// histo
+// -----------------------------------------------------------------------------
+
+optics_test_head(batch_histo_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    const uint64_t buckets[] = {10, 20, 30};
+    struct optics_lens *lens = optics_histo_alloc(optics, "histo", buckets, calc_len(buckets));
+    struct optics_batch *batch = optics_batch_alloc(lens);
+
+    for (size_t i = 0; i < 40; ++i) assert_true(optics_batch_histo_inc(batch, i));
+    assert_true(optics_batch_flush(batch));
+
+    struct optics_histo value = {0};
+    assert_int_equal(optics_histo_read(lens, optics_epoch(optics), &value), optics_ok);
+
+    assert_int_equal(value.buckets_len, calc_len(buckets));
+    assert_int_equal(value.below, 10);
+    assert_int_equal(value.counts[0], 10);
+    assert_int_equal(value.counts[1], 10);
+    assert_int_equal(value.above, 10);
+
+    optics_batch_free(batch);
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// dist
+// -----------------------------------------------------------------------------
+
+optics_test_head(batch_dist_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc(optics, "dist");
+    struct optics_batch *batch = optics_batch_alloc(lens);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        for (size_t i = 1; i <= 100; ++i) assert_true(optics_batch_dist_record(batch, i));
+        assert_true(optics_batch_flush(batch));
+
+        struct optics_dist value = {0};
+        assert_int_equal(optics_dist_read(lens, epoch, &value), optics_ok);
+        assert_int_equal(value.n, 100);
+        assert_float_equal(value.p50, 51, 0);
+        assert_float_equal(value.p90, 91, 0);
+        assert_float_equal(value.max, 100, 0);
+    }
+
+    {
+        const size_t n = 100 * 1000;
+
+        optics_dist_record(lens, 1);
+        for (size_t i = 0; i < n; ++i) assert_true(optics_batch_dist_record(batch, 10));
+        assert_true(optics_batch_flush(batch));
+
+        struct optics_dist value = {0};
+        assert_int_equal(optics_dist_read(lens, epoch, &value), optics_ok);
+        assert_int_equal(value.n, n + 1);
+        assert_float_equal(value.p50, 10, 0);
+        assert_float_equal(value.max, 10, 0);
+    }
+
+    optics_batch_free(batch);
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch mt
+// -----------------------------------------------------------------------------
+
+struct epoch_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+size_t epoch_test_read_lens(struct epoch_test *test)
+{
+    optics_epoch_t epoch = optics_epoch_inc(test->optics);
+
+    int64_t value = 0;
+    assert_int_equal(optics_counter_read(test->lens, epoch, &value), optics_ok);
+
+    return value;
+}
+
+void run_epoch_test(size_t id, void *ctx)
+{
+    struct epoch_test *test = ctx;
+    enum { iterations = 1000 * 1000 };
+
+    if (id) {
+        struct optics_batch *batch = optics_batch_alloc(test->lens);
+
+        for (size_t i = 0; i < iterations; ++i)
+            optics_batch_counter_inc(batch, 1);
+
+        optics_batch_free(batch);
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+
+    else {
+        size_t done;
+        uint64_t result = 0;
+        size_t writers = test->workers - 1;
+
+        do {
+            result += epoch_test_read_lens(test);
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        // Read whatever is leftover in the remaining epochs
+        for (size_t i = 0; i < 2; ++i)
+            result += epoch_test_read_lens(test);
+
+        // cmocka just plain sucks when it comes to mt.
+        optics_assert(result == writers * iterations, "%lu != %lu",
+                result, writers * iterations);
+    }
+}
+
+optics_test_head(batch_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "counter");
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(batch_type_test),
+        cmocka_unit_test(batch_counter_test),
+        cmocka_unit_test(batch_histo_test),
+        cmocka_unit_test(batch_dist_test),
+        cmocka_unit_test(batch_epoch_mt_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
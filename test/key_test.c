@@ -62,6 +62,30 @@ optics_test_head(overflow_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// sanitized
+// -----------------------------------------------------------------------------
+
+optics_test_head(sanitized_test)
+{
+    struct optics_key key = {0};
+
+    size_t i = optics_key_push_sanitized(&key, "a.b c");
+    assert_string_equal(key.data, "a_b_c");
+
+    size_t j = optics_key_push_sanitized(&key, "d\te\nf.");
+    assert_string_equal(key.data, "a_b_c.d_e_f_");
+
+    optics_key_pop(&key, j);
+    optics_key_push(&key, "g.h");
+    assert_string_equal(key.data, "a_b_c.g.h");
+
+    optics_key_pop(&key, i);
+    assert_string_equal(key.data, "");
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // setup
 // -----------------------------------------------------------------------------
@@ -71,6 +95,7 @@ int main(void)
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(basics_test),
         cmocka_unit_test(overflow_test),
+        cmocka_unit_test(sanitized_test),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -4,6 +4,7 @@
 */
 
 #include "bench.h"
+#include "optics_inline.h"
 
 
 struct counter_bench
@@ -55,6 +56,161 @@ optics_test_head(lens_counter_record_bench_mt)
 optics_test_tail()
 
 
+optics_test_head(lens_counter_record_striped_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc_striped(optics, "my_counter");
+
+    struct counter_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_counter_record_striped_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc_striped(optics, "my_counter");
+
+    struct counter_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed record bench
+// -----------------------------------------------------------------------------
+
+void run_typed_record_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct counter_bench *bench = data;
+
+    optics_counter_t counter;
+    if (!optics_counter_typed(bench->lens, &counter)) optics_abort();
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i)
+        optics_counter_typed_inc(counter, 1);
+}
+
+
+optics_test_head(lens_counter_typed_record_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+
+    struct counter_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_typed_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_counter_typed_record_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+
+    struct counter_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_typed_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// sampled record bench
+// -----------------------------------------------------------------------------
+
+// Reuses the typed record bench on a counter that only records one increment
+// out of 16 which is where the contended mt case should see the difference.
+
+optics_test_head(lens_counter_sampled_record_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+    if (!optics_lens_set_sampling(lens, 16)) optics_abort();
+
+    struct counter_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_typed_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_counter_sampled_record_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+    if (!optics_lens_set_sampling(lens, 16)) optics_abort();
+
+    struct counter_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_typed_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// inline record bench
+// -----------------------------------------------------------------------------
+
+void run_inline_record_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct counter_bench *bench = data;
+
+    struct optics_inline_counter counter;
+    if (!optics_inline_counter_open(bench->lens, &counter)) optics_abort();
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i)
+        optics_inline_counter_inc(&counter, 1);
+}
+
+
+optics_test_head(lens_counter_inline_record_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+
+    struct counter_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_inline_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_counter_inline_record_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+
+    struct counter_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_inline_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // read bench
 // -----------------------------------------------------------------------------
@@ -147,6 +303,14 @@ int main(void)
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(lens_counter_record_bench_st),
         cmocka_unit_test(lens_counter_record_bench_mt),
+        cmocka_unit_test(lens_counter_record_striped_bench_st),
+        cmocka_unit_test(lens_counter_record_striped_bench_mt),
+        cmocka_unit_test(lens_counter_typed_record_bench_st),
+        cmocka_unit_test(lens_counter_typed_record_bench_mt),
+        cmocka_unit_test(lens_counter_sampled_record_bench_st),
+        cmocka_unit_test(lens_counter_sampled_record_bench_mt),
+        cmocka_unit_test(lens_counter_inline_record_bench_st),
+        cmocka_unit_test(lens_counter_inline_record_bench_mt),
         cmocka_unit_test(lens_counter_read_bench_st),
         cmocka_unit_test(lens_counter_read_bench_mt),
         cmocka_unit_test(lens_counter_mixed_bench_mt),
@@ -4,6 +4,7 @@
 */
 
 #include "test.h"
+#include "optics_inline.h"
 
 
 // -----------------------------------------------------------------------------
@@ -79,6 +80,31 @@ optics_test_tail()
 
 // -----------------------------------------------------------------------------
 // record/read
+// -----------------------------------------------------------------------------
+// record_n
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_record_n_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    assert_true(optics_counter_inc_n(lens, NULL, 0));
+    assert_read(lens, epoch, 0);
+
+    const int64_t values[] = { 1, 20, -2 };
+    assert_true(optics_counter_inc_n(lens, values, 3));
+    assert_read(lens, epoch, 19);
+    assert_read(lens, epoch, 0);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 
 optics_test_head(lens_counter_record_read_test)
@@ -121,6 +147,130 @@ optics_test_head(lens_counter_record_read_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// inline
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_inline_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+
+    struct optics_inline_counter counter;
+    assert_true(optics_inline_counter_open(lens, &counter));
+
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_inline_counter_inc(&counter, 1);
+    optics_inline_counter_inc(&counter, 20);
+    optics_counter_inc(lens, -2);
+    assert_read(lens, epoch, 19);
+
+    // Records land in whatever epoch is current.
+    epoch = optics_epoch_inc(optics);
+    optics_inline_counter_inc(&counter, 5);
+    assert_read(lens, epoch, 0);
+    assert_read(lens, optics_epoch(optics), 5);
+
+    assert_false(optics_inline_counter_open_abi(lens, &counter, optics_inline_abi + 1));
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc_striped(optics, "my_striped_counter");
+    assert_false(optics_inline_counter_open(lens, &counter));
+    optics_lens_close(lens);
+
+    lens = optics_gauge_alloc(optics, "my_gauge");
+    assert_false(optics_inline_counter_open(lens, &counter));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+
+    optics_counter_t counter;
+    assert_true(optics_counter_typed(lens, &counter));
+
+    optics_counter_typed_inc(counter, 1);
+    optics_counter_typed_inc(counter, 20);
+    optics_counter_inc(lens, -2);
+    assert_read(lens, epoch, 19);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc_striped(optics, "my_striped_counter");
+    assert_true(optics_counter_typed(lens, &counter));
+
+    optics_counter_typed_inc(counter, 3);
+    assert_read(lens, epoch, 3);
+
+    optics_lens_close(lens);
+
+    lens = optics_gauge_alloc(optics, "my_gauge");
+    assert_false(optics_counter_typed(lens, &counter));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// striped
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_striped_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc_striped(optics, "my_counter");
+    assert_int_equal(optics_lens_type(lens), optics_counter);
+
+    optics_epoch_t epoch = optics_epoch(optics);
+    assert_read(lens, epoch, 0);
+
+    optics_counter_inc(lens, 1);
+    assert_read(lens, epoch, 1);
+    assert_read(lens, epoch, 0);
+
+    optics_counter_inc(lens, 1);
+    optics_counter_inc(lens, 20);
+    optics_counter_inc(lens, -2);
+    assert_read(lens, epoch, 19);
+    assert_read(lens, epoch, 0);
+
+    for (size_t i = 1; i < 5; ++i) {
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+        optics_counter_inc(lens, i);
+        assert_read(lens, epoch, i - 1);
+    }
+
+    {
+        struct optics_lens *other = optics_counter_alloc_get_striped(optics, "my_counter");
+        optics_counter_inc(other, 10);
+
+        epoch = optics_epoch_inc(optics);
+        assert_read(lens, epoch, 14);
+
+        optics_lens_close(other);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // merge
 // -----------------------------------------------------------------------------
@@ -300,6 +450,24 @@ optics_test_head(lens_counter_epoch_mt_test)
 }
 optics_test_tail()
 
+optics_test_head(lens_counter_striped_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_alloc_striped(optics, "my_counter");
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
 
 // -----------------------------------------------------------------------------
 // setup
@@ -311,10 +479,15 @@ int main(void)
         cmocka_unit_test(lens_counter_open_close_test),
         cmocka_unit_test(lens_counter_alloc_get_test),
         cmocka_unit_test(lens_counter_record_read_test),
+        cmocka_unit_test(lens_counter_record_n_test),
+        cmocka_unit_test(lens_counter_inline_test),
+        cmocka_unit_test(lens_counter_typed_test),
+        cmocka_unit_test(lens_counter_striped_test),
         cmocka_unit_test(lens_counter_merge_test),
         cmocka_unit_test(lens_counter_type_test),
         cmocka_unit_test(lens_counter_epoch_st_test),
         cmocka_unit_test(lens_counter_epoch_mt_test),
+        cmocka_unit_test(lens_counter_striped_epoch_mt_test),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,101 @@
+/* lens_counter_vec_bench.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "bench.h"
+
+
+struct counter_vec_bench
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+};
+
+
+// -----------------------------------------------------------------------------
+// record bench
+// -----------------------------------------------------------------------------
+
+void run_record_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct counter_vec_bench *bench = data;
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i)
+        optics_counter_vec_inc(bench->lens, i % 16, 1);
+}
+
+optics_test_head(lens_counter_vec_record_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_vec_alloc(optics, "my_vec", NULL, 16);
+
+    struct counter_vec_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_counter_vec_record_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_vec_alloc(optics, "my_vec", NULL, 16);
+
+    struct counter_vec_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// read bench
+// -----------------------------------------------------------------------------
+
+void run_read_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct counter_vec_bench *bench = data;
+    optics_epoch_t epoch = optics_epoch(bench->optics);
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i) {
+        struct optics_counter_vec value = {0};
+        optics_counter_vec_read(bench->lens, epoch, &value);
+        optics_no_opt_val(value.counts[0]);
+    }
+}
+
+optics_test_head(lens_counter_vec_read_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_vec_alloc(optics, "my_vec", NULL, 16);
+
+    struct counter_vec_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_read_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_counter_vec_record_bench_st),
+        cmocka_unit_test(lens_counter_vec_record_bench_mt),
+        cmocka_unit_test(lens_counter_vec_read_bench_st),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
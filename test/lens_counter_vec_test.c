@@ -0,0 +1,410 @@
+/* lens_counter_vec_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define checked_counter_vec_read(lens, epoch)                           \
+    ({                                                                  \
+        struct optics_counter_vec value = {0};                          \
+        assert_int_equal(optics_counter_vec_read(lens, epoch, &value), optics_ok); \
+        value;                                                          \
+    })
+
+
+// -----------------------------------------------------------------------------
+// open/close
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_vec_open_close_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "my_vec";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *lens = optics_counter_vec_alloc(optics, lens_name, NULL, 4);
+        if (!lens) optics_abort();
+
+        assert_int_equal(optics_lens_type(lens), optics_counter_vec);
+        assert_string_equal(optics_lens_name(lens), lens_name);
+
+        assert_null(optics_counter_vec_alloc(optics, lens_name, NULL, 4));
+        optics_lens_close(lens);
+        assert_null(optics_counter_vec_alloc(optics, lens_name, NULL, 4));
+
+        assert_non_null(lens = optics_lens_get(optics, lens_name));
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// alloc_get
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_vec_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "blah";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *l0 = optics_counter_vec_alloc_get(optics, lens_name, NULL, 4);
+        if (!l0) optics_abort();
+        optics_counter_vec_inc(l0, 1, 1);
+
+        struct optics_lens *l1 = optics_counter_vec_alloc_get(optics, lens_name, NULL, 4);
+        if (!l1) optics_abort();
+        optics_counter_vec_inc(l1, 1, 2);
+
+        struct optics_counter_vec value = checked_counter_vec_read(l0, optics_epoch(optics));
+        assert_int_equal(value.counts[1], 3);
+
+        optics_lens_close(l0);
+        optics_lens_free(l1);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// invalid
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_vec_invalid_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    assert_null(optics_counter_vec_alloc(optics, "blah", NULL, 0));
+    assert_null(optics_counter_vec_alloc(optics, "blah", NULL, optics_counter_vec_slots_max + 1));
+
+    char label[optics_counter_vec_label_max_len + 1] = {0};
+    memset(label, 'a', optics_counter_vec_label_max_len);
+    const char *labels[] = { "ok", label };
+    assert_null(optics_counter_vec_alloc(optics, "blah", labels, 2));
+
+    label[optics_counter_vec_label_max_len - 1] = 0;
+    struct optics_lens *lens = optics_counter_vec_alloc(optics, "blah", labels, 2);
+    assert_non_null(lens);
+
+    assert_true(optics_counter_vec_inc(lens, 1, 1));
+    assert_false(optics_counter_vec_inc(lens, 2, 1));
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record/read
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_vec_record_read_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *labels[] = { "2xx", "4xx", "5xx" };
+    struct optics_lens *lens = optics_counter_vec_alloc(optics, "my_vec", labels, 3);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_counter_vec value = checked_counter_vec_read(lens, epoch);
+    assert_int_equal(value.len, 3);
+    for (size_t i = 0; i < 3; ++i) {
+        assert_string_equal(value.labels[i], labels[i]);
+        assert_int_equal(value.counts[i], 0);
+    }
+
+    for (size_t i = 0; i < 10; ++i) optics_counter_vec_inc(lens, 0, 1);
+    optics_counter_vec_inc(lens, 2, 5);
+    optics_counter_vec_inc(lens, 2, -2);
+
+    value = checked_counter_vec_read(lens, epoch);
+    assert_int_equal(value.counts[0], 10);
+    assert_int_equal(value.counts[1], 0);
+    assert_int_equal(value.counts[2], 3);
+
+    value = checked_counter_vec_read(lens, epoch);
+    for (size_t i = 0; i < 3; ++i) assert_int_equal(value.counts[i], 0);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// labels
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_vec_labels_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_vec_alloc(
+            optics, "my_vec", NULL, optics_counter_vec_slots_max);
+
+    struct optics_counter_vec value = checked_counter_vec_read(lens, optics_epoch(optics));
+    assert_int_equal(value.len, optics_counter_vec_slots_max);
+    assert_string_equal(value.labels[0], "0");
+    assert_string_equal(value.labels[optics_counter_vec_slots_max - 1], "255");
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// merge
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_vec_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *l0 = optics_counter_vec_alloc(optics, "l0", NULL, 2);
+    struct optics_lens *l1 = optics_counter_vec_alloc(optics, "l1", NULL, 2);
+    struct optics_lens *l2 = optics_counter_vec_alloc(optics, "l2", NULL, 3);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_counter_vec_inc(l0, 0, 1);
+    optics_counter_vec_inc(l0, 1, 2);
+    optics_counter_vec_inc(l1, 1, 3);
+
+    struct optics_counter_vec value = {0};
+    assert_int_equal(optics_counter_vec_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_counter_vec_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(value.counts[0], 1);
+    assert_int_equal(value.counts[1], 5);
+
+    assert_int_equal(optics_counter_vec_read(l2, epoch, &value), optics_err);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_lens_close(l2);
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_counter_vec_merge_labels_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *labels_0[] = { "get", "put" };
+    const char *labels_1[] = { "put", "get" };
+    struct optics_lens *l0 = optics_counter_vec_alloc(optics, "l0", labels_0, 2);
+    struct optics_lens *l1 = optics_counter_vec_alloc(optics, "l1", labels_0, 2);
+    struct optics_lens *l2 = optics_counter_vec_alloc(optics, "l2", labels_1, 2);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_counter_vec_inc(l0, 0, 1);
+    optics_counter_vec_inc(l1, 0, 2);
+    optics_counter_vec_inc(l2, 0, 4);
+
+    struct optics_counter_vec value = {0};
+    assert_int_equal(optics_counter_vec_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_counter_vec_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(value.counts[0], 3);
+
+    // Same length but different labels can't be merged by position.
+    assert_int_equal(optics_counter_vec_read(l2, epoch, &value), optics_err);
+    assert_int_equal(value.counts[0], 3);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_lens_close(l2);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_vec_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_vec_alloc(optics, "my_vec", NULL, 4);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_counter_vec_t vec;
+    assert_true(optics_counter_vec_typed(lens, &vec));
+
+    for (size_t i = 0; i < 4; ++i) assert_true(optics_counter_vec_typed_inc(vec, i, i));
+    assert_false(optics_counter_vec_typed_inc(vec, 4, 1));
+
+    struct optics_counter_vec value = checked_counter_vec_read(lens, epoch);
+    for (size_t i = 0; i < 4; ++i) assert_int_equal(value.counts[i], i);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_counter_vec_typed(lens, &vec));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_vec_type_test)
+{
+    const char * lens_name = "blah";
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_counter_vec value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        struct optics_lens *lens = optics_counter_alloc(optics, lens_name);
+
+        assert_false(optics_counter_vec_inc(lens, 0, 1));
+        assert_int_equal(optics_counter_vec_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_lens_get(optics, lens_name);
+
+        assert_false(optics_counter_vec_inc(lens, 0, 1));
+        assert_int_equal(optics_counter_vec_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch st
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_counter_vec_epoch_st_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_vec_alloc(optics, "my_vec", NULL, 2);
+
+    for (size_t i = 1; i < 5; ++i) {
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+        optics_counter_vec_inc(lens, i % 2, i);
+
+        struct optics_counter_vec value = checked_counter_vec_read(lens, epoch);
+        assert_int_equal(value.counts[(i - 1) % 2], i - 1);
+        assert_int_equal(value.counts[i % 2], 0);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch mt
+// -----------------------------------------------------------------------------
+
+struct epoch_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+void epoch_test_read_lens(struct epoch_test *test, struct optics_counter_vec *value)
+{
+    optics_epoch_t epoch = optics_epoch_inc(test->optics);
+    assert_int_equal(optics_counter_vec_read(test->lens, epoch, value), optics_ok);
+}
+
+void run_epoch_test(size_t id, void *ctx)
+{
+    struct epoch_test *test = ctx;
+    enum { iterations = 100 * 1000 };
+
+    if (id) {
+        for (size_t i = 0; i < iterations; ++i)
+            optics_counter_vec_inc(test->lens, i % 4, 1);
+
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+
+    else {
+        size_t done;
+        struct optics_counter_vec value = {0};
+        size_t writers = test->workers - 1;
+
+        do {
+            epoch_test_read_lens(test, &value);
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        // Read whatever is leftover in the remaining epochs
+        for (size_t i = 0; i < 2; ++i)
+            epoch_test_read_lens(test, &value);
+
+        for (size_t i = 0; i < 4; ++i) {
+            int64_t exp = writers * iterations / 4;
+            optics_assert(value.counts[i] == exp,
+                    "%lu: %ld != %ld", i, value.counts[i], exp);
+        }
+    }
+}
+
+optics_test_head(lens_counter_vec_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_counter_vec_alloc(optics, "my_vec", NULL, 4);
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_counter_vec_open_close_test),
+        cmocka_unit_test(lens_counter_vec_alloc_get_test),
+        cmocka_unit_test(lens_counter_vec_invalid_test),
+        cmocka_unit_test(lens_counter_vec_record_read_test),
+        cmocka_unit_test(lens_counter_vec_labels_test),
+        cmocka_unit_test(lens_counter_vec_merge_test),
+        cmocka_unit_test(lens_counter_vec_merge_labels_test),
+        cmocka_unit_test(lens_counter_vec_typed_test),
+        cmocka_unit_test(lens_counter_vec_type_test),
+        cmocka_unit_test(lens_counter_vec_epoch_st_test),
+        cmocka_unit_test(lens_counter_vec_epoch_mt_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -55,6 +55,95 @@ optics_test_head(lens_dist_record_bench_mt)
 optics_test_tail()
 
 
+optics_test_head(lens_dist_record_compact_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_dist_alloc_sized(optics, "my_dist", optics_dist_samples, true);
+
+    struct dist_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_dist_record_decayed_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc_decayed(optics, "my_dist", 1);
+
+    struct dist_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_dist_record_striped_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc_striped(optics, "my_dist");
+
+    struct dist_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record_n bench
+// -----------------------------------------------------------------------------
+
+// Values are recorded in arrays of 64 so that each iteration is still a single
+// value and the numbers are comparable to the record bench.
+void run_record_n_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct dist_bench *bench = data;
+
+    enum { len = 64 };
+    double values[len];
+    for (size_t i = 0; i < len; ++i) values[i] = i;
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; i += len)
+        optics_dist_record_n(bench->lens, values, n - i < len ? n - i : len);
+}
+
+
+optics_test_head(lens_dist_record_n_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc(optics, "my_dist");
+
+    struct dist_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_n_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_dist_record_n_bench_mt)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc(optics, "my_dist");
+
+    struct dist_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_n_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // read bench
 // -----------------------------------------------------------------------------
@@ -67,7 +156,7 @@ void run_read_bench(struct optics_bench *b, void *data, size_t id, size_t n)
 
     optics_bench_start(b);
 
-    struct optics_dist value;
+    struct optics_dist value = {0};
     for (size_t i = 0; i < n; ++i)
         optics_dist_read(bench->lens, epoch, &value);
 }
@@ -86,6 +175,19 @@ optics_test_head(lens_dist_read_bench_st)
 optics_test_tail()
 
 
+optics_test_head(lens_dist_read_compact_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc_sized(optics, "my_dist", 64, true);
+
+    struct dist_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_read_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 optics_test_head(lens_dist_read_bench_mt)
 {
     assert_mt();
@@ -112,7 +214,7 @@ void run_mixed_bench(struct optics_bench *b, void *data, size_t id, size_t n)
     optics_bench_start(b);
 
     if (!id) {
-        struct optics_dist value;
+        struct optics_dist value = {0};
         for (size_t i = 0; i < n; ++i)
             optics_dist_read(bench->lens, epoch, &value);
     }
@@ -147,7 +249,13 @@ int main(void)
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(lens_dist_record_bench_st),
         cmocka_unit_test(lens_dist_record_bench_mt),
+        cmocka_unit_test(lens_dist_record_compact_bench_st),
+        cmocka_unit_test(lens_dist_record_decayed_bench_st),
+        cmocka_unit_test(lens_dist_record_striped_bench_mt),
+        cmocka_unit_test(lens_dist_record_n_bench_st),
+        cmocka_unit_test(lens_dist_record_n_bench_mt),
         cmocka_unit_test(lens_dist_read_bench_st),
+        cmocka_unit_test(lens_dist_read_compact_bench_st),
         cmocka_unit_test(lens_dist_read_bench_mt),
         cmocka_unit_test(lens_dist_mixed_bench_mt),
     };
@@ -99,6 +99,48 @@ optics_test_tail()
 
 // -----------------------------------------------------------------------------
 // record/read - exact
+// -----------------------------------------------------------------------------
+// record_n
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_dist_record_n_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc(optics, "my_dist");
+
+    enum { n = 10 * 1000 };
+    static double values[n];
+    for (size_t i = 0; i < n; ++i) values[i] = i;
+
+    struct optics_dist value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    assert_true(optics_dist_record_n(lens, values, 0));
+    value = checked_dist_read(lens, epoch);
+    assert_dist_equal(value, 0, 0, 0, 0, 0, 0);
+
+    for (size_t max = 10; max <= 200; max *= 10) {
+        assert_true(optics_dist_record_n(lens, values, max));
+
+        value = checked_dist_read(lens, epoch);
+        assert_dist_equal(
+                value, max, p(50, max), p(90, max), p(99, max), max - 1, 1);
+    }
+
+    // Crosses the reservoir boundary within a single call and then keeps
+    // sampling across calls.
+    for (size_t i = 0; i < n; i += 1000)
+        assert_true(optics_dist_record_n(lens, values + i, 1000));
+
+    value = checked_dist_read(lens, epoch);
+    assert_dist_equal(value, n, p(50, n), p(90, n), p(99, n), n - 1, n / 10);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 
 optics_test_head(lens_dist_record_read_exact_test)
@@ -148,6 +190,344 @@ optics_test_head(lens_dist_record_read_exact_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_dist_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc(optics, "my_dist");
+
+    struct optics_dist value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_dist_t dist;
+    assert_true(optics_dist_typed(lens, &dist));
+
+    for (size_t max = 10; max <= 200; max *= 10) {
+        for (size_t i = 0; i < max; ++i) optics_dist_typed_record(dist, i);
+
+        value = checked_dist_read(lens, epoch);
+        assert_dist_equal(
+                value, max, p(50, max), p(90, max), p(99, max), max - 1, 1);
+    }
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_dist_typed(lens, &dist));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// striped
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_dist_striped_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc_striped(optics, "my_dist");
+    assert_int_equal(optics_lens_type(lens), optics_dist);
+
+    struct optics_dist value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    value = checked_dist_read(lens, epoch);
+    assert_dist_equal(value, 0, 0, 0, 0, 0, 0);
+
+    for (size_t max = 10; max <= 200; max *= 10) {
+        for (size_t i = 0; i < max; ++i) {
+            assert_true(optics_dist_record(lens, i));
+        }
+
+        value = checked_dist_read(lens, epoch);
+        assert_dist_equal(
+                value, max, p(50, max), p(90, max), p(99, max), max - 1, 1);
+
+        value = checked_dist_read(lens, epoch);
+        assert_dist_equal(value, 0, 0, 0, 0, 0, 0);
+    }
+
+    {
+        struct optics_lens *other = optics_dist_alloc_get_striped(optics, "my_dist");
+        for (size_t i = 0; i < 10; ++i) optics_dist_record(other, 1);
+
+        value = checked_dist_read(lens, epoch);
+        assert_dist_equal(value, 10, 1, 1, 1, 1, 0);
+
+        optics_lens_close(other);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// sized
+// -----------------------------------------------------------------------------
+
+static void test_sized(struct optics *optics, size_t len, bool compact)
+{
+    optics_log("test", "len=%lu, compact=%d", len, compact);
+
+    struct optics_lens *lens = optics_dist_alloc_sized(optics, "my_dist", len, compact);
+    if (!lens) optics_abort();
+
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    for (size_t i = 0; i < len; ++i) assert_true(optics_dist_record(lens, i));
+
+    struct optics_dist value = checked_dist_read(lens, epoch);
+    assert_int_equal(value.reservoir_len, len);
+    assert_dist_equal(value, len, p(50, len), p(90, len), p(99, len), len - 1, 1);
+
+    // Goes through the skip counts, record_n and batch commits which must all
+    // stay within the bounds of the reservoir.
+    enum { range = 1000 };
+    double values[range];
+    for (size_t i = 0; i < range; ++i) values[i] = i;
+
+    struct optics_batch *batch = optics_batch_alloc(lens);
+    for (size_t i = 0; i < range; ++i) {
+        optics_dist_record(lens, i);
+        optics_batch_dist_record(batch, i);
+    }
+    optics_batch_free(batch);
+    assert_true(optics_dist_record_n(lens, values, range));
+
+    value = checked_dist_read(lens, epoch);
+    assert_int_equal(value.reservoir_len, len);
+    assert_int_equal(value.n, 3 * range);
+    assert_float_equal(value.max, range - 1, 0);
+    for (size_t i = 0; i < len; ++i) assert_true(value.samples[i] < range);
+
+    // Compact reservoirs only have the precision of a float.
+    const double sample = 0.1;
+    optics_dist_record(lens, sample);
+
+    value = checked_dist_read(lens, epoch);
+    assert_int_equal(value.n, 1);
+    assert_true(value.samples[0] == (compact ? (float) sample : sample));
+
+    optics_lens_free(lens);
+}
+
+optics_test_head(lens_dist_sized_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    assert_null(optics_dist_alloc_sized(optics, "my_dist", optics_dist_samples_min - 1, false));
+    assert_null(optics_dist_alloc_sized(optics, "my_dist", optics_dist_samples_max + 1, false));
+
+    test_sized(optics, optics_dist_samples_min, false);
+    test_sized(optics, optics_dist_samples_min + 1, true);
+    test_sized(optics, 64, false);
+    test_sized(optics, 64, true);
+    test_sized(optics, optics_dist_samples_max, false);
+    test_sized(optics, optics_dist_samples_max, true);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_dist_sized_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_lens *l0 = optics_dist_alloc_get_sized(optics, "l0", 64, true);
+    struct optics_lens *l1 = optics_dist_alloc_get_sized(optics, "l1", 64, false);
+    struct optics_lens *l2 = optics_dist_alloc(optics, "l2");
+
+    for (size_t i = 0; i < 100; ++i) {
+        optics_dist_record(l0, i);
+        optics_dist_record(l1, i + 100);
+        optics_dist_record(l2, i);
+    }
+
+    // Compact and regular reservoirs of the same size can be merged.
+    struct optics_dist value = {0};
+    assert_int_equal(optics_dist_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_dist_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(value.n, 200);
+    assert_int_equal(value.reservoir_len, 64);
+    assert_float_equal(value.max, 199, 0);
+
+    assert_int_equal(optics_dist_read(l2, epoch, &value), optics_err);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_lens_close(l2);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// decayed
+// -----------------------------------------------------------------------------
+
+static size_t count_samples(const struct optics_dist *value, double sample)
+{
+    size_t count = 0;
+    size_t len = value->n < value->reservoir_len ? value->n : value->reservoir_len;
+    for (size_t i = 0; i < len; ++i) count += value->samples[i] == sample;
+    return count;
+}
+
+// Half-life of 100us which makes records from 10ms ago negligible.
+static const double decayed_half_life = 100e-6;
+static const uint64_t decayed_sleep = 10 * 1000 * 1000;
+
+optics_test_head(lens_dist_decayed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    assert_null(optics_dist_alloc_decayed(optics, "my_dist", 0));
+    assert_null(optics_dist_alloc_decayed(optics, "my_dist", -1));
+
+    struct optics_lens *lens = optics_dist_alloc_decayed(optics, "my_dist", decayed_half_life);
+    if (!lens) optics_abort();
+    assert_null(optics_batch_alloc(lens));
+
+    // Reservoirs that aren't full hold every record regardless of their weight.
+    for (size_t i = 0; i < 100; ++i) assert_true(optics_dist_record(lens, i));
+
+    struct optics_dist value = checked_dist_read(lens, epoch);
+    assert_dist_equal(value, 100, 50, 90, 99, 99, 0);
+    assert_float_equal(value.half_life, decayed_half_life, 0);
+
+    // Recent records dominate the reservoir even if they're outnumbered.
+    const size_t len = optics_dist_samples;
+    for (size_t i = 0; i < 10 * len; ++i) optics_dist_record(lens, 1);
+    nsleep(decayed_sleep);
+    for (size_t i = 0; i < 5 * len; ++i) optics_dist_record(lens, 2);
+
+    value = checked_dist_read(lens, epoch);
+    assert_dist_equal(value, 15 * len, 2, 2, 2, 2, 0);
+    assert_true(count_samples(&value, 1) < len / 10);
+
+    // Same thing but through record_n.
+    double values[len];
+    for (size_t i = 0; i < len; ++i) values[i] = 1;
+    for (size_t i = 0; i < 10; ++i) optics_dist_record_n(lens, values, len);
+    nsleep(decayed_sleep);
+    for (size_t i = 0; i < len; ++i) values[i] = 2;
+    for (size_t i = 0; i < 5; ++i) optics_dist_record_n(lens, values, len);
+
+    value = checked_dist_read(lens, epoch);
+    assert_dist_equal(value, 15 * len, 2, 2, 2, 2, 0);
+    assert_true(count_samples(&value, 1) < len / 10);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_dist_decayed_merge_test)
+{
+    struct optics *o0 = optics_create("lens_dist_decayed_merge_test_0");
+    struct optics *o1 = optics_create("lens_dist_decayed_merge_test_1");
+    optics_epoch_t epoch = optics_epoch(o0);
+    assert_int_equal(optics_epoch(o1), epoch);
+
+    const size_t len = optics_dist_samples;
+    struct optics_lens *l0 = optics_dist_alloc_decayed(o0, "my_dist", decayed_half_life);
+    struct optics_lens *l1 = optics_dist_alloc_decayed(o1, "my_dist", decayed_half_life);
+
+    // The old region is merged based on its weight and not on its count.
+    for (size_t i = 0; i < 10 * len; ++i) optics_dist_record(l0, 1);
+    nsleep(decayed_sleep);
+    for (size_t i = 0; i < 2 * len; ++i) optics_dist_record(l1, 2);
+
+    struct optics_dist value = {0};
+    assert_int_equal(optics_dist_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_dist_read(l1, epoch, &value), optics_ok);
+    assert_dist_equal(value, 12 * len, 2, 2, 2, 2, 0);
+    assert_true(count_samples(&value, 1) < len / 10);
+
+    // Reservoirs that aren't full are merged record by record.
+    for (size_t i = 0; i < len / 2; ++i) optics_dist_record(l0, 1);
+    nsleep(decayed_sleep);
+    for (size_t i = 0; i < len; ++i) optics_dist_record(l1, 2);
+
+    value = (struct optics_dist) {0};
+    assert_int_equal(optics_dist_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(optics_dist_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(value.n, len + len / 2);
+    assert_true(count_samples(&value, 1) < len / 10);
+
+    // Uniform and decayed reservoirs can't be merged.
+    struct optics_lens *l2 = optics_dist_alloc(o1, "my_uniform_dist");
+    optics_dist_record(l2, 1);
+    optics_dist_record(l1, 1);
+
+    value = (struct optics_dist) {0};
+    assert_int_equal(optics_dist_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(optics_dist_read(l2, epoch, &value), optics_err);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_lens_close(l2);
+    optics_close(o0);
+    optics_close(o1);
+}
+optics_test_tail()
+
+// Records from 10ms ago with a half-life of 1us have a weight far beyond the
+// range of a double relative to fresh records.
+optics_test_head(lens_dist_decayed_stale_merge_test)
+{
+    struct optics *o0 = optics_create("lens_dist_decayed_stale_merge_test_0");
+    struct optics *o1 = optics_create("lens_dist_decayed_stale_merge_test_1");
+    optics_epoch_t epoch = optics_epoch(o0);
+    assert_int_equal(optics_epoch(o1), epoch);
+
+    const double half_life = 1e-6;
+    const size_t len = optics_dist_samples;
+    struct optics_lens *l0 = optics_dist_alloc_decayed(o0, "my_dist", half_life);
+    struct optics_lens *l1 = optics_dist_alloc_decayed(o1, "my_dist", half_life);
+
+    // Full reservoirs in both read orders.
+    for (size_t it = 0; it < 2; ++it) {
+        for (size_t i = 0; i < 10 * len; ++i) optics_dist_record(l0, 1);
+        nsleep(decayed_sleep);
+        for (size_t i = 0; i < 2 * len; ++i) optics_dist_record(l1, 2);
+
+        struct optics_dist value = {0};
+        assert_int_equal(optics_dist_read(it ? l1 : l0, epoch, &value), optics_ok);
+        assert_int_equal(optics_dist_read(it ? l0 : l1, epoch, &value), optics_ok);
+        assert_dist_equal(value, 12 * len, 2, 2, 2, 2, 0);
+        assert_int_equal(count_samples(&value, 1), 0);
+    }
+
+    // A fresh full reservoir merged with a stale partial one.
+    for (size_t i = 0; i < len / 2; ++i) optics_dist_record(l0, 1);
+    nsleep(decayed_sleep);
+    for (size_t i = 0; i < 2 * len; ++i) optics_dist_record(l1, 2);
+
+    struct optics_dist value = {0};
+    assert_int_equal(optics_dist_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(optics_dist_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(value.n, 2 * len + len / 2);
+    assert_int_equal(count_samples(&value, 1), 0);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_close(o0);
+    optics_close(o1);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // record/read - random
 // -----------------------------------------------------------------------------
@@ -219,6 +599,64 @@ optics_test_head(lens_dist_record_read_random_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// sampling
+// -----------------------------------------------------------------------------
+
+// Every record should have the same probability of making it into the
+// reservoir regardless of where it falls in the stream.
+optics_test_head(lens_dist_sampling_test)
+{
+    enum { records = 2000, trials = 1000, deciles = 10 };
+
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc(optics, "my_dist");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    size_t counts[deciles] = {0};
+    for (size_t trial = 0; trial < trials; ++trial) {
+        for (size_t i = 0; i < records; ++i)
+            optics_dist_record(lens, i);
+
+        struct optics_dist value = checked_dist_read(lens, epoch);
+        assert_int_equal(value.n, records);
+
+        for (size_t i = 0; i < optics_dist_samples; ++i)
+            counts[(size_t) value.samples[i] / (records / deciles)]++;
+    }
+
+    double exp = (double) (trials * optics_dist_samples) / deciles;
+    for (size_t i = 0; i < deciles; ++i)
+        assert_float_equal(counts[i], exp, exp * 0.05);
+
+    // Committing a batch resets the skip state which must also preserve the
+    // uniformity of the records that follow it.
+    memset(counts, 0, sizeof(counts));
+    for (size_t trial = 0; trial < trials; ++trial) {
+        struct optics_batch *batch = optics_batch_alloc(lens);
+        for (size_t i = 0; i < records / 2; ++i)
+            optics_batch_dist_record(batch, i);
+        optics_batch_free(batch);
+
+        for (size_t i = records / 2; i < records; ++i)
+            optics_dist_record(lens, i);
+
+        struct optics_dist value = checked_dist_read(lens, epoch);
+        assert_int_equal(value.n, records);
+
+        for (size_t i = 0; i < optics_dist_samples; ++i)
+            counts[(size_t) value.samples[i] / (records / deciles)]++;
+    }
+
+    for (size_t i = 0; i < deciles; ++i)
+        assert_float_equal(counts[i], exp, exp * 0.05);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // merge
 // -----------------------------------------------------------------------------
@@ -425,6 +863,165 @@ optics_test_head(lens_dist_epoch_mt_test)
 }
 optics_test_tail()
 
+optics_test_head(lens_dist_epoch_striped_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc_striped(optics, "my_dist");
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// interval mt
+// -----------------------------------------------------------------------------
+
+struct interval_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    atomic_bool done;
+};
+
+// Reads the active epoch to maximize the contention with the writers which
+// would otherwise only be stragglers. Every read must either be busy or include
+// the marker recorded just before it. A stripe skipped by a read would instead
+// show up in a later interval.
+void run_interval_test(size_t id, void *ctx)
+{
+    struct interval_test *test = ctx;
+    enum { rounds = 1000 };
+
+    if (id) {
+        while (!atomic_load_explicit(&test->done, memory_order_acquire))
+            optics_dist_record(test->lens, 1);
+        return;
+    }
+
+    for (size_t i = 0; i < rounds; ++i) {
+        double marker = 1000 + i;
+        optics_dist_record(test->lens, marker);
+
+        struct optics_dist value = {0};
+        optics_epoch_t epoch = optics_epoch(test->optics);
+
+        enum optics_ret ret;
+        while ((ret = optics_dist_read(test->lens, epoch, &value)) == optics_busy);
+
+        optics_assert(ret == optics_ok, "unable to read dist");
+        optics_assert(value.max == marker, "%g != %g", value.max, marker);
+    }
+
+    atomic_store_explicit(&test->done, true, memory_order_release);
+}
+
+optics_test_head(lens_dist_interval_striped_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_dist_alloc_striped(optics, "my_dist");
+
+    struct interval_test data = { .optics = optics, .lens = lens };
+    run_threads(run_interval_test, &data, cpus());
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// exemplar
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_dist_exemplar_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_lens *lens = optics_dist_alloc(optics, "my_dist");
+    struct optics_dist value = checked_dist_read(lens, epoch);
+    assert_int_equal(value.exemplar, 0);
+
+    // Only the largest tagged value is kept and untagged values are ignored.
+    assert_true(optics_dist_record_exemplar(lens, 5, 1));
+    assert_true(optics_dist_record_exemplar(lens, 50, 2));
+    assert_true(optics_dist_record_exemplar(lens, 20, 3));
+    assert_true(optics_dist_record(lens, 100));
+    assert_true(optics_dist_record_exemplar(lens, 10, 0));
+
+    value = checked_dist_read(lens, epoch);
+    assert_int_equal(value.n, 5);
+    assert_int_equal(value.exemplar, 2);
+    assert_float_equal(value.exemplar_value, 50, 0);
+
+    // Exemplars are reset on read.
+    optics_dist_record(lens, 100);
+    value = checked_dist_read(lens, epoch);
+    assert_int_equal(value.exemplar, 0);
+
+    optics_dist_t dist;
+    assert_true(optics_dist_typed(lens, &dist));
+    optics_dist_typed_record_exemplar(dist, 1, 4);
+    optics_dist_typed_record_exemplar(dist, 2, 5);
+
+    value = checked_dist_read(lens, epoch);
+    assert_int_equal(value.exemplar, 5);
+    assert_float_equal(value.exemplar_value, 2, 0);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_dist_record_exemplar(lens, 1, 1));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_dist_exemplar_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_lens *l0 = optics_dist_alloc(optics, "my_dist_0");
+    struct optics_lens *l1 = optics_dist_alloc_striped(optics, "my_dist_1");
+
+    optics_dist_record_exemplar(l0, 10, 1);
+    optics_dist_record_exemplar(l1, 20, 2);
+    optics_dist_record(l1, 30);
+
+    struct optics_dist value = {0};
+    assert_int_equal(optics_dist_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_dist_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(value.exemplar, 2);
+    assert_float_equal(value.exemplar_value, 20, 0);
+
+    optics_dist_record_exemplar(l0, 10, 1);
+    optics_dist_record(l1, 30);
+
+    value = (struct optics_dist) {0};
+    assert_int_equal(optics_dist_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(optics_dist_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(value.exemplar, 1);
+    assert_float_equal(value.exemplar_value, 10, 0);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_close(optics);
+}
+optics_test_tail()
+
 
 // -----------------------------------------------------------------------------
 // setup
@@ -437,11 +1034,24 @@ int main(void)
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(lens_dist_open_close_test),
         cmocka_unit_test(lens_dist_record_read_exact_test),
+        cmocka_unit_test(lens_dist_typed_test),
+        cmocka_unit_test(lens_dist_striped_test),
         cmocka_unit_test(lens_dist_record_read_random_test),
+        cmocka_unit_test(lens_dist_sampling_test),
         cmocka_unit_test(lens_dist_merge_test),
         cmocka_unit_test(lens_dist_type_test),
         cmocka_unit_test(lens_dist_epoch_st_test),
+        cmocka_unit_test(lens_dist_record_n_test),
         cmocka_unit_test(lens_dist_epoch_mt_test),
+        cmocka_unit_test(lens_dist_epoch_striped_mt_test),
+        cmocka_unit_test(lens_dist_interval_striped_mt_test),
+        cmocka_unit_test(lens_dist_sized_test),
+        cmocka_unit_test(lens_dist_sized_merge_test),
+        cmocka_unit_test(lens_dist_decayed_test),
+        cmocka_unit_test(lens_dist_decayed_merge_test),
+        cmocka_unit_test(lens_dist_exemplar_test),
+        cmocka_unit_test(lens_dist_exemplar_merge_test),
+        cmocka_unit_test(lens_dist_decayed_stale_merge_test),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
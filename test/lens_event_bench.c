@@ -0,0 +1,107 @@
+/* lens_event_bench.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "bench.h"
+
+
+struct event_bench
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+};
+
+
+// -----------------------------------------------------------------------------
+// record bench
+// -----------------------------------------------------------------------------
+
+// The ring is never drained so past the first few events this measures the
+// overflow path which is what writers hit when the poller falls behind.
+void run_record_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct event_bench *bench = data;
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i)
+        optics_event_record(bench->lens, i, i);
+}
+
+optics_test_head(lens_event_record_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_event_alloc(optics, "my_event", optics_event_capacity_max);
+
+    struct event_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_event_record_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_event_alloc(optics, "my_event", optics_event_capacity_max);
+
+    struct event_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record read bench
+// -----------------------------------------------------------------------------
+
+// Drains the ring before it fills up so that every event is written.
+void run_record_read_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct event_bench *bench = data;
+    optics_epoch_t epoch = optics_epoch(bench->optics);
+
+    optics_bench_start(b);
+
+    struct optics_event value = {0};
+    for (size_t i = 0; i < n; ++i) {
+        optics_event_record(bench->lens, i, i);
+
+        if ((i + 1) % optics_event_capacity_max) continue;
+        value.len = 0;
+        optics_event_read(bench->lens, epoch, &value);
+    }
+}
+
+optics_test_head(lens_event_record_read_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_event_alloc(optics, "my_event", optics_event_capacity_max);
+
+    struct event_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_read_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_event_record_bench_st),
+        cmocka_unit_test(lens_event_record_bench_mt),
+        cmocka_unit_test(lens_event_record_read_bench_st),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
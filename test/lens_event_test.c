@@ -0,0 +1,386 @@
+/* lens_event_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define checked_event_read(lens, epoch)                                 \
+    ({                                                                  \
+        struct optics_event value = {0};                                \
+        assert_int_equal(optics_event_read(lens, epoch, &value), optics_ok); \
+        value;                                                          \
+    })
+
+
+// -----------------------------------------------------------------------------
+// open/close
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_event_open_close_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "my_event";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *lens = optics_event_alloc(optics, lens_name, 16);
+        if (!lens) optics_abort();
+
+        assert_int_equal(optics_lens_type(lens), optics_event);
+        assert_string_equal(optics_lens_name(lens), lens_name);
+
+        assert_null(optics_event_alloc(optics, lens_name, 16));
+        optics_lens_close(lens);
+        assert_null(optics_event_alloc(optics, lens_name, 16));
+
+        assert_non_null(lens = optics_lens_get(optics, lens_name));
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// alloc_get
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_event_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "blah";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *l0 = optics_event_alloc_get(optics, lens_name, 16);
+        if (!l0) optics_abort();
+        optics_event_record(l0, 1, 10);
+
+        struct optics_lens *l1 = optics_event_alloc_get(optics, lens_name, 16);
+        if (!l1) optics_abort();
+        optics_event_record(l1, 2, 20);
+
+        struct optics_event value = checked_event_read(l0, optics_epoch(optics));
+        assert_int_equal(value.len, 2);
+
+        optics_lens_close(l0);
+        optics_lens_free(l1);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// invalid
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_event_invalid_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    assert_null(optics_event_alloc(optics, "blah", 0));
+    assert_null(optics_event_alloc(optics, "blah", optics_event_capacity_max + 1));
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record/read
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_event_record_read_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_event_alloc(optics, "my_event", 4);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_event value = checked_event_read(lens, epoch);
+    assert_int_equal(value.len, 0);
+    assert_int_equal(value.dropped, 0);
+
+    for (size_t i = 0; i < 3; ++i) assert_true(optics_event_record(lens, i, i * 1.5));
+
+    value = checked_event_read(lens, epoch);
+    assert_int_equal(value.len, 3);
+    assert_int_equal(value.dropped, 0);
+    for (size_t i = 0; i < 3; ++i) {
+        assert_int_equal(value.events[i].id, i);
+        assert_float_equal(value.events[i].value, i * 1.5, 0);
+    }
+
+    value = checked_event_read(lens, epoch);
+    assert_int_equal(value.len, 0);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// overflow
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_event_overflow_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_event_alloc(optics, "my_event", 4);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    for (size_t i = 0; i < 10; ++i) optics_event_record(lens, i, i);
+
+    struct optics_event value = checked_event_read(lens, epoch);
+    assert_int_equal(value.len, 4);
+    assert_int_equal(value.dropped, 6);
+    for (size_t i = 0; i < 4; ++i) assert_int_equal(value.events[i].id, i);
+
+    // The ring is reset by the read.
+    for (size_t i = 0; i < 2; ++i) optics_event_record(lens, 100 + i, i);
+
+    value = checked_event_read(lens, epoch);
+    assert_int_equal(value.len, 2);
+    assert_int_equal(value.dropped, 0);
+    assert_int_equal(value.events[0].id, 100);
+    assert_int_equal(value.events[1].id, 101);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// merge
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_event_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *l0 = optics_event_alloc(optics, "l0", optics_event_capacity_max);
+    struct optics_lens *l1 = optics_event_alloc(optics, "l1", optics_event_capacity_max);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    for (size_t i = 0; i < optics_event_capacity_max; ++i) {
+        optics_event_record(l0, i, i);
+        if (i < 10) optics_event_record(l1, 1000 + i, i);
+    }
+
+    struct optics_event value = {0};
+    assert_int_equal(optics_event_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(optics_event_read(l0, epoch, &value), optics_ok);
+
+    // Events that don't fit in the value are dropped.
+    assert_int_equal(value.len, optics_event_capacity_max);
+    assert_int_equal(value.dropped, 10);
+    assert_int_equal(value.events[0].id, 1000);
+    assert_int_equal(value.events[10].id, 0);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_event_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_event_alloc(optics, "my_event", 16);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_event_t event;
+    assert_true(optics_event_typed(lens, &event));
+
+    for (size_t i = 0; i < 10; ++i) optics_event_typed_record(event, i, i);
+
+    struct optics_event value = checked_event_read(lens, epoch);
+    assert_int_equal(value.len, 10);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_event_typed(lens, &event));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_event_type_test)
+{
+    const char * lens_name = "blah";
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_event value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        struct optics_lens *lens = optics_counter_alloc(optics, lens_name);
+
+        assert_false(optics_event_record(lens, 1, 1));
+        assert_int_equal(optics_event_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_lens_get(optics, lens_name);
+
+        assert_false(optics_event_record(lens, 1, 1));
+        assert_int_equal(optics_event_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch st
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_event_epoch_st_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_event_alloc(optics, "my_event", 16);
+
+    for (size_t i = 1; i < 5; ++i) {
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+        optics_event_record(lens, i, i);
+
+        struct optics_event value = checked_event_read(lens, epoch);
+        if (i == 1) assert_int_equal(value.len, 0);
+        else {
+            assert_int_equal(value.len, 1);
+            assert_int_equal(value.events[0].id, i - 1);
+        }
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch mt
+// -----------------------------------------------------------------------------
+
+struct epoch_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+void epoch_test_read_lens(struct epoch_test *test, size_t *events, size_t *dropped)
+{
+    optics_epoch_t epoch = optics_epoch_inc(test->optics);
+
+    struct optics_event value = {0};
+    assert_int_equal(optics_event_read(test->lens, epoch, &value), optics_ok);
+
+    // Every event must be intact which means that its value matches its id.
+    for (size_t i = 0; i < value.len; ++i) {
+        optics_assert(value.events[i].value == value.events[i].id,
+                "torn event: %lu != %g", value.events[i].id, value.events[i].value);
+    }
+
+    *events += value.len;
+    *dropped += value.dropped;
+}
+
+void run_epoch_test(size_t id, void *ctx)
+{
+    struct epoch_test *test = ctx;
+    enum { iterations = 100 * 1000 };
+
+    if (id) {
+        for (size_t i = 0; i < iterations; ++i)
+            optics_event_record(test->lens, id * iterations + i, id * iterations + i);
+
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+
+    else {
+        size_t done;
+        size_t events = 0, dropped = 0;
+        size_t writers = test->workers - 1;
+
+        do {
+            epoch_test_read_lens(test, &events, &dropped);
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        // Read whatever is leftover in the remaining epochs
+        for (size_t i = 0; i < 2; ++i)
+            epoch_test_read_lens(test, &events, &dropped);
+
+        // Every event is either read or dropped.
+        optics_assert(events + dropped == writers * iterations,
+                "%lu + %lu != %lu", events, dropped, writers * iterations);
+    }
+}
+
+optics_test_head(lens_event_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_event_alloc(optics, "my_event", optics_event_capacity_max);
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_event_open_close_test),
+        cmocka_unit_test(lens_event_alloc_get_test),
+        cmocka_unit_test(lens_event_invalid_test),
+        cmocka_unit_test(lens_event_record_read_test),
+        cmocka_unit_test(lens_event_overflow_test),
+        cmocka_unit_test(lens_event_merge_test),
+        cmocka_unit_test(lens_event_typed_test),
+        cmocka_unit_test(lens_event_type_test),
+        cmocka_unit_test(lens_event_epoch_st_test),
+        cmocka_unit_test(lens_event_epoch_mt_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
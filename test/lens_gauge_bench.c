@@ -56,6 +56,49 @@ optics_test_head(lens_gauge_record_bench_mt)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// add bench
+// -----------------------------------------------------------------------------
+
+void run_add_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+
+    struct gauge_bench *bench = data;
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i)
+        optics_gauge_add(bench->lens, 1);
+}
+
+
+optics_test_head(lens_gauge_add_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_gauge_alloc_additive(optics, "my_gauge");
+
+    struct gauge_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_add_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_gauge_add_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_gauge_alloc_additive(optics, "my_gauge");
+
+    struct gauge_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_add_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // read bench
 // -----------------------------------------------------------------------------
@@ -148,6 +191,8 @@ int main(void)
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(lens_gauge_record_bench_st),
         cmocka_unit_test(lens_gauge_record_bench_mt),
+        cmocka_unit_test(lens_gauge_add_bench_st),
+        cmocka_unit_test(lens_gauge_add_bench_mt),
         cmocka_unit_test(lens_gauge_read_bench_st),
         cmocka_unit_test(lens_gauge_read_bench_mt),
         cmocka_unit_test(lens_gauge_mixed_bench_mt),
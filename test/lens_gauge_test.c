@@ -4,6 +4,7 @@
 */
 
 #include "test.h"
+#include "optics_inline.h"
 
 
 // -----------------------------------------------------------------------------
@@ -80,6 +81,38 @@ optics_test_tail()
 
 // -----------------------------------------------------------------------------
 // record/read
+// -----------------------------------------------------------------------------
+// set_last
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_gauge_set_last_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_gauge_alloc(optics, "my_gauge");
+
+    double value = 0;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    const double values[] = { 1.0, 2.0, 3.0 };
+    assert_true(optics_gauge_set_last(lens, values, 3));
+    value = checked_gauge_read(lens, epoch);
+    assert_float_equal(value, 3.0, 0.0);
+
+    assert_true(optics_gauge_set_last(lens, values, 0));
+    value = checked_gauge_read(lens, epoch);
+    assert_float_equal(value, 3.0, 0.0);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_gauge_set_last(lens, values, 0));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 
 optics_test_head(lens_gauge_record_read_test)
@@ -107,6 +140,67 @@ optics_test_head(lens_gauge_record_read_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// inline
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_gauge_inline_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_gauge_alloc(optics, "my_gauge");
+
+    double value = 0;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_inline_gauge gauge;
+    assert_true(optics_inline_gauge_open(lens, &gauge));
+
+    optics_inline_gauge_set(&gauge, 2.3e-5);
+    value = checked_gauge_read(lens, epoch);
+    assert_float_equal(value, 2.3e-5, 0.0);
+
+    assert_false(optics_inline_gauge_open_abi(lens, &gauge, optics_inline_abi + 1));
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_inline_gauge_open(lens, &gauge));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_gauge_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_gauge_alloc(optics, "my_gauge");
+
+    double value = 0;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_gauge_t gauge;
+    assert_true(optics_gauge_typed(lens, &gauge));
+
+    optics_gauge_typed_set(gauge, 1.5);
+    value = checked_gauge_read(lens, epoch);
+    assert_float_equal(value, 1.5, 0.0);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_gauge_typed(lens, &gauge));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // merge
 // -----------------------------------------------------------------------------
@@ -145,6 +239,104 @@ optics_test_head(lens_gauge_merge_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// add
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_gauge_add_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_gauge_alloc_additive(optics, "my_gauge");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    double value = checked_gauge_read(lens, epoch);
+    assert_float_equal(value, 0.0, 0.0);
+
+    assert_true(optics_gauge_add(lens, 3));
+    assert_true(optics_gauge_add(lens, -1));
+    value = checked_gauge_read(lens, epoch);
+    assert_float_equal(value, 2.0, 0.0);
+
+    // Neither reads nor epochs reset the value.
+    epoch = optics_epoch_inc(optics);
+    value = checked_gauge_read(lens, epoch);
+    assert_float_equal(value, 2.0, 0.0);
+
+    optics_gauge_t gauge;
+    assert_true(optics_gauge_typed(lens, &gauge));
+    optics_gauge_typed_add(gauge, 0.5);
+
+    struct optics_inline_gauge inline_gauge;
+    assert_true(optics_inline_gauge_open(lens, &inline_gauge));
+    optics_inline_gauge_add(&inline_gauge, -1.5);
+
+    value = checked_gauge_read(lens, epoch);
+    assert_float_equal(value, 1.0, 0.0);
+
+    // Set still overwrites the value.
+    optics_gauge_set(lens, 10);
+    value = checked_gauge_read(lens, epoch);
+    assert_float_equal(value, 10.0, 0.0);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_gauge_add_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *l0 = optics_gauge_alloc_additive(optics, "l0");
+    struct optics_lens *l1 = optics_gauge_alloc_get_additive(optics, "l1");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_gauge_add(l0, 1);
+    optics_gauge_add(l1, 2);
+
+    double value = 0;
+    assert_int_equal(optics_gauge_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_gauge_read(l1, epoch, &value), optics_ok);
+    assert_float_equal(value, 3.0, 0.0);
+
+    optics_lens_free(l0);
+    optics_lens_free(l1);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_gauge_add_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    // Gauges can't be opened as the other kind since they don't merge the same
+    // way across processes.
+    struct optics_lens *l0 = optics_gauge_alloc(optics, "l0");
+    assert_null(optics_gauge_alloc_get_additive(optics, "l0"));
+
+    struct optics_lens *l1 = optics_gauge_alloc_additive(optics, "l1");
+    assert_null(optics_gauge_alloc_get(optics, "l1"));
+
+    struct optics_lens *lens = optics_gauge_alloc_get(optics, "l0");
+    assert_non_null(lens);
+    optics_gauge_set(lens, 1);
+    assert_float_equal(checked_gauge_read(l0, epoch), 1.0, 0.0);
+    optics_lens_close(lens);
+
+    lens = optics_gauge_alloc_get_additive(optics, "l1");
+    assert_non_null(lens);
+    optics_gauge_add(lens, 2);
+    assert_float_equal(checked_gauge_read(l1, epoch), 2.0, 0.0);
+    optics_lens_close(lens);
+
+    optics_lens_free(l0);
+    optics_lens_free(l1);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // type
 // -----------------------------------------------------------------------------
@@ -161,6 +353,7 @@ optics_test_head(lens_gauge_type_test)
         struct optics_lens *lens = optics_counter_alloc(optics, lens_name);
 
         assert_false(optics_gauge_set(lens, 1));
+        assert_false(optics_gauge_add(lens, 1));
         assert_int_equal(optics_gauge_read(lens, epoch, &value), optics_err);
 
         optics_lens_close(lens);
@@ -229,7 +422,13 @@ int main(void)
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(lens_gauge_open_close_test),
         cmocka_unit_test(lens_gauge_record_read_test),
+        cmocka_unit_test(lens_gauge_set_last_test),
+        cmocka_unit_test(lens_gauge_inline_test),
+        cmocka_unit_test(lens_gauge_typed_test),
         cmocka_unit_test(lens_gauge_merge_test),
+        cmocka_unit_test(lens_gauge_add_test),
+        cmocka_unit_test(lens_gauge_add_merge_test),
+        cmocka_unit_test(lens_gauge_add_alloc_get_test),
         cmocka_unit_test(lens_gauge_type_test),
         cmocka_unit_test(lens_gauge_epoch_test),
     };
@@ -0,0 +1,135 @@
+/* lens_hdr_bench.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "bench.h"
+
+
+struct hdr_bench
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+};
+
+
+// -----------------------------------------------------------------------------
+// record bench
+// -----------------------------------------------------------------------------
+
+void run_record_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    struct hdr_bench *bench = data;
+    optics_bench_start(b);
+
+    uint64_t value = id;
+    for (size_t i = 0; i < n; ++i)
+        optics_hdr_record(bench->lens, value += 7919);
+}
+
+
+optics_test_head(lens_hdr_record_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", 2, 1, 1000 * 1000);
+
+    struct hdr_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_hdr_record_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", 2, 1, 1000 * 1000);
+
+    struct hdr_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// read bench
+// -----------------------------------------------------------------------------
+
+void run_read_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct hdr_bench *bench = data;
+    optics_epoch_t epoch = optics_epoch(bench->optics);
+
+    optics_bench_start(b);
+
+    struct optics_hdr value = {0};
+    for (size_t i = 0; i < n; ++i)
+        optics_hdr_read(bench->lens, epoch, &value);
+}
+
+optics_test_head(lens_hdr_read_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", 2, 1, 1000 * 1000);
+
+    struct hdr_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_read_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// percentile bench
+// -----------------------------------------------------------------------------
+
+void run_percentile_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    const struct optics_hdr *value = data;
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t result = optics_hdr_percentile(value, 99);
+        optics_no_opt_val(result);
+    }
+}
+
+optics_test_head(lens_hdr_percentile_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", 2, 1, 1000 * 1000);
+
+    for (size_t i = 0; i < 1000 * 1000; ++i)
+        optics_hdr_record(lens, i);
+
+    struct optics_hdr value = {0};
+    optics_hdr_read(lens, optics_epoch(optics), &value);
+    optics_bench_st(test_name, run_percentile_bench, &value);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_hdr_record_bench_st),
+        cmocka_unit_test(lens_hdr_record_bench_mt),
+        cmocka_unit_test(lens_hdr_read_bench_st),
+        cmocka_unit_test(lens_hdr_percentile_bench_st),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,511 @@
+/* lens_hdr_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+#include "utils/rng.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define checked_hdr_read(lens, epoch)                                   \
+    ({                                                                  \
+        struct optics_hdr value = {0};                                  \
+        assert_int_equal(optics_hdr_read(lens, epoch, &value), optics_ok); \
+        value;                                                          \
+    })
+
+static size_t hdr_count(const struct optics_hdr *hdr)
+{
+    size_t count = hdr->above;
+    for (size_t i = 0; i < hdr->buckets_len; ++i) count += hdr->counts[i];
+    return count;
+}
+
+
+// -----------------------------------------------------------------------------
+// open/close
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hdr_open_close_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "my_hdr";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *lens = optics_hdr_alloc(optics, lens_name, 2, 1, 1000 * 1000);
+        if (!lens) optics_abort();
+
+        assert_int_equal(optics_lens_type(lens), optics_hdr);
+        assert_string_equal(optics_lens_name(lens), lens_name);
+
+        assert_null(optics_hdr_alloc(optics, lens_name, 2, 1, 1000 * 1000));
+        optics_lens_close(lens);
+        assert_null(optics_hdr_alloc(optics, lens_name, 2, 1, 1000 * 1000));
+
+        assert_non_null(lens = optics_lens_get(optics, lens_name));
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// alloc_get
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hdr_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "blah";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *l0 = optics_hdr_alloc_get(optics, lens_name, 2, 1, 1000 * 1000);
+        if (!l0) optics_abort();
+        optics_hdr_record(l0, 10);
+
+        struct optics_lens *l1 = optics_hdr_alloc_get(optics, lens_name, 2, 1, 1000 * 1000);
+        if (!l1) optics_abort();
+        optics_hdr_record(l1, 20);
+
+        struct optics_hdr value = checked_hdr_read(l0, optics_epoch(optics));
+        assert_int_equal(hdr_count(&value), 2);
+        assert_int_equal(value.max, 20);
+
+        optics_lens_close(l0);
+        optics_lens_free(l1);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// invalid
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hdr_invalid_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    assert_null(optics_hdr_alloc(optics, "blah", 0, 1, 1000));
+    assert_null(optics_hdr_alloc(optics, "blah", 4, 1, 1000));
+    assert_null(optics_hdr_alloc(optics, "blah", 2, 0, 1000));
+    assert_null(optics_hdr_alloc(optics, "blah", 2, 10, 19));
+
+    // Ranges that don't fit in the bucket budget are rejected instead of
+    // counting the values past the budget as above.
+    assert_null(optics_hdr_alloc(optics, "blah", 2, 1, 1UL << 37));
+    assert_null(optics_hdr_alloc(optics, "blah", 3, 1, 1UL << 12));
+    assert_null(optics_hdr_alloc(optics, "blah", 3, 1, UINT64_MAX));
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record/read
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hdr_record_read_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", 2, 1, 1000 * 1000);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_hdr value = checked_hdr_read(lens, epoch);
+    assert_int_equal(value.precision, 2);
+    assert_int_equal(value.unit, 0);
+    assert_int_equal(hdr_count(&value), 0);
+    assert_int_equal(optics_hdr_percentile(&value, 50), 0);
+
+    // Values below the first power of two that needs a wider bucket to stay
+    // within the precision are tracked exactly.
+    for (size_t i = 0; i < 128; ++i) optics_hdr_record(lens, i);
+    value = checked_hdr_read(lens, epoch);
+    assert_int_equal(hdr_count(&value), 128);
+    assert_int_equal(value.max, 127);
+    for (size_t i = 0; i < 128; ++i) assert_int_equal(value.counts[i], 1);
+    assert_int_equal(optics_hdr_percentile(&value, 50), 64);
+
+    value = checked_hdr_read(lens, epoch);
+    assert_int_equal(hdr_count(&value), 0);
+    assert_int_equal(value.max, 0);
+
+    for (size_t i = 0; i < 100; ++i) optics_hdr_record(lens, i);
+    value = checked_hdr_read(lens, epoch);
+    assert_int_equal(hdr_count(&value), 100);
+    assert_int_equal(optics_hdr_percentile(&value, 50), 50);
+    assert_int_equal(optics_hdr_percentile(&value, 90), 90);
+    assert_int_equal(optics_hdr_percentile(&value, 99), 99);
+    assert_int_equal(optics_hdr_percentile(&value, 100), 99);
+
+    optics_hdr_record(lens, UINT64_MAX);
+    value = checked_hdr_read(lens, epoch);
+    assert_int_equal(hdr_count(&value), 1);
+    assert_int_equal(value.above, 1);
+    assert_int_equal(value.max, UINT64_MAX);
+    assert_int_equal(optics_hdr_percentile(&value, 50), UINT64_MAX);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record_n
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hdr_record_n_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", 2, 1, 1000 * 1000);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    uint64_t values[101];
+    for (size_t i = 0; i < 100; ++i) values[i] = i;
+    values[100] = UINT64_MAX;
+
+    assert_true(optics_hdr_record_n(lens, values, 0));
+    struct optics_hdr value = checked_hdr_read(lens, epoch);
+    assert_int_equal(hdr_count(&value), 0);
+
+    assert_true(optics_hdr_record_n(lens, values, 100));
+    value = checked_hdr_read(lens, epoch);
+    assert_int_equal(hdr_count(&value), 100);
+    assert_int_equal(value.max, 99);
+    assert_int_equal(optics_hdr_percentile(&value, 50), 50);
+    assert_int_equal(optics_hdr_percentile(&value, 90), 90);
+    assert_int_equal(optics_hdr_percentile(&value, 99), 99);
+
+    assert_true(optics_hdr_record_n(lens, values, 101));
+    value = checked_hdr_read(lens, epoch);
+    assert_int_equal(hdr_count(&value), 101);
+    assert_int_equal(value.above, 1);
+    assert_int_equal(value.max, UINT64_MAX);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hdr_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", 2, 1, 1000 * 1000);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_hdr_t hdr;
+    assert_true(optics_hdr_typed(lens, &hdr));
+
+    for (size_t i = 0; i < 100; ++i) optics_hdr_typed_record(hdr, i);
+
+    struct optics_hdr value = checked_hdr_read(lens, epoch);
+    assert_int_equal(hdr_count(&value), 100);
+    assert_int_equal(value.max, 99);
+    assert_int_equal(optics_hdr_percentile(&value, 50), 50);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_hdr_typed(lens, &hdr));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// unit
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hdr_unit_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", 2, 1000, 1000 * 1000);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    for (size_t i = 0; i < 100; ++i) optics_hdr_record(lens, i * 1000);
+
+    struct optics_hdr value = checked_hdr_read(lens, epoch);
+    assert_int_equal(value.unit, 9);
+    assert_int_equal(hdr_count(&value), 100);
+    assert_int_equal(value.max, 99 * 1000);
+
+    uint64_t p50 = optics_hdr_percentile(&value, 50);
+    assert_true(p50 >= 50 * 1000);
+    assert_true(p50 <= 50 * 1000 + (50 * 1000) / 100 + 512);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// range
+// -----------------------------------------------------------------------------
+
+// The buckets cover at least up to highest and the values past the end of the
+// last group are counted as above.
+optics_test_head(lens_hdr_range_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    const struct { size_t precision; uint64_t lowest, highest, end; } tests[] = {
+        { 1, 1, UINT64_MAX, 0 },
+        { 2, 1, (1UL << 37) - 1, 1UL << 37 },
+        { 2, 1000, 1000 * 1000, 1UL << 20 },
+        { 3, 1, 4000, 4096 },
+    };
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i) {
+        struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr",
+                tests[i].precision, tests[i].lowest, tests[i].highest);
+        if (!lens) optics_abort();
+
+        optics_hdr_record(lens, tests[i].highest);
+        struct optics_hdr value = checked_hdr_read(lens, epoch);
+        assert_int_equal(value.above, 0);
+        assert_true(value.buckets_len <= optics_hdr_buckets_max);
+
+        if (tests[i].end) {
+            optics_hdr_record(lens, tests[i].end - 1);
+            value = checked_hdr_read(lens, epoch);
+            assert_int_equal(value.above, 0);
+
+            optics_hdr_record(lens, tests[i].end);
+            value = checked_hdr_read(lens, epoch);
+            assert_int_equal(value.above, 1);
+        }
+
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// error
+// -----------------------------------------------------------------------------
+
+static int cmp_u64(const void *lhs, const void *rhs)
+{
+    uint64_t a = *((const uint64_t *) lhs);
+    uint64_t b = *((const uint64_t *) rhs);
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+optics_test_head(lens_hdr_error_test)
+{
+    enum { n = 10 * 1000 };
+    static uint64_t values[n];
+
+    // The range is bounded by what the highest precision can cover.
+    uint64_t digits = 1;
+    for (size_t precision = 1; precision <= 3; ++precision) {
+        digits *= 10;
+
+        struct optics *optics = optics_create(test_name);
+        struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", precision, 1, 4000);
+        optics_epoch_t epoch = optics_epoch(optics);
+
+        for (size_t i = 0; i < n; ++i) {
+            values[i] = rng_gen_range(rng_global(), 0, 4000);
+            optics_hdr_record(lens, values[i]);
+        }
+        qsort(values, n, sizeof(values[0]), cmp_u64);
+
+        struct optics_hdr value = checked_hdr_read(lens, epoch);
+        assert_int_equal(value.above, 0);
+        assert_int_equal(value.max, values[n - 1]);
+
+        const double percentiles[] = { 50, 90, 99, 99.9 };
+        for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+            uint64_t exp = values[(size_t) ((n * percentiles[i]) / 100)];
+            uint64_t result = optics_hdr_percentile(&value, percentiles[i]);
+
+            assert_true(result >= exp);
+            assert_true(result - exp <= exp / digits);
+        }
+
+        optics_lens_close(lens);
+        optics_close(optics);
+    }
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hdr_type_test)
+{
+    const char * lens_name = "blah";
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_hdr value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        struct optics_lens *lens = optics_counter_alloc(optics, lens_name);
+
+        assert_false(optics_hdr_record(lens, 1));
+        assert_int_equal(optics_hdr_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_lens_get(optics, lens_name);
+
+        assert_false(optics_hdr_record(lens, 1));
+        assert_int_equal(optics_hdr_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch st
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hdr_epoch_st_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", 2, 1, 1000 * 1000);
+
+    for (size_t i = 1; i < 5; ++i) {
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+        optics_hdr_record(lens, i);
+
+        struct optics_hdr value = checked_hdr_read(lens, epoch);
+        assert_int_equal(hdr_count(&value), i - 1 ? 1 : 0);
+        assert_int_equal(value.max, i - 1);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch mt
+// -----------------------------------------------------------------------------
+
+struct epoch_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+size_t epoch_test_read_lens(struct epoch_test *test)
+{
+    optics_epoch_t epoch = optics_epoch_inc(test->optics);
+
+    struct optics_hdr value = checked_hdr_read(test->lens, epoch);
+    return hdr_count(&value);
+}
+
+void run_epoch_test(size_t id, void *ctx)
+{
+    struct epoch_test *test = ctx;
+    enum { iterations = 1000 * 1000 };
+
+    if (id) {
+        for (size_t i = 0; i < iterations; ++i)
+            optics_hdr_record(test->lens, i);
+
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+
+    else {
+        size_t done;
+        uint64_t result = 0;
+        size_t writers = test->workers - 1;
+
+        do {
+            result += epoch_test_read_lens(test);
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        // Read whatever is leftover in the remaining epochs
+        for (size_t i = 0; i < 2; ++i)
+            result += epoch_test_read_lens(test);
+
+        // cmocka just plain sucks when it comes to mt.
+        optics_assert(result == writers * iterations, "%lu != %lu",
+                result, writers * iterations);
+    }
+}
+
+optics_test_head(lens_hdr_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", 2, 1, 1000 * 1000);
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    rng_seed_with(rng_global(), 0);
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_hdr_open_close_test),
+        cmocka_unit_test(lens_hdr_alloc_get_test),
+        cmocka_unit_test(lens_hdr_invalid_test),
+        cmocka_unit_test(lens_hdr_record_read_test),
+        cmocka_unit_test(lens_hdr_record_n_test),
+        cmocka_unit_test(lens_hdr_typed_test),
+        cmocka_unit_test(lens_hdr_unit_test),
+        cmocka_unit_test(lens_hdr_error_test),
+        cmocka_unit_test(lens_hdr_type_test),
+        cmocka_unit_test(lens_hdr_epoch_st_test),
+        cmocka_unit_test(lens_hdr_epoch_mt_test),
+        cmocka_unit_test(lens_hdr_range_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
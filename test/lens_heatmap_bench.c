@@ -0,0 +1,109 @@
+/* lens_heatmap_bench.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "bench.h"
+
+
+struct heatmap_bench
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+};
+
+static struct optics_lens *heatmap_alloc(struct optics *optics)
+{
+    uint64_t buckets[optics_heatmap_buckets_max + 1];
+    for (size_t i = 0; i < optics_heatmap_buckets_max + 1; ++i) buckets[i] = i * 10;
+
+    return optics_heatmap_alloc(optics, "my_heatmap",
+            buckets, optics_heatmap_buckets_max + 1,
+            buckets, optics_heatmap_buckets_max + 1);
+}
+
+
+// -----------------------------------------------------------------------------
+// record bench
+// -----------------------------------------------------------------------------
+
+void run_record_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct heatmap_bench *bench = data;
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i)
+        optics_heatmap_inc(bench->lens, i % 200, (i * 7) % 200);
+}
+
+optics_test_head(lens_heatmap_record_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = heatmap_alloc(optics);
+
+    struct heatmap_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_heatmap_record_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = heatmap_alloc(optics);
+
+    struct heatmap_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// read bench
+// -----------------------------------------------------------------------------
+
+void run_read_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct heatmap_bench *bench = data;
+    optics_epoch_t epoch = optics_epoch(bench->optics);
+
+    optics_bench_start(b);
+
+    struct optics_heatmap value = {0};
+    for (size_t i = 0; i < n; ++i)
+        optics_heatmap_read(bench->lens, epoch, &value);
+}
+
+optics_test_head(lens_heatmap_read_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = heatmap_alloc(optics);
+
+    struct heatmap_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_read_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_heatmap_record_bench_st),
+        cmocka_unit_test(lens_heatmap_record_bench_mt),
+        cmocka_unit_test(lens_heatmap_read_bench_st),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,414 @@
+/* lens_heatmap_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define checked_heatmap_read(lens, epoch)                               \
+    ({                                                                  \
+        struct optics_heatmap value = {0};                              \
+        assert_int_equal(optics_heatmap_read(lens, epoch, &value), optics_ok); \
+        value;                                                          \
+    })
+
+#define heatmap_cell(value, x, y) ((value).counts[(x) * ((value).y_len + 1) + (y)])
+
+static const uint64_t x_buckets[] = { 10, 20, 30 };
+static const uint64_t y_buckets[] = { 100, 200 };
+
+#define heatmap_alloc(optics, name)                                     \
+    optics_heatmap_alloc(optics, name, x_buckets, 3, y_buckets, 2)
+
+
+// -----------------------------------------------------------------------------
+// open/close
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_heatmap_open_close_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "my_heatmap";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *lens = heatmap_alloc(optics, lens_name);
+        if (!lens) optics_abort();
+
+        assert_int_equal(optics_lens_type(lens), optics_heatmap);
+        assert_string_equal(optics_lens_name(lens), lens_name);
+
+        assert_null(heatmap_alloc(optics, lens_name));
+        optics_lens_close(lens);
+        assert_null(heatmap_alloc(optics, lens_name));
+
+        assert_non_null(lens = optics_lens_get(optics, lens_name));
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// alloc_get
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_heatmap_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "blah";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *l0 = optics_heatmap_alloc_get(
+                optics, lens_name, x_buckets, 3, y_buckets, 2);
+        if (!l0) optics_abort();
+        optics_heatmap_inc(l0, 15, 150);
+
+        struct optics_lens *l1 = optics_heatmap_alloc_get(
+                optics, lens_name, x_buckets, 3, y_buckets, 2);
+        if (!l1) optics_abort();
+        optics_heatmap_inc(l1, 15, 150);
+
+        struct optics_heatmap value = checked_heatmap_read(l0, optics_epoch(optics));
+        assert_int_equal(heatmap_cell(value, 1, 1), 2);
+
+        optics_lens_close(l0);
+        optics_lens_free(l1);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// invalid
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_heatmap_invalid_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    assert_null(optics_heatmap_alloc(optics, "blah", x_buckets, 1, y_buckets, 2));
+    assert_null(optics_heatmap_alloc(optics, "blah", x_buckets, 3, y_buckets, 1));
+
+    uint64_t big[optics_heatmap_buckets_max + 2];
+    for (size_t i = 0; i < optics_heatmap_buckets_max + 2; ++i) big[i] = i;
+    assert_null(optics_heatmap_alloc(
+                    optics, "blah", big, optics_heatmap_buckets_max + 2, y_buckets, 2));
+    assert_non_null(optics_heatmap_alloc(
+                    optics, "blah", big, optics_heatmap_buckets_max + 1, big, optics_heatmap_buckets_max + 1));
+
+    const uint64_t unsorted[] = { 10, 5 };
+    assert_null(optics_heatmap_alloc(optics, "bleh", unsorted, 2, y_buckets, 2));
+    assert_null(optics_heatmap_alloc(optics, "bleh", x_buckets, 3, unsorted, 2));
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record/read
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_heatmap_record_read_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = heatmap_alloc(optics, "my_heatmap");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_heatmap value = checked_heatmap_read(lens, epoch);
+    assert_int_equal(value.x_len, 3);
+    assert_int_equal(value.y_len, 2);
+    for (size_t i = 0; i < 3; ++i) assert_int_equal(value.x_buckets[i], x_buckets[i]);
+    for (size_t i = 0; i < 2; ++i) assert_int_equal(value.y_buckets[i], y_buckets[i]);
+    for (size_t i = 0; i < 4 * 3; ++i) assert_int_equal(value.counts[i], 0);
+
+    optics_heatmap_inc(lens, 5, 50);     // below, below
+    optics_heatmap_inc(lens, 10, 100);   // [10, 20), [100, 200)
+    optics_heatmap_inc(lens, 19, 199);   // [10, 20), [100, 200)
+    optics_heatmap_inc(lens, 25, 500);   // [20, 30), above
+    optics_heatmap_inc(lens, 30, 0);     // above, below
+
+    value = checked_heatmap_read(lens, epoch);
+    assert_int_equal(heatmap_cell(value, 0, 0), 1);
+    assert_int_equal(heatmap_cell(value, 1, 1), 2);
+    assert_int_equal(heatmap_cell(value, 2, 2), 1);
+    assert_int_equal(heatmap_cell(value, 3, 0), 1);
+
+    size_t total = 0;
+    for (size_t i = 0; i < 4 * 3; ++i) total += value.counts[i];
+    assert_int_equal(total, 5);
+
+    value = checked_heatmap_read(lens, epoch);
+    for (size_t i = 0; i < 4 * 3; ++i) assert_int_equal(value.counts[i], 0);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// non-finite
+// -----------------------------------------------------------------------------
+
+// Infinities land in the below and above cells of their axis and NaN in the
+// below cell. None of them may spill into the lens allocated right after.
+optics_test_head(lens_heatmap_non_finite_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = heatmap_alloc(optics, "my_heatmap");
+    struct optics_lens *next = heatmap_alloc(optics, "abc");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_heatmap_inc(lens, INFINITY, 150);
+    optics_heatmap_inc(lens, 15, INFINITY);
+    optics_heatmap_inc(lens, INFINITY, INFINITY);
+    optics_heatmap_inc(lens, -INFINITY, 150);
+    optics_heatmap_inc(lens, 15, -INFINITY);
+    optics_heatmap_inc(lens, NAN, 150);
+    optics_heatmap_inc(lens, 15, NAN);
+    optics_heatmap_inc(lens, NAN, NAN);
+
+    struct optics_heatmap value = checked_heatmap_read(lens, epoch);
+    assert_int_equal(heatmap_cell(value, 3, 1), 1);
+    assert_int_equal(heatmap_cell(value, 1, 2), 1);
+    assert_int_equal(heatmap_cell(value, 3, 2), 1);
+    assert_int_equal(heatmap_cell(value, 0, 1), 2);
+    assert_int_equal(heatmap_cell(value, 1, 0), 2);
+    assert_int_equal(heatmap_cell(value, 0, 0), 1);
+
+    size_t total = 0;
+    for (size_t i = 0; i < 4 * 3; ++i) total += value.counts[i];
+    assert_int_equal(total, 8);
+
+    assert_string_equal(optics_lens_name(next), "abc");
+    value = checked_heatmap_read(next, epoch);
+    for (size_t i = 0; i < 4 * 3; ++i) assert_int_equal(value.counts[i], 0);
+
+    optics_lens_close(lens);
+    optics_lens_close(next);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// merge
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_heatmap_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *l0 = heatmap_alloc(optics, "l0");
+    struct optics_lens *l1 = heatmap_alloc(optics, "l1");
+    struct optics_lens *l2 = optics_heatmap_alloc(optics, "l2", y_buckets, 2, x_buckets, 3);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_heatmap_inc(l0, 15, 150);
+    optics_heatmap_inc(l1, 15, 150);
+    optics_heatmap_inc(l1, 25, 50);
+
+    struct optics_heatmap value = {0};
+    assert_int_equal(optics_heatmap_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_heatmap_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(heatmap_cell(value, 1, 1), 2);
+    assert_int_equal(heatmap_cell(value, 2, 0), 1);
+
+    assert_int_equal(optics_heatmap_read(l2, epoch, &value), optics_err);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_lens_close(l2);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_heatmap_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = heatmap_alloc(optics, "my_heatmap");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_heatmap_t heatmap;
+    assert_true(optics_heatmap_typed(lens, &heatmap));
+
+    for (size_t i = 0; i < 10; ++i) optics_heatmap_typed_inc(heatmap, 15, 150);
+
+    struct optics_heatmap value = checked_heatmap_read(lens, epoch);
+    assert_int_equal(heatmap_cell(value, 1, 1), 10);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_heatmap_typed(lens, &heatmap));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_heatmap_type_test)
+{
+    const char * lens_name = "blah";
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_heatmap value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        struct optics_lens *lens = optics_counter_alloc(optics, lens_name);
+
+        assert_false(optics_heatmap_inc(lens, 1, 1));
+        assert_int_equal(optics_heatmap_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_lens_get(optics, lens_name);
+
+        assert_false(optics_heatmap_inc(lens, 1, 1));
+        assert_int_equal(optics_heatmap_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch st
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_heatmap_epoch_st_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = heatmap_alloc(optics, "my_heatmap");
+
+    for (size_t i = 1; i < 5; ++i) {
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+        for (size_t j = 0; j < i; ++j) optics_heatmap_inc(lens, 15, 150);
+
+        struct optics_heatmap value = checked_heatmap_read(lens, epoch);
+        assert_int_equal(heatmap_cell(value, 1, 1), i - 1);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch mt
+// -----------------------------------------------------------------------------
+
+struct epoch_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+void epoch_test_read_lens(struct epoch_test *test, struct optics_heatmap *value)
+{
+    optics_epoch_t epoch = optics_epoch_inc(test->optics);
+    assert_int_equal(optics_heatmap_read(test->lens, epoch, value), optics_ok);
+}
+
+void run_epoch_test(size_t id, void *ctx)
+{
+    struct epoch_test *test = ctx;
+    enum { iterations = 100 * 1000 };
+
+    if (id) {
+        for (size_t i = 0; i < iterations; ++i)
+            optics_heatmap_inc(test->lens, i % 40, (i % 3) * 100);
+
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+
+    else {
+        size_t done;
+        struct optics_heatmap value = {0};
+        size_t writers = test->workers - 1;
+
+        do {
+            epoch_test_read_lens(test, &value);
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        // Read whatever is leftover in the remaining epochs
+        for (size_t i = 0; i < 2; ++i)
+            epoch_test_read_lens(test, &value);
+
+        size_t total = 0;
+        for (size_t i = 0; i < 4 * 3; ++i) total += value.counts[i];
+        optics_assert(total == writers * iterations,
+                "%lu != %lu", total, writers * iterations);
+    }
+}
+
+optics_test_head(lens_heatmap_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = heatmap_alloc(optics, "my_heatmap");
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_heatmap_open_close_test),
+        cmocka_unit_test(lens_heatmap_alloc_get_test),
+        cmocka_unit_test(lens_heatmap_invalid_test),
+        cmocka_unit_test(lens_heatmap_record_read_test),
+        cmocka_unit_test(lens_heatmap_merge_test),
+        cmocka_unit_test(lens_heatmap_typed_test),
+        cmocka_unit_test(lens_heatmap_type_test),
+        cmocka_unit_test(lens_heatmap_epoch_st_test),
+        cmocka_unit_test(lens_heatmap_epoch_mt_test),
+        cmocka_unit_test(lens_heatmap_non_finite_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -27,6 +27,18 @@ static struct optics_lens *make_basic_lens(struct optics * optics)
     return optics_histo_alloc(optics, "my_histo", buckets, calc_len(buckets));
 }
 
+static struct optics_lens *make_striped_lens(struct optics * optics)
+{
+    uint64_t buckets[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    return optics_histo_alloc_striped(optics, "my_histo", buckets, calc_len(buckets));
+}
+
+static struct optics_lens *make_exemplar_lens(struct optics * optics)
+{
+    uint64_t buckets[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    return optics_histo_alloc_exemplars(optics, "my_histo", buckets, calc_len(buckets));
+}
+
 
 // -----------------------------------------------------------------------------
 // record value bench
@@ -138,6 +150,112 @@ optics_test_head(lens_histo_record_spread_bench_mt)
 optics_test_tail()
 
 
+optics_test_head(lens_histo_record_spread_striped_bench_mt)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = make_striped_lens(optics);
+
+    struct histo_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_spread_bench, &bench);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record exemplar
+// -----------------------------------------------------------------------------
+
+// Every value is tagged so all but the first value of each bucket and epoch
+// should bail out on the load before the CAS.
+void run_record_exemplar_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    struct histo_bench *bench = data;
+    optics_bench_start(b);
+
+    size_t value = id;
+    for (size_t i = 0; i < n; ++i)
+        optics_histo_inc_exemplar(bench->lens, ++value % 9, i + 1);
+}
+
+optics_test_head(lens_histo_record_exemplar_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = make_exemplar_lens(optics);
+
+    struct histo_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_exemplar_bench, &bench);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_histo_record_exemplar_bench_mt)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = make_exemplar_lens(optics);
+
+    struct histo_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_exemplar_bench, &bench);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record_n spread
+// -----------------------------------------------------------------------------
+
+// Values are recorded in arrays of 64 so that each iteration is still a single
+// value and the numbers are comparable to the record spread bench.
+void run_record_n_spread_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    struct histo_bench *bench = data;
+
+    enum { len = 64 };
+    double values[len];
+    for (size_t i = 0; i < len; ++i) values[i] = (id + i) % 9;
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; i += len)
+        optics_histo_inc_n(bench->lens, values, n - i < len ? n - i : len);
+}
+
+optics_test_head(lens_histo_record_n_spread_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = make_basic_lens(optics);
+
+    struct histo_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_n_spread_bench, &bench);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_histo_record_n_spread_bench_mt)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = make_basic_lens(optics);
+
+    struct histo_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_n_spread_bench, &bench);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // read
 // -----------------------------------------------------------------------------
@@ -247,6 +365,11 @@ int main(void)
         cmocka_unit_test(lens_histo_record_bound_bench),
         cmocka_unit_test(lens_histo_record_spread_bench_st),
         cmocka_unit_test(lens_histo_record_spread_bench_mt),
+        cmocka_unit_test(lens_histo_record_spread_striped_bench_mt),
+        cmocka_unit_test(lens_histo_record_exemplar_bench_st),
+        cmocka_unit_test(lens_histo_record_exemplar_bench_mt),
+        cmocka_unit_test(lens_histo_record_n_spread_bench_st),
+        cmocka_unit_test(lens_histo_record_n_spread_bench_mt),
         cmocka_unit_test(lens_histo_read_bench_st),
         cmocka_unit_test(lens_histo_read_bench_mt),
         cmocka_unit_test(lens_histo_mixed_bench_st),
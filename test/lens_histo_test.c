@@ -153,6 +153,44 @@ optics_test_tail()
 
 // -----------------------------------------------------------------------------
 // record/read
+// -----------------------------------------------------------------------------
+// inc_n
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_histo_inc_n_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    const uint64_t buckets[] = {10, 20, 30, 40, 50};
+    struct optics_lens *lens = optics_histo_alloc(optics, "my_histo", buckets, calc_len(buckets));
+
+    struct optics_histo value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    assert_true(optics_histo_inc_n(lens, NULL, 0));
+    value = checked_histo_read(lens, epoch);
+    assert_histo_equal(value, buckets, 0, 0, 0, 0, 0, 0);
+
+    const double values[] = { 0, 10, 20, 35, 49, 50, 9.9 };
+    assert_true(optics_histo_inc_n(lens, values, calc_len(values)));
+    value = checked_histo_read(lens, epoch);
+    assert_histo_equal(value, buckets, 2, 1, 1, 1, 1, 1);
+
+    // Spans multiple chunks.
+    enum { n = 1000 };
+    double many[n];
+    for (size_t i = 0; i < n; ++i) many[i] = i % 60;
+
+    assert_true(optics_histo_inc_n(lens, many, n));
+    value = checked_histo_read(lens, epoch);
+    assert_histo_equal(value, buckets, 170, 160, 170, 170, 170, 160);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 
 optics_test_head(lens_histo_record_read_test)
@@ -198,6 +236,88 @@ optics_test_head(lens_histo_record_read_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_histo_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    const uint64_t buckets[] = {10, 20, 30, 40, 50};
+    struct optics_lens *lens = optics_histo_alloc(optics, "my_histo", buckets, calc_len(buckets));
+
+    struct optics_histo value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_histo_t histo;
+    assert_true(optics_histo_typed(lens, &histo));
+
+    const double values[] = { 0, 10, 20, 35, 49, 50, 9.9 };
+    for (size_t i = 0; i < calc_len(values); ++i)
+        optics_histo_typed_inc(histo, values[i]);
+
+    value = checked_histo_read(lens, epoch);
+    assert_histo_equal(value, buckets, 2, 1, 1, 1, 1, 1);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_histo_typed(lens, &histo));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// striped
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_histo_striped_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    const uint64_t buckets[] = {10, 20, 30, 40, 50};
+    struct optics_lens *lens =
+        optics_histo_alloc_striped(optics, "my_histo", buckets, calc_len(buckets));
+    assert_int_equal(optics_lens_type(lens), optics_histo);
+
+    struct optics_histo value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    value = checked_histo_read(lens, epoch);
+    assert_histo_equal(value, buckets, 0, 0, 0, 0, 0, 0);
+
+    for (size_t i = 0; i < 60; ++i) assert_true(optics_histo_inc(lens, i));
+    value = checked_histo_read(lens, epoch);
+    assert_histo_equal(value, buckets, 10, 10, 10, 10, 10, 10);
+
+    value = checked_histo_read(lens, epoch);
+    assert_histo_equal(value, buckets, 0, 0, 0, 0, 0, 0);
+
+    {
+        struct optics_lens *other = optics_histo_alloc_get_striped(
+                optics, "my_histo", buckets, calc_len(buckets));
+        assert_true(optics_histo_inc(other, 15));
+        assert_true(optics_histo_inc(lens, 45));
+
+        epoch = optics_epoch_inc(optics);
+        assert_true(optics_histo_inc(lens, 15));
+
+        value = checked_histo_read(lens, epoch);
+        assert_histo_equal(value, buckets, 0, 0, 1, 0, 0, 1);
+
+        optics_lens_close(other);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // merge
 // -----------------------------------------------------------------------------
@@ -429,6 +549,120 @@ optics_test_tail()
 
 
 
+// -----------------------------------------------------------------------------
+// exemplar
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_histo_exemplar_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    const uint64_t buckets[] = {10, 20, 30};
+    struct optics_lens *lens =
+        optics_histo_alloc_exemplars(optics, "my_histo", buckets, calc_len(buckets));
+
+    struct optics_histo value = checked_histo_read(lens, epoch);
+    for (size_t i = 0; i < calc_len(buckets) + 1; ++i)
+        assert_int_equal(value.exemplars[i], 0);
+
+    // The first tag of each bucket is kept and untagged values are ignored.
+    assert_true(optics_histo_inc(lens, 5));
+    assert_true(optics_histo_inc_exemplar(lens, 5, 1));
+    assert_true(optics_histo_inc_exemplar(lens, 6, 2));
+    assert_true(optics_histo_inc_exemplar(lens, 25, 0));
+    assert_true(optics_histo_inc_exemplar(lens, 25, 3));
+    assert_true(optics_histo_inc_exemplar(lens, 100, 4));
+
+    value = checked_histo_read(lens, epoch);
+    assert_histo_equal(value, buckets, 3, 1, 0, 2);
+    assert_int_equal(value.exemplars[0], 1);
+    assert_int_equal(value.exemplars[1], 0);
+    assert_int_equal(value.exemplars[2], 3);
+    assert_int_equal(value.exemplars[3], 4);
+
+    // Exemplars are reset on read.
+    optics_histo_inc(lens, 5);
+    value = checked_histo_read(lens, epoch);
+    assert_int_equal(value.exemplars[0], 0);
+
+    optics_histo_t histo;
+    assert_true(optics_histo_typed(lens, &histo));
+    optics_histo_typed_inc_exemplar(histo, 15, 5);
+
+    value = checked_histo_read(lens, epoch);
+    assert_int_equal(value.exemplars[1], 5);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_histo_inc_exemplar(lens, 1, 1));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_histo_exemplar_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    const uint64_t buckets[] = {10, 20, 30};
+    struct optics_lens *l0 =
+        optics_histo_alloc_exemplars(optics, "my_histo_0", buckets, calc_len(buckets));
+    struct optics_lens *l1 =
+        optics_histo_alloc_exemplars(optics, "my_histo_1", buckets, calc_len(buckets));
+
+    optics_histo_inc_exemplar(l0, 15, 1);
+    optics_histo_inc_exemplar(l1, 15, 2);
+    optics_histo_inc_exemplar(l1, 25, 3);
+
+    struct optics_histo value = {0};
+    assert_int_equal(optics_histo_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_histo_read(l1, epoch, &value), optics_ok);
+    assert_histo_equal(value, buckets, 0, 0, 2, 1);
+    assert_int_equal(value.exemplars[1], 1);
+    assert_int_equal(value.exemplars[2], 3);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_histo_exemplar_disabled_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    // Histos without exemplars still count tagged values but drop the tags.
+    const uint64_t buckets[] = {10, 20, 30};
+    struct optics_lens *l0 = optics_histo_alloc(optics, "my_histo_0", buckets, calc_len(buckets));
+    struct optics_lens *l1 =
+        optics_histo_alloc_striped(optics, "my_histo_1", buckets, calc_len(buckets));
+
+    assert_true(optics_histo_inc_exemplar(l0, 15, 1));
+    assert_true(optics_histo_inc_exemplar(l1, 25, 2));
+
+    optics_histo_t histo;
+    assert_true(optics_histo_typed(l1, &histo));
+    optics_histo_typed_inc_exemplar(histo, 100, 3);
+
+    struct optics_histo value = {0};
+    assert_int_equal(optics_histo_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_histo_read(l1, epoch, &value), optics_ok);
+    assert_histo_equal(value, buckets, 0, 1, 1, 1);
+    for (size_t i = 0; i < calc_len(buckets) + 1; ++i)
+        assert_int_equal(value.exemplars[i], 0);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // setup
 // -----------------------------------------------------------------------------
@@ -442,10 +676,16 @@ int main(void)
         /* cmocka_unit_test(lens_histo_alloc_get_test), */
         /* cmocka_unit_test(lens_histo_validate_test), */
         /* cmocka_unit_test(lens_histo_record_read_test), */
+        cmocka_unit_test(lens_histo_striped_test),
+        cmocka_unit_test(lens_histo_inc_n_test),
+        cmocka_unit_test(lens_histo_typed_test),
         cmocka_unit_test(lens_histo_merge_test),
         /* cmocka_unit_test(lens_histo_type_test), */
         /* cmocka_unit_test(lens_histo_epoch_st_test), */
         /* cmocka_unit_test(lens_histo_epoch_mt_test), */
+        cmocka_unit_test(lens_histo_exemplar_test),
+        cmocka_unit_test(lens_histo_exemplar_merge_test),
+        cmocka_unit_test(lens_histo_exemplar_disabled_test),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,135 @@
+/* lens_hll_bench.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "bench.h"
+
+
+struct hll_bench
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+};
+
+
+// -----------------------------------------------------------------------------
+// record bench
+// -----------------------------------------------------------------------------
+
+void run_record_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    struct hll_bench *bench = data;
+    optics_bench_start(b);
+
+    uint64_t value = id << 32;
+    for (size_t i = 0; i < n; ++i)
+        optics_hll_record(bench->lens, value++);
+}
+
+
+optics_test_head(lens_hll_record_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hll_alloc(optics, "my_hll", 12);
+
+    struct hll_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_hll_record_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hll_alloc(optics, "my_hll", 12);
+
+    struct hll_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// read bench
+// -----------------------------------------------------------------------------
+
+void run_read_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct hll_bench *bench = data;
+    optics_epoch_t epoch = optics_epoch(bench->optics);
+
+    optics_bench_start(b);
+
+    struct optics_hll value = {0};
+    for (size_t i = 0; i < n; ++i)
+        optics_hll_read(bench->lens, epoch, &value);
+}
+
+optics_test_head(lens_hll_read_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hll_alloc(optics, "my_hll", 12);
+
+    struct hll_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_read_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// estimate bench
+// -----------------------------------------------------------------------------
+
+void run_estimate_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    const struct optics_hll *value = data;
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i) {
+        double result = optics_hll_estimate(value);
+        optics_no_opt_val(result);
+    }
+}
+
+optics_test_head(lens_hll_estimate_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hll_alloc(optics, "my_hll", 12);
+
+    for (size_t i = 0; i < 1000 * 1000; ++i)
+        optics_hll_record(lens, i);
+
+    struct optics_hll value = {0};
+    optics_hll_read(lens, optics_epoch(optics), &value);
+    optics_bench_st(test_name, run_estimate_bench, &value);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_hll_record_bench_st),
+        cmocka_unit_test(lens_hll_record_bench_mt),
+        cmocka_unit_test(lens_hll_read_bench_st),
+        cmocka_unit_test(lens_hll_estimate_bench_st),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,375 @@
+/* lens_hll_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+#include "utils/rng.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define checked_hll_read(lens, epoch)                                   \
+    ({                                                                  \
+        struct optics_hll value = {0};                                  \
+        assert_int_equal(optics_hll_read(lens, epoch, &value), optics_ok); \
+        value;                                                          \
+    })
+
+// The standard error is 1.04 / sqrt(2^precision) so 4 standard errors keeps the
+// tests from being flaky.
+#define assert_estimate(value, exp, precision)                          \
+    assert_float_equal((value), (exp), (exp) * 4 * 1.04 / sqrt(1UL << (precision)) + 1)
+
+
+// -----------------------------------------------------------------------------
+// open/close
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hll_open_close_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "my_hll";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *lens = optics_hll_alloc(optics, lens_name, 10);
+        if (!lens) optics_abort();
+
+        assert_int_equal(optics_lens_type(lens), optics_hll);
+        assert_string_equal(optics_lens_name(lens), lens_name);
+
+        assert_null(optics_hll_alloc(optics, lens_name, 10));
+        optics_lens_close(lens);
+        assert_null(optics_hll_alloc(optics, lens_name, 10));
+
+        assert_non_null(lens = optics_lens_get(optics, lens_name));
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// alloc_get
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hll_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "blah";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *l0 = optics_hll_alloc_get(optics, lens_name, 10);
+        if (!l0) optics_abort();
+        optics_hll_record(l0, 10);
+
+        struct optics_lens *l1 = optics_hll_alloc_get(optics, lens_name, 10);
+        if (!l1) optics_abort();
+        optics_hll_record(l1, 20);
+
+        struct optics_hll value = checked_hll_read(l0, optics_epoch(optics));
+        assert_float_equal(optics_hll_estimate(&value), 2, 0.1);
+
+        optics_lens_close(l0);
+        optics_lens_free(l1);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// invalid
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hll_invalid_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    assert_null(optics_hll_alloc(optics, "blah", optics_hll_precision_min - 1));
+    assert_null(optics_hll_alloc(optics, "blah", optics_hll_precision_max + 1));
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record/read
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hll_record_read_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hll_alloc(optics, "my_hll", 10);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_hll value = checked_hll_read(lens, epoch);
+    assert_int_equal(value.precision, 10);
+    assert_float_equal(optics_hll_estimate(&value), 0, 0);
+
+    // Duplicates don't affect the estimate.
+    for (size_t i = 0; i < 100; ++i) {
+        for (size_t j = 0; j < 10; ++j) optics_hll_record(lens, j);
+    }
+
+    value = checked_hll_read(lens, epoch);
+    assert_float_equal(optics_hll_estimate(&value), 10, 0.5);
+
+    value = checked_hll_read(lens, epoch);
+    assert_float_equal(optics_hll_estimate(&value), 0, 0);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// error
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hll_error_test)
+{
+    const size_t counts[] = { 100, 1000, 10 * 1000, 100 * 1000 };
+
+    for (size_t precision = 8; precision <= optics_hll_precision_max; precision += 2) {
+        struct optics *optics = optics_create(test_name);
+        struct optics_lens *lens = optics_hll_alloc(optics, "my_hll", precision);
+        optics_epoch_t epoch = optics_epoch(optics);
+
+        for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+            uint64_t base = rng_gen(rng_global());
+            for (size_t j = 0; j < counts[i]; ++j) optics_hll_record(lens, base + j);
+
+            struct optics_hll value = checked_hll_read(lens, epoch);
+            assert_estimate(optics_hll_estimate(&value), counts[i], precision);
+        }
+
+        optics_lens_close(lens);
+        optics_close(optics);
+    }
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// merge
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hll_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *l0 = optics_hll_alloc(optics, "l0", 12);
+    struct optics_lens *l1 = optics_hll_alloc(optics, "l1", 12);
+    struct optics_lens *l2 = optics_hll_alloc(optics, "l2", 10);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    // Half of the values overlap between the two lenses.
+    for (size_t i = 0; i < 10 * 1000; ++i) {
+        optics_hll_record(l0, i);
+        optics_hll_record(l1, 5 * 1000 + i);
+    }
+
+    struct optics_hll value = {0};
+    assert_int_equal(optics_hll_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_hll_read(l1, epoch, &value), optics_ok);
+    assert_estimate(optics_hll_estimate(&value), 15 * 1000, 12);
+
+    assert_int_equal(optics_hll_read(l2, epoch, &value), optics_err);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_lens_close(l2);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hll_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hll_alloc(optics, "my_hll", 10);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_hll_t hll;
+    assert_true(optics_hll_typed(lens, &hll));
+
+    for (size_t i = 0; i < 10; ++i) optics_hll_typed_record(hll, i);
+
+    struct optics_hll value = checked_hll_read(lens, epoch);
+    assert_float_equal(optics_hll_estimate(&value), 10, 0.5);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_hll_typed(lens, &hll));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hll_type_test)
+{
+    const char * lens_name = "blah";
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_hll value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        struct optics_lens *lens = optics_counter_alloc(optics, lens_name);
+
+        assert_false(optics_hll_record(lens, 1));
+        assert_int_equal(optics_hll_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_lens_get(optics, lens_name);
+
+        assert_false(optics_hll_record(lens, 1));
+        assert_int_equal(optics_hll_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch st
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_hll_epoch_st_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hll_alloc(optics, "my_hll", 10);
+
+    for (size_t i = 1; i < 5; ++i) {
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+        optics_hll_record(lens, i);
+
+        struct optics_hll value = checked_hll_read(lens, epoch);
+        assert_float_equal(optics_hll_estimate(&value), i - 1 ? 1 : 0, 0.1);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch mt
+// -----------------------------------------------------------------------------
+
+struct epoch_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+void epoch_test_read_lens(struct epoch_test *test, struct optics_hll *value)
+{
+    optics_epoch_t epoch = optics_epoch_inc(test->optics);
+    assert_int_equal(optics_hll_read(test->lens, epoch, value), optics_ok);
+}
+
+void run_epoch_test(size_t id, void *ctx)
+{
+    struct epoch_test *test = ctx;
+    enum { iterations = 100 * 1000 };
+
+    if (id) {
+        for (size_t i = 0; i < iterations; ++i)
+            optics_hll_record(test->lens, i);
+
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+
+    else {
+        size_t done;
+        struct optics_hll value = {0};
+        size_t writers = test->workers - 1;
+
+        // Every writer records the same values so merging every epoch
+        // should estimate the values recorded by a single writer.
+        do {
+            epoch_test_read_lens(test, &value);
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        // Read whatever is leftover in the remaining epochs
+        for (size_t i = 0; i < 2; ++i)
+            epoch_test_read_lens(test, &value);
+
+        double estimate = optics_hll_estimate(&value);
+        optics_assert(fabs(estimate - iterations) < iterations * 0.1,
+                "%g != %d", estimate, iterations);
+    }
+}
+
+optics_test_head(lens_hll_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hll_alloc(optics, "my_hll", 12);
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    rng_seed_with(rng_global(), 0);
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_hll_open_close_test),
+        cmocka_unit_test(lens_hll_alloc_get_test),
+        cmocka_unit_test(lens_hll_invalid_test),
+        cmocka_unit_test(lens_hll_record_read_test),
+        cmocka_unit_test(lens_hll_error_test),
+        cmocka_unit_test(lens_hll_merge_test),
+        cmocka_unit_test(lens_hll_typed_test),
+        cmocka_unit_test(lens_hll_type_test),
+        cmocka_unit_test(lens_hll_epoch_st_test),
+        cmocka_unit_test(lens_hll_epoch_mt_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,292 @@
+/* lens_meter_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define checked_meter_read(lens, epoch)                                 \
+    ({                                                                  \
+        struct optics_meter value = {0};                                \
+        assert_int_equal(optics_meter_read(lens, epoch, &value), optics_ok); \
+        value;                                                          \
+    })
+
+
+// -----------------------------------------------------------------------------
+// open/close
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_meter_open_close_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "my_meter";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *lens = optics_meter_alloc(optics, lens_name);
+        if (!lens) optics_abort();
+
+        assert_int_equal(optics_lens_type(lens), optics_meter);
+        assert_string_equal(optics_lens_name(lens), lens_name);
+
+        assert_null(optics_meter_alloc(optics, lens_name));
+        optics_lens_close(lens);
+        assert_null(optics_meter_alloc(optics, lens_name));
+
+        assert_non_null(lens = optics_lens_get(optics, lens_name));
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// alloc_get
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_meter_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "blah";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *l0 = optics_meter_alloc_get(optics, lens_name);
+        if (!l0) optics_abort();
+        optics_meter_mark(l0, 1);
+
+        struct optics_lens *l1 = optics_meter_alloc_get(optics, lens_name);
+        if (!l1) optics_abort();
+        optics_meter_mark(l1, 2);
+
+        struct optics_meter value = {0};
+        assert_int_equal(optics_meter_read(l0, optics_epoch(optics), &value), optics_ok);
+        assert_int_equal(value.count, 3);
+
+        optics_lens_close(l0);
+        optics_lens_free(l1);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// mark/read
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_meter_mark_read_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_meter_alloc(optics, "my_meter");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_meter value = checked_meter_read(lens, epoch);
+    assert_int_equal(value.count, 0);
+
+    optics_meter_mark(lens, 10);
+    optics_meter_mark(lens, 10);
+    value = checked_meter_read(lens, epoch);
+    assert_int_equal(value.count, 20);
+
+    // Rates are left to the poller so reads only ever report the count.
+    assert_float_equal(value.rate_1, 0, 0);
+    assert_float_equal(value.rate_5, 0, 0);
+    assert_float_equal(value.rate_15, 0, 0);
+
+    value = checked_meter_read(lens, epoch);
+    assert_int_equal(value.count, 0);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_meter_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_meter_alloc(optics, "my_meter");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_meter_t meter;
+    assert_true(optics_meter_typed(lens, &meter));
+
+    for (size_t i = 0; i < 100; ++i) optics_meter_typed_mark(meter, 1);
+
+    struct optics_meter value = checked_meter_read(lens, epoch);
+    assert_int_equal(value.count, 100);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_meter_typed(lens, &meter));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_meter_type_test)
+{
+    const char * lens_name = "blah";
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_meter value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        struct optics_lens *lens = optics_counter_alloc(optics, lens_name);
+
+        assert_false(optics_meter_mark(lens, 1));
+        assert_int_equal(optics_meter_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_lens_get(optics, lens_name);
+
+        assert_false(optics_meter_mark(lens, 1));
+        assert_int_equal(optics_meter_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch st
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_meter_epoch_st_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_meter_alloc(optics, "my_meter");
+
+    for (size_t i = 1; i < 5; ++i) {
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+        optics_meter_mark(lens, i);
+
+        struct optics_meter value = {0};
+        assert_int_equal(optics_meter_read(lens, epoch, &value), optics_ok);
+        assert_int_equal(value.count, i - 1);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch mt
+// -----------------------------------------------------------------------------
+
+struct epoch_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+int64_t epoch_test_read_lens(struct epoch_test *test)
+{
+    optics_epoch_t epoch = optics_epoch_inc(test->optics);
+
+    struct optics_meter value = {0};
+    optics_assert(optics_meter_read(test->lens, epoch, &value) == optics_ok,
+            "unable to read meter");
+    return value.count;
+}
+
+void run_epoch_test(size_t id, void *ctx)
+{
+    struct epoch_test *test = ctx;
+    enum { iterations = 1000 * 1000 };
+
+    if (id) {
+        for (size_t i = 0; i < iterations; ++i)
+            optics_meter_mark(test->lens, 1);
+
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+
+    else {
+        size_t done;
+        int64_t result = 0;
+        size_t writers = test->workers - 1;
+
+        do {
+            result += epoch_test_read_lens(test);
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        // Read whatever is leftover in the remaining epochs
+        for (size_t i = 0; i < 2; ++i)
+            result += epoch_test_read_lens(test);
+
+        // cmocka just plain sucks when it comes to mt.
+        optics_assert((size_t) result == writers * iterations, "%ld != %lu",
+                result, writers * iterations);
+    }
+}
+
+optics_test_head(lens_meter_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_meter_alloc(optics, "my_meter");
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_meter_open_close_test),
+        cmocka_unit_test(lens_meter_alloc_get_test),
+        cmocka_unit_test(lens_meter_mark_read_test),
+        cmocka_unit_test(lens_meter_typed_test),
+        cmocka_unit_test(lens_meter_type_test),
+        cmocka_unit_test(lens_meter_epoch_st_test),
+        cmocka_unit_test(lens_meter_epoch_mt_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
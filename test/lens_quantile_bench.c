@@ -32,7 +32,7 @@ void run_record_bench(struct optics_bench *b, void *data, size_t id, size_t n)
 optics_test_head(lens_quantile_record_bench_st)
 {
     struct optics *optics = optics_create(test_name);
-    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 50, 0.90, 0.05);
+    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 0.90, 50, 0.05);
 
     struct quantile_bench bench = { optics, lens };
     optics_bench_st(test_name, run_record_bench, &bench);
@@ -46,7 +46,34 @@ optics_test_head(lens_quantile_record_bench_mt)
 {
     assert_mt();
     struct optics *optics = optics_create(test_name);
-    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 50, 0.90, 0.05);
+    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 0.90, 50, 0.05);
+
+    struct quantile_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_quantile_record_striped_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_quantile_alloc_striped(optics, "bob_the_quantile", 0.90, 50, 0.05);
+
+    struct quantile_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_quantile_record_striped_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_quantile_alloc_striped(optics, "bob_the_quantile", 0.90, 50, 0.05);
 
     struct quantile_bench bench = { optics, lens };
     optics_bench_mt(test_name, run_record_bench, &bench);
@@ -77,7 +104,7 @@ void run_read_bench(struct optics_bench *b, void *data, size_t id, size_t n)
 optics_test_head(lens_quantile_read_bench_st)
 {
     struct optics *optics = optics_create(test_name);
-    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 50, 0.90, 0.05);
+    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 0.90, 50, 0.05);
 
     struct quantile_bench bench = { optics, lens };
     optics_bench_st(test_name, run_read_bench, &bench);
@@ -91,7 +118,7 @@ optics_test_head(lens_quantile_read_bench_mt)
 {
     assert_mt();
     struct optics *optics = optics_create(test_name);
-    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 50, 0.90, 0.05);
+    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 0.90, 50, 0.05);
 
     struct quantile_bench bench = { optics, lens };
     optics_bench_mt(test_name, run_read_bench, &bench);
@@ -128,7 +155,21 @@ optics_test_head(lens_quantile_mixed_bench_mt)
 {
     assert_mt();
     struct optics *optics = optics_create(test_name);
-    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 50, 0.90, 0.05);
+    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 0.90, 50, 0.05);
+
+    struct quantile_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_mixed_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_quantile_mixed_striped_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_quantile_alloc_striped(optics, "bob_the_quantile", 0.90, 50, 0.05);
 
     struct quantile_bench bench = { optics, lens };
     optics_bench_mt(test_name, run_mixed_bench, &bench);
@@ -146,9 +187,12 @@ int main(void)
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(lens_quantile_record_bench_st),
         cmocka_unit_test(lens_quantile_record_bench_mt),
+        cmocka_unit_test(lens_quantile_record_striped_bench_st),
+        cmocka_unit_test(lens_quantile_record_striped_bench_mt),
         cmocka_unit_test(lens_quantile_read_bench_st),
         cmocka_unit_test(lens_quantile_read_bench_mt),
-        cmocka_unit_test(lens_quantile_mixed_bench_mt)
+        cmocka_unit_test(lens_quantile_mixed_bench_mt),
+        cmocka_unit_test(lens_quantile_mixed_striped_bench_mt),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -61,6 +61,69 @@ optics_test_head(lens_quantile_update_read_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// update_n
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_quantile_update_n_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 0.90, 70, 0.05);
+
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    double values[100];
+    for (size_t i = 0; i < 100; ++i) values[i] = i;
+
+    for (int i = 0; i < 1000; i++)
+        assert_true(optics_quantile_update_n(lens, values, 100));
+
+    struct optics_quantile value = {0};
+    assert_int_equal(optics_quantile_read(lens, epoch, &value), optics_ok);
+    assert_float_equal(value.sample, 90, 1);
+    assert_int_equal(value.count, 1000 * 100);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_quantile_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_quantile_alloc(optics, "bob_the_quantile", 0.90, 70, 0.05);
+
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_quantile_t quantile;
+    assert_true(optics_quantile_typed(lens, &quantile));
+
+    for (int i = 0; i < 1000; i++) {
+        for (int j = 0; j < 100; j++)
+            optics_quantile_typed_update(quantile, j);
+    }
+
+    struct optics_quantile value = {0};
+    assert_int_equal(optics_quantile_read(lens, epoch, &value), optics_ok);
+    assert_float_equal(value.sample, 90, 1);
+    assert_int_equal(value.count, 1000 * 100);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_quantile_typed(lens, &quantile));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // merge test
 // -----------------------------------------------------------------------------
@@ -141,6 +204,77 @@ optics_test_head(lens_quantile_merge_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// striped
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_quantile_striped_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_quantile_alloc_striped(optics, "bob_the_quantile", 0.90, 70, 0.05);
+
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    for (int i = 0; i < 1000; i++) {
+        for (int j = 0; j < 100; j++)
+            assert_true(optics_quantile_update(lens, j));
+    }
+
+    struct optics_quantile value = {0};
+    assert_int_equal(optics_quantile_read(lens, epoch, &value), optics_ok);
+    assert_float_equal(value.sample, 90, 1);
+    assert_int_equal(value.count, 1000 * 100);
+
+    // Folding the shards is idempotent when nothing was updated in between.
+    value = (struct optics_quantile) {0};
+    assert_int_equal(optics_quantile_read(lens, epoch, &value), optics_ok);
+    assert_float_equal(value.sample, 90, 1);
+    assert_int_equal(value.count, 0);
+
+    double values[100];
+    for (size_t i = 0; i < 100; ++i) values[i] = i;
+
+    for (int i = 0; i < 1000; i++)
+        assert_true(optics_quantile_update_n(lens, values, 100));
+
+    value = (struct optics_quantile) {0};
+    assert_int_equal(optics_quantile_read(lens, epoch, &value), optics_ok);
+    assert_float_equal(value.sample, 90, 1);
+    assert_int_equal(value.count, 1000 * 100);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_quantile_striped_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "bob_the_quantile";
+
+    struct optics_lens *l0 =
+        optics_quantile_alloc_get_striped(optics, lens_name, 0.90, 70, 0.05);
+    if (!l0) optics_abort();
+
+    struct optics_lens *l1 =
+        optics_quantile_alloc_get_striped(optics, lens_name, 0.90, 70, 0.05);
+    if (!l1) optics_abort();
+
+    optics_quantile_update(l0, 1);
+    optics_quantile_update(l1, 2);
+
+    struct optics_quantile value = {0};
+    assert_int_equal(optics_quantile_read(l0, optics_epoch(optics), &value), optics_ok);
+    assert_int_equal(value.count, 2);
+
+    optics_lens_close(l0);
+    optics_lens_free(l1);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // update MT
 // -----------------------------------------------------------------------------
@@ -210,6 +344,25 @@ optics_test_head(lens_quantile_update_read_mt_test)
 }
 optics_test_tail()
 
+optics_test_head(lens_quantile_striped_update_read_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_quantile_alloc_striped(optics, "bob_the_quantile", 0.90, 50, 0.05);
+
+    struct mt_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_mt_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
 // -----------------------------------------------------------------------------
 // setup
 // -----------------------------------------------------------------------------
@@ -219,9 +372,15 @@ int main(void)
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(lens_quantile_open_close_test),
         cmocka_unit_test(lens_quantile_update_read_test),
+        cmocka_unit_test(lens_quantile_update_n_test),
+        cmocka_unit_test(lens_quantile_typed_test),
         cmocka_unit_test(lens_quantile_merge_test),
-        cmocka_unit_test(lens_quantile_update_read_mt_test)
+        cmocka_unit_test(lens_quantile_striped_test),
+        cmocka_unit_test(lens_quantile_striped_alloc_get_test),
+        cmocka_unit_test(lens_quantile_update_read_mt_test),
+        cmocka_unit_test(lens_quantile_striped_update_read_mt_test),
     };
 
+    rng_seed_with(rng_global(), 0);
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
@@ -0,0 +1,110 @@
+/* lens_quantile_vec_bench.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "bench.h"
+
+
+static const double targets[] = { 0.5, 0.9, 0.99 };
+enum { targets_len = sizeof(targets) / sizeof(targets[0]) };
+
+struct quantile_vec_bench
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    struct optics_lens *lenses[targets_len];
+};
+
+
+// -----------------------------------------------------------------------------
+// update bench
+// -----------------------------------------------------------------------------
+
+void run_update_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct quantile_vec_bench *bench = data;
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i)
+        optics_quantile_vec_update(bench->lens, i % 100);
+}
+
+optics_test_head(lens_quantile_vec_update_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_quantile_vec_alloc(optics, "my_quantile_vec", targets, targets_len, 50, 0.05);
+
+    struct quantile_vec_bench bench = { .optics = optics, .lens = lens };
+    optics_bench_st(test_name, run_update_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_quantile_vec_update_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_quantile_vec_alloc(optics, "my_quantile_vec", targets, targets_len, 50, 0.05);
+
+    struct quantile_vec_bench bench = { .optics = optics, .lens = lens };
+    optics_bench_mt(test_name, run_update_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// quantiles bench
+// -----------------------------------------------------------------------------
+
+// Baseline of tracking the same targets with one quantile lens per target.
+void run_quantiles_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct quantile_vec_bench *bench = data;
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < targets_len; ++j)
+            optics_quantile_update(bench->lenses[j], i % 100);
+    }
+}
+
+optics_test_head(lens_quantile_vec_quantiles_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+
+    struct quantile_vec_bench bench = { .optics = optics };
+    for (size_t i = 0; i < targets_len; ++i) {
+        char name[optics_name_max_len];
+        snprintf(name, sizeof(name), "my_quantile_%zu", i);
+        bench.lenses[i] = optics_quantile_alloc(optics, name, targets[i], 50, 0.05);
+    }
+
+    optics_bench_st(test_name, run_quantiles_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_quantile_vec_update_bench_st),
+        cmocka_unit_test(lens_quantile_vec_update_bench_mt),
+        cmocka_unit_test(lens_quantile_vec_quantiles_bench_st),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
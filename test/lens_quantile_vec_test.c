@@ -0,0 +1,379 @@
+/* lens_quantile_vec_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+#include "utils/rng.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+static const double targets[] = { 0.5, 0.9, 0.99 };
+enum { targets_len = sizeof(targets) / sizeof(targets[0]) };
+
+#define checked_quantile_vec_read(lens, epoch)                          \
+    ({                                                                  \
+        struct optics_quantile_vec value = {0};                         \
+        assert_int_equal(optics_quantile_vec_read(lens, epoch, &value), optics_ok); \
+        value;                                                          \
+    })
+
+#define assert_quantile_vec(value)                              \
+    do {                                                        \
+        assert_int_equal((value).len, targets_len);             \
+        for (size_t i = 0; i < targets_len; ++i) {              \
+            assert_float_equal((value).quantiles[i], targets[i], 0); \
+            assert_float_equal((value).samples[i], targets[i] * 100, 2); \
+        }                                                       \
+    } while (false)
+
+
+// -----------------------------------------------------------------------------
+// open/close
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_quantile_vec_open_close_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "my_quantile_vec";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *lens =
+            optics_quantile_vec_alloc(optics, lens_name, targets, targets_len, 50, 0.05);
+        if (!lens) optics_abort();
+
+        assert_int_equal(optics_lens_type(lens), optics_quantile_vec);
+        assert_string_equal(optics_lens_name(lens), lens_name);
+
+        assert_null(optics_quantile_vec_alloc(optics, lens_name, targets, targets_len, 50, 0.05));
+        optics_lens_close(lens);
+        assert_null(optics_quantile_vec_alloc(optics, lens_name, targets, targets_len, 50, 0.05));
+
+        assert_non_null(lens = optics_lens_get(optics, lens_name));
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// alloc_get
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_quantile_vec_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "blah";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *l0 =
+            optics_quantile_vec_alloc_get(optics, lens_name, targets, targets_len, 50, 0.05);
+        if (!l0) optics_abort();
+        optics_quantile_vec_update(l0, 10);
+
+        struct optics_lens *l1 =
+            optics_quantile_vec_alloc_get(optics, lens_name, targets, targets_len, 50, 0.05);
+        if (!l1) optics_abort();
+        optics_quantile_vec_update(l1, 20);
+
+        struct optics_quantile_vec value = checked_quantile_vec_read(l0, optics_epoch(optics));
+        assert_int_equal(value.count, 2);
+
+        optics_lens_close(l0);
+        optics_lens_free(l1);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// invalid
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_quantile_vec_invalid_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    double too_many[optics_quantile_vec_len_max + 1];
+    for (size_t i = 0; i < optics_quantile_vec_len_max + 1; ++i) too_many[i] = 0.5;
+
+    assert_null(optics_quantile_vec_alloc(optics, "blah", targets, 0, 50, 0.05));
+    assert_null(optics_quantile_vec_alloc(
+                    optics, "blah", too_many, optics_quantile_vec_len_max + 1, 50, 0.05));
+
+    const double invalid[] = { 0, 1, -0.5, 1.5, NAN };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i)
+        assert_null(optics_quantile_vec_alloc(optics, "blah", &invalid[i], 1, 50, 0.05));
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// update/read
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_quantile_vec_update_read_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_quantile_vec_alloc(optics, "my_quantile_vec", targets, targets_len, 50, 0.05);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_quantile_vec value = checked_quantile_vec_read(lens, epoch);
+    assert_int_equal(value.len, targets_len);
+    assert_int_equal(value.count, 0);
+    for (size_t i = 0; i < targets_len; ++i)
+        assert_float_equal(value.samples[i], 50, 0);
+
+    for (size_t i = 0; i < 1000; ++i) {
+        for (size_t j = 0; j < 100; ++j)
+            optics_quantile_vec_update(lens, j);
+    }
+
+    value = checked_quantile_vec_read(lens, epoch);
+    assert_int_equal(value.count, 1000 * 100);
+    assert_quantile_vec(value);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// update_n
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_quantile_vec_update_n_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_quantile_vec_alloc(optics, "my_quantile_vec", targets, targets_len, 50, 0.05);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    double values[100];
+    for (size_t i = 0; i < 100; ++i) values[i] = i;
+
+    assert_true(optics_quantile_vec_update_n(lens, values, 0));
+    for (size_t i = 0; i < 1000; ++i)
+        assert_true(optics_quantile_vec_update_n(lens, values, 100));
+
+    struct optics_quantile_vec value = checked_quantile_vec_read(lens, epoch);
+    assert_int_equal(value.count, 1000 * 100);
+    assert_quantile_vec(value);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_quantile_vec_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_quantile_vec_alloc(optics, "my_quantile_vec", targets, targets_len, 50, 0.05);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_quantile_vec_t vec;
+    assert_true(optics_quantile_vec_typed(lens, &vec));
+
+    for (size_t i = 0; i < 1000; ++i) {
+        for (size_t j = 0; j < 100; ++j)
+            optics_quantile_vec_typed_update(vec, j);
+    }
+
+    struct optics_quantile_vec value = checked_quantile_vec_read(lens, epoch);
+    assert_int_equal(value.count, 1000 * 100);
+    assert_quantile_vec(value);
+
+    optics_lens_close(lens);
+
+    lens = optics_quantile_alloc(optics, "my_quantile", 0.5, 50, 0.05);
+    assert_false(optics_quantile_vec_typed(lens, &vec));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// merge
+// -----------------------------------------------------------------------------
+
+// By setting the adjustment to 0 the samples of each lens are fixed which lets
+// us check how often each lens is picked.
+optics_test_head(lens_quantile_vec_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_lens *l0 = optics_quantile_vec_alloc(optics, "l0", targets, targets_len, 0, 0);
+    struct optics_lens *l1 = optics_quantile_vec_alloc(optics, "l1", targets, targets_len, 1, 0);
+
+    enum { iterations = 1000 };
+    size_t picked = 0;
+
+    for (size_t it = 0; it < iterations; ++it) {
+        for (size_t i = 0; i < 100; ++i) optics_quantile_vec_update(l0, 0);
+        for (size_t i = 0; i < 300; ++i) optics_quantile_vec_update(l1, 1);
+
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+
+        struct optics_quantile_vec value = {0};
+        assert_int_equal(optics_quantile_vec_read(l0, epoch, &value), optics_ok);
+        assert_int_equal(optics_quantile_vec_read(l1, epoch, &value), optics_ok);
+        assert_int_equal(value.count, 400);
+
+        // Samples are always picked as a whole.
+        for (size_t i = 1; i < targets_len; ++i)
+            assert_float_equal(value.samples[i], value.samples[0], 0);
+
+        if (value.samples[0] == 1) picked++;
+    }
+
+    assert_float_equal((double) picked / iterations, 0.75, 0.05);
+
+    struct optics_lens *l2 = optics_quantile_vec_alloc(optics, "l2", targets, 2, 0, 0);
+    struct optics_quantile_vec value = checked_quantile_vec_read(l0, optics_epoch(optics));
+    assert_int_equal(optics_quantile_vec_read(l2, optics_epoch(optics), &value), optics_err);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_lens_close(l2);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_quantile_vec_type_test)
+{
+    const char * lens_name = "blah";
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_quantile_vec value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        struct optics_lens *lens = optics_quantile_alloc(optics, lens_name, 0.5, 50, 0.05);
+
+        assert_false(optics_quantile_vec_update(lens, 1));
+        assert_int_equal(optics_quantile_vec_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_lens_get(optics, lens_name);
+
+        assert_false(optics_quantile_vec_update(lens, 1));
+        assert_int_equal(optics_quantile_vec_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// update mt
+// -----------------------------------------------------------------------------
+
+struct mt_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+void run_mt_test(size_t id, void *ctx)
+{
+    struct mt_test *test = ctx;
+    enum { iterations = 1000 };
+
+    if (id) {
+        for (size_t i = 0; i < iterations; ++i) {
+            for (size_t j = 0; j < 100; ++j)
+                optics_quantile_vec_update(test->lens, j);
+        }
+
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+    else {
+        size_t done;
+        size_t writers = test->workers - 1;
+
+        do {
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        struct optics_quantile_vec value =
+            checked_quantile_vec_read(test->lens, optics_epoch(test->optics));
+        assert_int_equal(value.count, writers * iterations * 100);
+        assert_quantile_vec(value);
+    }
+}
+
+optics_test_head(lens_quantile_vec_update_read_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens =
+        optics_quantile_vec_alloc(optics, "my_quantile_vec", targets, targets_len, 50, 0.05);
+
+    struct mt_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_mt_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    rng_seed_with(rng_global(), 0);
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_quantile_vec_open_close_test),
+        cmocka_unit_test(lens_quantile_vec_alloc_get_test),
+        cmocka_unit_test(lens_quantile_vec_invalid_test),
+        cmocka_unit_test(lens_quantile_vec_update_read_test),
+        cmocka_unit_test(lens_quantile_vec_update_n_test),
+        cmocka_unit_test(lens_quantile_vec_typed_test),
+        cmocka_unit_test(lens_quantile_vec_merge_test),
+        cmocka_unit_test(lens_quantile_vec_type_test),
+        cmocka_unit_test(lens_quantile_vec_update_read_mt_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,307 @@
+/* lens_sampling_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+#include "optics_inline.h"
+#include "utils/rng.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+enum { iterations = 100 * 1000 };
+
+// Kept events follow a binomial distribution which reads scale back up by the
+// sampling rate so 5% is well over 5 standard deviations for the rates used in
+// these tests.
+#define assert_sampled(count, n)                                        \
+    do {                                                                \
+        double exp = (n);                                               \
+        assert_float_equal((count), exp, exp * 0.05);                   \
+    } while (false)
+
+static int64_t counter_read(struct optics_lens *lens, optics_epoch_t epoch)
+{
+    int64_t value = 0;
+    assert_int_equal(optics_counter_read(lens, epoch, &value), optics_ok);
+    return value;
+}
+
+
+// -----------------------------------------------------------------------------
+// set
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sampling_set_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_lens *counter = optics_counter_alloc(optics, "my_counter");
+    assert_int_equal(optics_lens_sampling(counter), 1);
+
+    assert_false(optics_lens_set_sampling(counter, 0));
+    assert_false(optics_lens_set_sampling(counter, 1UL << 32));
+    assert_int_equal(optics_lens_sampling(counter), 1);
+
+    struct optics_inline_counter inline_counter;
+    assert_true(optics_lens_set_sampling(counter, 10));
+    assert_int_equal(optics_lens_sampling(counter), 10);
+    assert_false(optics_inline_counter_open(counter, &inline_counter));
+
+    assert_true(optics_lens_set_sampling(counter, 1));
+    assert_int_equal(optics_lens_sampling(counter), 1);
+    assert_true(optics_inline_counter_open(counter, &inline_counter));
+
+    struct optics_lens *dist = optics_dist_alloc(optics, "my_dist");
+    assert_true(optics_lens_set_sampling(dist, 10));
+
+    const uint64_t buckets[] = {10, 20};
+    struct optics_lens *histo = optics_histo_alloc(optics, "my_histo", buckets, 2);
+    assert_true(optics_lens_set_sampling(histo, 10));
+
+    struct optics_lens *gauge = optics_gauge_alloc(optics, "my_gauge");
+    assert_false(optics_lens_set_sampling(gauge, 10));
+    assert_int_equal(optics_lens_sampling(gauge), 1);
+
+    optics_lens_close(counter);
+    optics_lens_close(dist);
+    optics_lens_close(histo);
+    optics_lens_close(gauge);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// counter
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sampling_counter_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+    assert_true(optics_lens_set_sampling(lens, 10));
+
+    for (size_t i = 0; i < iterations; ++i) assert_true(optics_counter_inc(lens, 1));
+    assert_sampled(counter_read(lens, epoch), iterations);
+
+    optics_counter_t counter;
+    assert_true(optics_counter_typed(lens, &counter));
+    for (size_t i = 0; i < iterations; ++i) optics_counter_typed_inc(counter, 1);
+    assert_sampled(counter_read(lens, epoch), iterations);
+
+    int64_t values[100];
+    for (size_t i = 0; i < 100; ++i) values[i] = 1;
+    for (size_t i = 0; i < iterations / 100; ++i)
+        assert_true(optics_counter_inc_n(lens, values, 100));
+    assert_sampled(counter_read(lens, epoch), iterations);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// interleaved
+// -----------------------------------------------------------------------------
+
+// Lenses with different rates share the same thread-local budget which
+// shouldn't bias any of them.
+optics_test_head(lens_sampling_interleaved_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_lens *l0 = optics_counter_alloc(optics, "my_counter_0");
+    assert_true(optics_lens_set_sampling(l0, 2));
+
+    struct optics_lens *l1 = optics_counter_alloc(optics, "my_counter_1");
+    assert_true(optics_lens_set_sampling(l1, 20));
+
+    struct optics_lens *l2 = optics_counter_alloc(optics, "my_counter_2");
+
+    for (size_t i = 0; i < iterations; ++i) {
+        optics_counter_inc(l0, 1);
+        optics_counter_inc(l1, 1);
+        optics_counter_inc(l1, 1);
+        optics_counter_inc(l2, 1);
+    }
+
+    assert_sampled(counter_read(l0, epoch), iterations);
+    assert_sampled(counter_read(l1, epoch), 2 * iterations);
+    assert_int_equal(counter_read(l2, epoch), iterations);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_lens_close(l2);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// dist
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sampling_dist_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_lens *lens = optics_dist_alloc(optics, "my_dist");
+    assert_true(optics_lens_set_sampling(lens, 10));
+
+    struct optics_dist value = {0};
+    for (size_t i = 0; i < iterations; ++i) assert_true(optics_dist_record(lens, i % 100));
+    assert_int_equal(optics_dist_read(lens, epoch, &value), optics_ok);
+    assert_sampled(value.n, iterations);
+    assert_sampled(value.recorded * 10, iterations);
+    assert_float_equal(value.p50, 50, 5);
+
+    optics_dist_t dist;
+    assert_true(optics_dist_typed(lens, &dist));
+    for (size_t i = 0; i < iterations; ++i) optics_dist_typed_record(dist, i % 100);
+
+    value = (struct optics_dist) {0};
+    assert_int_equal(optics_dist_read(lens, epoch, &value), optics_ok);
+    assert_sampled(value.n, iterations);
+
+    double values[100];
+    for (size_t i = 0; i < 100; ++i) values[i] = i;
+    for (size_t i = 0; i < iterations / 100; ++i)
+        assert_true(optics_dist_record_n(lens, values, 100));
+
+    value = (struct optics_dist) {0};
+    assert_int_equal(optics_dist_read(lens, epoch, &value), optics_ok);
+    assert_sampled(value.n, iterations);
+    assert_float_equal(value.p50, 50, 5);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+// Full reservoirs are merged based on their scaled counts so a sampled lens
+// isn't drowned out by an unsampled one.
+optics_test_head(lens_sampling_dist_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_lens *l0 = optics_dist_alloc(optics, "my_dist_0");
+    struct optics_lens *l1 = optics_dist_alloc(optics, "my_dist_1");
+    assert_true(optics_lens_set_sampling(l1, 10));
+
+    for (size_t i = 0; i < iterations; ++i) {
+        optics_dist_record(l0, 1);
+        optics_dist_record(l1, 2);
+    }
+
+    struct optics_dist value = {0};
+    assert_int_equal(optics_dist_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_dist_read(l1, epoch, &value), optics_ok);
+    assert_sampled(value.n, 2 * iterations);
+
+    size_t ones = 0;
+    for (size_t i = 0; i < value.reservoir_len; ++i) ones += value.samples[i] == 1;
+    assert_float_equal(ones, value.reservoir_len / 2, value.reservoir_len / 10);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// histo
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sampling_histo_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    const uint64_t buckets[] = {10, 20};
+    struct optics_lens *lens = optics_histo_alloc(optics, "my_histo", buckets, 2);
+    assert_true(optics_lens_set_sampling(lens, 10));
+
+    struct optics_histo value = {0};
+    for (size_t i = 0; i < iterations; ++i) assert_true(optics_histo_inc(lens, 15));
+    assert_int_equal(optics_histo_read(lens, epoch, &value), optics_ok);
+    assert_sampled(value.counts[0], iterations);
+
+    optics_histo_t histo;
+    assert_true(optics_histo_typed(lens, &histo));
+    for (size_t i = 0; i < iterations; ++i) optics_histo_typed_inc(histo, 15);
+
+    value = (struct optics_histo) {0};
+    assert_int_equal(optics_histo_read(lens, epoch, &value), optics_ok);
+    assert_sampled(value.counts[0], iterations);
+
+    double values[100];
+    for (size_t i = 0; i < 100; ++i) values[i] = 15;
+    for (size_t i = 0; i < iterations / 100; ++i)
+        assert_true(optics_histo_inc_n(lens, values, 100));
+
+    value = (struct optics_histo) {0};
+    assert_int_equal(optics_histo_read(lens, epoch, &value), optics_ok);
+    assert_sampled(value.counts[0], iterations);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// batch
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sampling_batch_test)
+{
+    struct optics *optics = optics_create(test_name);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_lens *lens = optics_counter_alloc(optics, "my_counter");
+    assert_true(optics_lens_set_sampling(lens, 10));
+
+    struct optics_batch *batch = optics_batch_alloc(lens);
+    for (size_t i = 0; i < iterations; ++i)
+        assert_true(optics_batch_counter_inc(batch, 1));
+    optics_batch_free(batch);
+
+    assert_sampled(counter_read(lens, epoch), iterations);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    rng_seed_with(rng_global(), 0);
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_sampling_set_test),
+        cmocka_unit_test(lens_sampling_counter_test),
+        cmocka_unit_test(lens_sampling_interleaved_test),
+        cmocka_unit_test(lens_sampling_dist_test),
+        cmocka_unit_test(lens_sampling_histo_test),
+        cmocka_unit_test(lens_sampling_batch_test),
+        cmocka_unit_test(lens_sampling_dist_merge_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
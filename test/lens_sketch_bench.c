@@ -0,0 +1,135 @@
+/* lens_sketch_bench.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "bench.h"
+
+
+struct sketch_bench
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+};
+
+
+// -----------------------------------------------------------------------------
+// record bench
+// -----------------------------------------------------------------------------
+
+void run_record_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    struct sketch_bench *bench = data;
+    optics_bench_start(b);
+
+    double value = id;
+    for (size_t i = 0; i < n; ++i)
+        optics_sketch_record(bench->lens, value += 7.919);
+}
+
+
+optics_test_head(lens_sketch_record_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_sketch_alloc(optics, "my_sketch", 0.01, 1);
+
+    struct sketch_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+optics_test_head(lens_sketch_record_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_sketch_alloc(optics, "my_sketch", 0.01, 1);
+
+    struct sketch_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// read bench
+// -----------------------------------------------------------------------------
+
+void run_read_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct sketch_bench *bench = data;
+    optics_epoch_t epoch = optics_epoch(bench->optics);
+
+    optics_bench_start(b);
+
+    struct optics_sketch value = {0};
+    for (size_t i = 0; i < n; ++i)
+        optics_sketch_read(bench->lens, epoch, &value);
+}
+
+optics_test_head(lens_sketch_read_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_sketch_alloc(optics, "my_sketch", 0.01, 1);
+
+    struct sketch_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_read_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// percentile bench
+// -----------------------------------------------------------------------------
+
+void run_percentile_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    const struct optics_sketch *value = data;
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i) {
+        double result = optics_sketch_percentile(value, 99);
+        optics_no_opt_val(result);
+    }
+}
+
+optics_test_head(lens_sketch_percentile_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_sketch_alloc(optics, "my_sketch", 0.01, 1);
+
+    for (size_t i = 0; i < 1000 * 1000; ++i)
+        optics_sketch_record(lens, i);
+
+    struct optics_sketch value = {0};
+    optics_sketch_read(lens, optics_epoch(optics), &value);
+    optics_bench_st(test_name, run_percentile_bench, &value);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_sketch_record_bench_st),
+        cmocka_unit_test(lens_sketch_record_bench_mt),
+        cmocka_unit_test(lens_sketch_read_bench_st),
+        cmocka_unit_test(lens_sketch_percentile_bench_st),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,454 @@
+/* lens_sketch_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+#include "utils/rng.h"
+
+#include <math.h>
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define checked_sketch_read(lens, epoch)                                \
+    ({                                                                  \
+        struct optics_sketch value = {0};                               \
+        assert_int_equal(optics_sketch_read(lens, epoch, &value), optics_ok); \
+        value;                                                          \
+    })
+
+static size_t sketch_count(const struct optics_sketch *sketch)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < optics_sketch_buckets_max; ++i) count += sketch->counts[i];
+    return count;
+}
+
+#define assert_rel_error(value, exp, alpha)                             \
+    assert_float_equal((value), (exp), (exp) * (alpha) + 1e-9)
+
+
+// -----------------------------------------------------------------------------
+// open/close
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sketch_open_close_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "my_sketch";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *lens = optics_sketch_alloc(optics, lens_name, 0.01, 1);
+        if (!lens) optics_abort();
+
+        assert_int_equal(optics_lens_type(lens), optics_sketch);
+        assert_string_equal(optics_lens_name(lens), lens_name);
+
+        assert_null(optics_sketch_alloc(optics, lens_name, 0.01, 1));
+        optics_lens_close(lens);
+        assert_null(optics_sketch_alloc(optics, lens_name, 0.01, 1));
+
+        assert_non_null(lens = optics_lens_get(optics, lens_name));
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// alloc_get
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sketch_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "blah";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *l0 = optics_sketch_alloc_get(optics, lens_name, 0.01, 1);
+        if (!l0) optics_abort();
+        optics_sketch_record(l0, 10);
+
+        struct optics_lens *l1 = optics_sketch_alloc_get(optics, lens_name, 0.01, 1);
+        if (!l1) optics_abort();
+        optics_sketch_record(l1, 20);
+
+        struct optics_sketch value = checked_sketch_read(l0, optics_epoch(optics));
+        assert_int_equal(sketch_count(&value), 2);
+
+        optics_lens_close(l0);
+        optics_lens_free(l1);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// invalid
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sketch_invalid_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    assert_null(optics_sketch_alloc(optics, "blah", 0, 1));
+    assert_null(optics_sketch_alloc(optics, "blah", 1, 1));
+    assert_null(optics_sketch_alloc(optics, "blah", NAN, 1));
+    assert_null(optics_sketch_alloc(optics, "blah", 0.01, 0));
+    assert_null(optics_sketch_alloc(optics, "blah", 0.01, -1));
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record/read
+// -----------------------------------------------------------------------------
+// record_n
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sketch_record_n_test)
+{
+    const double alpha = 0.01;
+
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_sketch_alloc(optics, "my_sketch", alpha, 1);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    double values[1000];
+    for (size_t i = 0; i < 1000; ++i) values[i] = i + 1;
+
+    assert_true(optics_sketch_record_n(lens, values, 0));
+    struct optics_sketch value = checked_sketch_read(lens, epoch);
+    assert_int_equal(sketch_count(&value), 0);
+
+    assert_true(optics_sketch_record_n(lens, values, 1000));
+    value = checked_sketch_read(lens, epoch);
+    assert_int_equal(sketch_count(&value), 1000);
+    assert_rel_error(optics_sketch_percentile(&value, 50), 501, alpha);
+    assert_rel_error(optics_sketch_percentile(&value, 90), 901, alpha);
+    assert_rel_error(optics_sketch_percentile(&value, 99), 991, alpha);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sketch_record_read_test)
+{
+    const double alpha = 0.01;
+
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_sketch_alloc(optics, "my_sketch", alpha, 1);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_sketch value = checked_sketch_read(lens, epoch);
+    assert_float_equal(value.alpha, alpha, 0);
+    assert_float_equal(value.lowest, 1, 0);
+    assert_int_equal(sketch_count(&value), 0);
+    assert_float_equal(optics_sketch_percentile(&value, 50), 0, 0);
+
+    for (size_t i = 1; i <= 1000; ++i) optics_sketch_record(lens, i);
+
+    value = checked_sketch_read(lens, epoch);
+    assert_int_equal(sketch_count(&value), 1000);
+    assert_rel_error(optics_sketch_percentile(&value, 50), 501, alpha);
+    assert_rel_error(optics_sketch_percentile(&value, 90), 901, alpha);
+    assert_rel_error(optics_sketch_percentile(&value, 99), 991, alpha);
+    assert_rel_error(optics_sketch_percentile(&value, 100), 1000, alpha);
+
+    value = checked_sketch_read(lens, epoch);
+    assert_int_equal(sketch_count(&value), 0);
+
+    // Values outside of the range are collapsed into the edge buckets.
+    optics_sketch_record(lens, 0);
+    optics_sketch_record(lens, -1);
+    optics_sketch_record(lens, NAN);
+    optics_sketch_record(lens, 1e100);
+
+    value = checked_sketch_read(lens, epoch);
+    assert_int_equal(sketch_count(&value), 4);
+    assert_int_equal(value.counts[0], 3);
+    assert_int_equal(value.counts[optics_sketch_buckets_max - 1], 1);
+    assert_float_equal(optics_sketch_percentile(&value, 50), 1, 0);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sketch_typed_test)
+{
+    const double alpha = 0.01;
+
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_sketch_alloc(optics, "my_sketch", alpha, 1);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_sketch_t sketch;
+    assert_true(optics_sketch_typed(lens, &sketch));
+
+    for (size_t i = 1; i <= 1000; ++i) optics_sketch_typed_record(sketch, i);
+
+    struct optics_sketch value = checked_sketch_read(lens, epoch);
+    assert_int_equal(sketch_count(&value), 1000);
+    assert_rel_error(optics_sketch_percentile(&value, 50), 501, alpha);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_sketch_typed(lens, &sketch));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// error
+// -----------------------------------------------------------------------------
+
+static int cmp_double(const void *lhs, const void *rhs)
+{
+    double a = *((const double *) lhs);
+    double b = *((const double *) rhs);
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+optics_test_head(lens_sketch_error_test)
+{
+    enum { n = 10 * 1000 };
+    static double values[n];
+
+    const double alphas[] = { 0.05, 0.02, 0.01 };
+    for (size_t i = 0; i < sizeof(alphas) / sizeof(alphas[0]); ++i) {
+        struct optics *optics = optics_create(test_name);
+        struct optics_lens *lens = optics_sketch_alloc(optics, "my_sketch", alphas[i], 1);
+        optics_epoch_t epoch = optics_epoch(optics);
+
+        for (size_t j = 0; j < n; ++j) {
+            values[j] = 1 + rng_gen_range(rng_global(), 0, 10 * 1000);
+            optics_sketch_record(lens, values[j]);
+        }
+        qsort(values, n, sizeof(values[0]), cmp_double);
+
+        struct optics_sketch value = checked_sketch_read(lens, epoch);
+
+        const double percentiles[] = { 50, 90, 99, 99.9 };
+        for (size_t j = 0; j < sizeof(percentiles) / sizeof(percentiles[0]); ++j) {
+            double exp = values[(size_t) ((n * percentiles[j]) / 100)];
+            assert_rel_error(optics_sketch_percentile(&value, percentiles[j]), exp, alphas[i]);
+        }
+
+        optics_lens_close(lens);
+        optics_close(optics);
+    }
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// merge
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sketch_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *l0 = optics_sketch_alloc(optics, "l0", 0.01, 1);
+    struct optics_lens *l1 = optics_sketch_alloc(optics, "l1", 0.01, 1);
+    struct optics_lens *l2 = optics_sketch_alloc(optics, "l2", 0.02, 1);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    for (size_t i = 1; i <= 500; ++i) {
+        optics_sketch_record(l0, i);
+        optics_sketch_record(l1, 500 + i);
+    }
+
+    struct optics_sketch value = {0};
+    assert_int_equal(optics_sketch_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_sketch_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(sketch_count(&value), 1000);
+    assert_rel_error(optics_sketch_percentile(&value, 50), 501, 0.01);
+    assert_rel_error(optics_sketch_percentile(&value, 99), 991, 0.01);
+
+    assert_int_equal(optics_sketch_read(l2, epoch, &value), optics_err);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_lens_close(l2);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sketch_type_test)
+{
+    const char * lens_name = "blah";
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_sketch value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        struct optics_lens *lens = optics_counter_alloc(optics, lens_name);
+
+        assert_false(optics_sketch_record(lens, 1));
+        assert_int_equal(optics_sketch_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_lens_get(optics, lens_name);
+
+        assert_false(optics_sketch_record(lens, 1));
+        assert_int_equal(optics_sketch_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch st
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_sketch_epoch_st_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_sketch_alloc(optics, "my_sketch", 0.01, 1);
+
+    for (size_t i = 1; i < 5; ++i) {
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+        optics_sketch_record(lens, i);
+
+        struct optics_sketch value = checked_sketch_read(lens, epoch);
+        assert_int_equal(sketch_count(&value), i - 1 ? 1 : 0);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch mt
+// -----------------------------------------------------------------------------
+
+struct epoch_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+size_t epoch_test_read_lens(struct epoch_test *test)
+{
+    optics_epoch_t epoch = optics_epoch_inc(test->optics);
+
+    struct optics_sketch value = checked_sketch_read(test->lens, epoch);
+    return sketch_count(&value);
+}
+
+void run_epoch_test(size_t id, void *ctx)
+{
+    struct epoch_test *test = ctx;
+    enum { iterations = 1000 * 1000 };
+
+    if (id) {
+        for (size_t i = 0; i < iterations; ++i)
+            optics_sketch_record(test->lens, i);
+
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+
+    else {
+        size_t done;
+        uint64_t result = 0;
+        size_t writers = test->workers - 1;
+
+        do {
+            result += epoch_test_read_lens(test);
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        // Read whatever is leftover in the remaining epochs
+        for (size_t i = 0; i < 2; ++i)
+            result += epoch_test_read_lens(test);
+
+        // cmocka just plain sucks when it comes to mt.
+        optics_assert(result == writers * iterations, "%lu != %lu",
+                result, writers * iterations);
+    }
+}
+
+optics_test_head(lens_sketch_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_sketch_alloc(optics, "my_sketch", 0.01, 1);
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    rng_seed_with(rng_global(), 0);
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_sketch_open_close_test),
+        cmocka_unit_test(lens_sketch_alloc_get_test),
+        cmocka_unit_test(lens_sketch_invalid_test),
+        cmocka_unit_test(lens_sketch_record_read_test),
+        cmocka_unit_test(lens_sketch_record_n_test),
+        cmocka_unit_test(lens_sketch_typed_test),
+        cmocka_unit_test(lens_sketch_error_test),
+        cmocka_unit_test(lens_sketch_merge_test),
+        cmocka_unit_test(lens_sketch_type_test),
+        cmocka_unit_test(lens_sketch_epoch_st_test),
+        cmocka_unit_test(lens_sketch_epoch_mt_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,377 @@
+/* lens_summary_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define checked_summary_read(lens, epoch)                               \
+    ({                                                                  \
+        struct optics_summary value = {0};                              \
+        assert_int_equal(optics_summary_read(lens, epoch, &value), optics_ok); \
+        value;                                                          \
+    })
+
+
+// -----------------------------------------------------------------------------
+// open/close
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_summary_open_close_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "my_summary";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *lens = optics_summary_alloc(optics, lens_name);
+        if (!lens) optics_abort();
+
+        assert_int_equal(optics_lens_type(lens), optics_summary);
+        assert_string_equal(optics_lens_name(lens), lens_name);
+
+        assert_null(optics_summary_alloc(optics, lens_name));
+        optics_lens_close(lens);
+        assert_null(optics_summary_alloc(optics, lens_name));
+
+        assert_non_null(lens = optics_lens_get(optics, lens_name));
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// alloc_get
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_summary_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "blah";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *l0 = optics_summary_alloc_get(optics, lens_name);
+        if (!l0) optics_abort();
+        optics_summary_record(l0, 1);
+
+        struct optics_lens *l1 = optics_summary_alloc_get(optics, lens_name);
+        if (!l1) optics_abort();
+        optics_summary_record(l1, 2);
+
+        struct optics_summary value = checked_summary_read(l0, optics_epoch(optics));
+        assert_int_equal(value.count, 2);
+        assert_float_equal(value.sum, 3, 0);
+
+        optics_lens_close(l0);
+        optics_lens_free(l1);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record/read
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_summary_record_read_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_summary_alloc(optics, "my_summary");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_summary value = checked_summary_read(lens, epoch);
+    assert_int_equal(value.count, 0);
+    assert_float_equal(optics_summary_mean(&value), 0, 0);
+    assert_float_equal(optics_summary_stddev(&value), 0, 0);
+
+    const double values[] = { 2, 4, 4, 4, 5, 5, 7, 9 };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+        optics_summary_record(lens, values[i]);
+
+    value = checked_summary_read(lens, epoch);
+    assert_int_equal(value.count, 8);
+    assert_float_equal(value.sum, 40, 0);
+    assert_float_equal(value.sumsq, 232, 0);
+    assert_float_equal(value.min, 2, 0);
+    assert_float_equal(value.max, 9, 0);
+    assert_float_equal(optics_summary_mean(&value), 5, 1e-9);
+    assert_float_equal(optics_summary_stddev(&value), 2, 1e-9);
+
+    value = checked_summary_read(lens, epoch);
+    assert_int_equal(value.count, 0);
+
+    // Bounds are reset by the read.
+    optics_summary_record(lens, -1);
+    value = checked_summary_read(lens, epoch);
+    assert_float_equal(value.min, -1, 0);
+    assert_float_equal(value.max, -1, 0);
+    assert_float_equal(optics_summary_stddev(&value), 0, 0);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record_n
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_summary_record_n_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_summary_alloc(optics, "my_summary");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    assert_true(optics_summary_record_n(lens, NULL, 0));
+    struct optics_summary value = checked_summary_read(lens, epoch);
+    assert_int_equal(value.count, 0);
+
+    const double values[] = { 2, 4, 4, 4, 5, 5, 7, 9 };
+    assert_true(optics_summary_record_n(lens, values, sizeof(values) / sizeof(values[0])));
+    optics_summary_record(lens, 10);
+
+    value = checked_summary_read(lens, epoch);
+    assert_int_equal(value.count, 9);
+    assert_float_equal(value.sum, 50, 0);
+    assert_float_equal(value.sumsq, 332, 0);
+    assert_float_equal(value.min, 2, 0);
+    assert_float_equal(value.max, 10, 0);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// merge
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_summary_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *l0 = optics_summary_alloc(optics, "l0");
+    struct optics_lens *l1 = optics_summary_alloc(optics, "l1");
+    struct optics_lens *l2 = optics_summary_alloc(optics, "l2");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    for (size_t i = 0; i < 10; ++i) {
+        optics_summary_record(l0, i);
+        optics_summary_record(l1, 10 + i);
+    }
+
+    struct optics_summary value = {0};
+    assert_int_equal(optics_summary_read(l2, epoch, &value), optics_ok);
+    assert_int_equal(optics_summary_read(l1, epoch, &value), optics_ok);
+    assert_int_equal(optics_summary_read(l0, epoch, &value), optics_ok);
+
+    assert_int_equal(value.count, 20);
+    assert_float_equal(value.sum, 190, 0);
+    assert_float_equal(value.min, 0, 0);
+    assert_float_equal(value.max, 19, 0);
+    assert_float_equal(optics_summary_mean(&value), 9.5, 1e-9);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_lens_close(l2);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_summary_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_summary_alloc(optics, "my_summary");
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_summary_t summary;
+    assert_true(optics_summary_typed(lens, &summary));
+
+    for (size_t i = 0; i < 10; ++i) optics_summary_typed_record(summary, i);
+
+    struct optics_summary value = checked_summary_read(lens, epoch);
+    assert_int_equal(value.count, 10);
+    assert_float_equal(value.sum, 45, 0);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_summary_typed(lens, &summary));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_summary_type_test)
+{
+    const char * lens_name = "blah";
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_summary value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        struct optics_lens *lens = optics_counter_alloc(optics, lens_name);
+
+        assert_false(optics_summary_record(lens, 1));
+        assert_false(optics_summary_record_n(lens, NULL, 0));
+        assert_int_equal(optics_summary_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_lens_get(optics, lens_name);
+
+        assert_false(optics_summary_record(lens, 1));
+        assert_false(optics_summary_record_n(lens, NULL, 0));
+        assert_int_equal(optics_summary_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch st
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_summary_epoch_st_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_summary_alloc(optics, "my_summary");
+
+    for (size_t i = 1; i < 5; ++i) {
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+        optics_summary_record(lens, i);
+
+        struct optics_summary value = checked_summary_read(lens, epoch);
+        assert_int_equal(value.count, i - 1 ? 1 : 0);
+        assert_float_equal(value.sum, i - 1, 0);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch mt
+// -----------------------------------------------------------------------------
+
+struct epoch_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+void epoch_test_read_lens(struct epoch_test *test, struct optics_summary *value)
+{
+    optics_epoch_t epoch = optics_epoch_inc(test->optics);
+    assert_int_equal(optics_summary_read(test->lens, epoch, value), optics_ok);
+}
+
+void run_epoch_test(size_t id, void *ctx)
+{
+    struct epoch_test *test = ctx;
+    enum { iterations = 100 * 1000 };
+
+    if (id) {
+        for (size_t i = 0; i < iterations; ++i)
+            optics_summary_record(test->lens, id);
+
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+
+    else {
+        size_t done;
+        struct optics_summary value = {0};
+        size_t writers = test->workers - 1;
+
+        do {
+            epoch_test_read_lens(test, &value);
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        // Read whatever is leftover in the remaining epochs
+        for (size_t i = 0; i < 2; ++i)
+            epoch_test_read_lens(test, &value);
+
+        // Small integers are represented exactly so the sum can be checked
+        // exactly.
+        double sum = iterations * (writers * (writers + 1) / 2);
+        optics_assert(value.count == writers * iterations,
+                "%lu != %lu", value.count, writers * iterations);
+        optics_assert(value.sum == sum, "%g != %g", value.sum, sum);
+        optics_assert(value.min == 1, "%g != 1", value.min);
+        optics_assert(value.max == writers, "%g != %lu", value.max, writers);
+    }
+}
+
+optics_test_head(lens_summary_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_summary_alloc(optics, "my_summary");
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_summary_open_close_test),
+        cmocka_unit_test(lens_summary_alloc_get_test),
+        cmocka_unit_test(lens_summary_record_read_test),
+        cmocka_unit_test(lens_summary_record_n_test),
+        cmocka_unit_test(lens_summary_merge_test),
+        cmocka_unit_test(lens_summary_typed_test),
+        cmocka_unit_test(lens_summary_type_test),
+        cmocka_unit_test(lens_summary_epoch_st_test),
+        cmocka_unit_test(lens_summary_epoch_mt_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
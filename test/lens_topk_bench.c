@@ -0,0 +1,120 @@
+/* lens_topk_bench.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "bench.h"
+
+
+struct topk_bench
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t items;
+};
+
+
+// -----------------------------------------------------------------------------
+// inc bench
+// -----------------------------------------------------------------------------
+
+void run_inc_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct topk_bench *bench = data;
+
+    char items[bench->items][optics_topk_item_max_len];
+    for (size_t i = 0; i < bench->items; ++i)
+        snprintf(items[i], sizeof(items[i]), "tenant_%lu", i);
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i)
+        optics_topk_inc(bench->lens, items[i % bench->items], 1);
+}
+
+// Fewer items than the capacity of the lens so every inc is a hit.
+optics_test_head(lens_topk_inc_hit_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_topk_alloc(optics, "my_topk", 10);
+
+    struct topk_bench bench = { optics, lens, 16 };
+    optics_bench_st(test_name, run_inc_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+// More items than the capacity of the lens so every inc is an eviction.
+optics_test_head(lens_topk_inc_evict_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_topk_alloc(optics, "my_topk", 10);
+
+    struct topk_bench bench = { optics, lens, 4 * optics_topk_items_max };
+    optics_bench_st(test_name, run_inc_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_topk_inc_hit_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_topk_alloc(optics, "my_topk", 10);
+
+    struct topk_bench bench = { optics, lens, 16 };
+    optics_bench_mt(test_name, run_inc_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// read bench
+// -----------------------------------------------------------------------------
+
+void run_read_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct topk_bench *bench = data;
+    optics_epoch_t epoch = optics_epoch(bench->optics);
+
+    optics_bench_start(b);
+
+    struct optics_topk value = {0};
+    for (size_t i = 0; i < n; ++i)
+        optics_topk_read(bench->lens, epoch, &value);
+}
+
+optics_test_head(lens_topk_read_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_topk_alloc(optics, "my_topk", 10);
+
+    struct topk_bench bench = { optics, lens, 0 };
+    optics_bench_st(test_name, run_read_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_topk_inc_hit_bench_st),
+        cmocka_unit_test(lens_topk_inc_evict_bench_st),
+        cmocka_unit_test(lens_topk_inc_hit_bench_mt),
+        cmocka_unit_test(lens_topk_read_bench_st),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,417 @@
+/* lens_topk_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+#include "utils/rng.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define checked_topk_read(lens, epoch)                                  \
+    ({                                                                  \
+        struct optics_topk value = {0};                                 \
+        assert_int_equal(optics_topk_read(lens, epoch, &value), optics_ok); \
+        value;                                                          \
+    })
+
+#define assert_topk_item(value, i, exp_item, exp_count)                 \
+    do {                                                                \
+        assert_string_equal((value).items[i].item, (exp_item));         \
+        assert_int_equal((value).items[i].count, (exp_count));          \
+    } while (false)
+
+
+// -----------------------------------------------------------------------------
+// open/close
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_topk_open_close_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "my_topk";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *lens = optics_topk_alloc(optics, lens_name, 10);
+        if (!lens) optics_abort();
+
+        assert_int_equal(optics_lens_type(lens), optics_topk);
+        assert_string_equal(optics_lens_name(lens), lens_name);
+
+        assert_null(optics_topk_alloc(optics, lens_name, 10));
+        optics_lens_close(lens);
+        assert_null(optics_topk_alloc(optics, lens_name, 10));
+
+        assert_non_null(lens = optics_lens_get(optics, lens_name));
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// alloc_get
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_topk_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "blah";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *l0 = optics_topk_alloc_get(optics, lens_name, 10);
+        if (!l0) optics_abort();
+        optics_topk_inc(l0, "a", 1);
+
+        struct optics_lens *l1 = optics_topk_alloc_get(optics, lens_name, 10);
+        if (!l1) optics_abort();
+        optics_topk_inc(l1, "a", 2);
+
+        struct optics_topk value = checked_topk_read(l0, optics_epoch(optics));
+        assert_int_equal(value.len, 1);
+        assert_topk_item(value, 0, "a", 3);
+
+        optics_lens_close(l0);
+        optics_lens_free(l1);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// invalid
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_topk_invalid_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    assert_null(optics_topk_alloc(optics, "blah", 0));
+    assert_null(optics_topk_alloc(optics, "blah", optics_topk_items_max + 1));
+
+    struct optics_lens *lens = optics_topk_alloc(optics, "blah", 10);
+
+    char item[optics_topk_item_max_len + 1] = {0};
+    memset(item, 'a', optics_topk_item_max_len - 1);
+    assert_true(optics_topk_inc(lens, item, 1));
+
+    item[optics_topk_item_max_len - 1] = 'a';
+    assert_false(optics_topk_inc(lens, item, 1));
+
+    struct optics_topk value = checked_topk_read(lens, optics_epoch(optics));
+    assert_int_equal(value.len, 1);
+    assert_int_equal(strlen(value.items[0].item), optics_topk_item_max_len - 1);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record/read
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_topk_record_read_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_topk_alloc(optics, "my_topk", 2);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_topk value = checked_topk_read(lens, epoch);
+    assert_int_equal(value.k, 2);
+    assert_int_equal(value.len, 0);
+
+    optics_topk_inc(lens, "a", 1);
+    optics_topk_inc(lens, "b", 10);
+    optics_topk_inc(lens, "c", 5);
+    optics_topk_inc(lens, "a", 1);
+
+    value = checked_topk_read(lens, epoch);
+    assert_int_equal(value.len, 3);
+    assert_topk_item(value, 0, "b", 10);
+    assert_topk_item(value, 1, "c", 5);
+    assert_topk_item(value, 2, "a", 2);
+
+    value = checked_topk_read(lens, epoch);
+    assert_int_equal(value.len, 0);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// heavy hitters
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_topk_heavy_hitters_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_topk_alloc(optics, "my_topk", 4);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    // A long tail of items that appear a handful of times interleaved with a
+    // few heavy hitters. The tail far exceeds the capacity of the lens so it
+    // keeps evicting itself.
+    enum { tail = 10 * 1000, heavy = 4 };
+    char item[optics_topk_item_max_len];
+    size_t total = 0;
+
+    for (size_t i = 0; i < tail; ++i) {
+        snprintf(item, sizeof(item), "tail_%lu", rng_gen_range(rng_global(), 0, tail));
+        optics_topk_inc(lens, item, 1);
+
+        snprintf(item, sizeof(item), "heavy_%lu", i % heavy);
+        optics_topk_inc(lens, item, 1);
+
+        total += 2;
+    }
+
+    struct optics_topk value = checked_topk_read(lens, epoch);
+    assert_int_equal(value.len, optics_topk_items_max);
+
+    // Counts are overestimated by at most total / capacity.
+    size_t exp = tail / heavy;
+    for (size_t i = 0; i < heavy; ++i) {
+        assert_non_null(strstr(value.items[i].item, "heavy_"));
+        assert_in_range(value.items[i].count, exp, exp + total / optics_topk_items_max);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// merge
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_topk_merge_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *l0 = optics_topk_alloc(optics, "l0", 2);
+    struct optics_lens *l1 = optics_topk_alloc(optics, "l1", 2);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_topk_inc(l0, "a", 10);
+    optics_topk_inc(l0, "b", 5);
+    optics_topk_inc(l1, "b", 10);
+    optics_topk_inc(l1, "c", 1);
+
+    struct optics_topk value = {0};
+    assert_int_equal(optics_topk_read(l0, epoch, &value), optics_ok);
+    assert_int_equal(optics_topk_read(l1, epoch, &value), optics_ok);
+
+    assert_int_equal(value.len, 3);
+    assert_topk_item(value, 0, "b", 15);
+    assert_topk_item(value, 1, "a", 10);
+    assert_topk_item(value, 2, "c", 1);
+
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_topk_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_topk_alloc(optics, "my_topk", 10);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_topk_t topk;
+    assert_true(optics_topk_typed(lens, &topk));
+
+    for (size_t i = 0; i < 10; ++i) assert_true(optics_topk_typed_inc(topk, "a", 1));
+
+    struct optics_topk value = checked_topk_read(lens, epoch);
+    assert_int_equal(value.len, 1);
+    assert_topk_item(value, 0, "a", 10);
+
+    optics_lens_close(lens);
+
+    lens = optics_counter_alloc(optics, "my_counter");
+    assert_false(optics_topk_typed(lens, &topk));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_topk_type_test)
+{
+    const char * lens_name = "blah";
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_topk value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        struct optics_lens *lens = optics_counter_alloc(optics, lens_name);
+
+        assert_false(optics_topk_inc(lens, "a", 1));
+        assert_int_equal(optics_topk_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_lens_get(optics, lens_name);
+
+        assert_false(optics_topk_inc(lens, "a", 1));
+        assert_int_equal(optics_topk_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch st
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_topk_epoch_st_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_topk_alloc(optics, "my_topk", 10);
+
+    for (size_t i = 1; i < 5; ++i) {
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+        optics_topk_inc(lens, "a", i);
+
+        struct optics_topk value = checked_topk_read(lens, epoch);
+        if (i == 1) assert_int_equal(value.len, 0);
+        else {
+            assert_int_equal(value.len, 1);
+            assert_topk_item(value, 0, "a", i - 1);
+        }
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch mt
+// -----------------------------------------------------------------------------
+
+struct epoch_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+void epoch_test_read_lens(struct epoch_test *test, struct optics_topk *value)
+{
+    optics_epoch_t epoch = optics_epoch_inc(test->optics);
+    while (optics_topk_read(test->lens, epoch, value) == optics_busy);
+}
+
+void run_epoch_test(size_t id, void *ctx)
+{
+    struct epoch_test *test = ctx;
+    enum { iterations = 100 * 1000 };
+
+    if (id) {
+        char item[optics_topk_item_max_len];
+        snprintf(item, sizeof(item), "item_%lu", id % 4);
+
+        for (size_t i = 0; i < iterations; ++i)
+            optics_topk_inc(test->lens, item, 1);
+
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+
+    else {
+        size_t done;
+        struct optics_topk value = {0};
+        size_t writers = test->workers - 1;
+
+        do {
+            epoch_test_read_lens(test, &value);
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        // Read whatever is leftover in the remaining epochs
+        for (size_t i = 0; i < 2; ++i)
+            epoch_test_read_lens(test, &value);
+
+        // There are fewer distinct items than the capacity so no count is lost.
+        size_t total = 0;
+        for (size_t i = 0; i < value.len; ++i) total += value.items[i].count;
+
+        optics_assert(total == writers * iterations,
+                "%lu != %lu", total, writers * iterations);
+    }
+}
+
+optics_test_head(lens_topk_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_topk_alloc(optics, "my_topk", 10);
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    rng_seed_with(rng_global(), 0);
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_topk_open_close_test),
+        cmocka_unit_test(lens_topk_alloc_get_test),
+        cmocka_unit_test(lens_topk_invalid_test),
+        cmocka_unit_test(lens_topk_record_read_test),
+        cmocka_unit_test(lens_topk_heavy_hitters_test),
+        cmocka_unit_test(lens_topk_merge_test),
+        cmocka_unit_test(lens_topk_typed_test),
+        cmocka_unit_test(lens_topk_type_test),
+        cmocka_unit_test(lens_topk_epoch_st_test),
+        cmocka_unit_test(lens_topk_epoch_mt_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,111 @@
+/* lens_tsc_bench.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "bench.h"
+
+
+struct tsc_bench
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+};
+
+
+// -----------------------------------------------------------------------------
+// record bench
+// -----------------------------------------------------------------------------
+
+// Measures the full cost of timing a section: two tsc reads and a record.
+void run_record_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct tsc_bench *bench = data;
+
+    optics_tsc_t tsc;
+    optics_tsc_typed(bench->lens, &tsc);
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t t0 = optics_rdtsc();
+        optics_tsc_typed_record(tsc, optics_rdtsc() - t0);
+    }
+}
+
+optics_test_head(lens_tsc_record_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_tsc_alloc(optics, "my_tsc", optics_usec);
+
+    struct tsc_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+optics_test_head(lens_tsc_record_bench_mt)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_tsc_alloc(optics, "my_tsc", optics_usec);
+
+    struct tsc_bench bench = { optics, lens };
+    optics_bench_mt(test_name, run_record_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// timer bench
+// -----------------------------------------------------------------------------
+
+// Same as the record bench but timed with the monotonic clock for comparison.
+void run_timer_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct tsc_bench *bench = data;
+
+    optics_hdr_t hdr;
+    optics_hdr_typed(bench->lens, &hdr);
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i) {
+        optics_timer_t t0;
+        optics_timer_start(&t0);
+        optics_hdr_typed_record(hdr, optics_timer_elapsed(&t0, optics_nsec));
+    }
+}
+
+optics_test_head(lens_tsc_timer_bench_st)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_hdr_alloc(optics, "my_hdr", 2, 1, 1000 * 1000);
+
+    struct tsc_bench bench = { optics, lens };
+    optics_bench_st(test_name, run_timer_bench, &bench);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_tsc_record_bench_st),
+        cmocka_unit_test(lens_tsc_record_bench_mt),
+        cmocka_unit_test(lens_tsc_timer_bench_st),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
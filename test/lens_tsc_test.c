@@ -0,0 +1,369 @@
+/* lens_tsc_test.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "test.h"
+#include "utils/time.h"
+
+
+// -----------------------------------------------------------------------------
+// utils
+// -----------------------------------------------------------------------------
+
+#define checked_tsc_read(lens, epoch)                                   \
+    ({                                                                  \
+        struct optics_tsc value = {0};                                  \
+        assert_int_equal(optics_tsc_read(lens, epoch, &value), optics_ok); \
+        value;                                                          \
+    })
+
+static size_t tsc_count(const struct optics_tsc *tsc)
+{
+    size_t count = tsc->cycles.above;
+    for (size_t i = 0; i < tsc->cycles.buckets_len; ++i) count += tsc->cycles.counts[i];
+    return count;
+}
+
+// Scale which makes the lens report cycles instead of time.
+static double cycles_scale(struct optics *optics)
+{
+    return optics_nsec / optics_tsc_nanos(optics);
+}
+
+
+// -----------------------------------------------------------------------------
+// open/close
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_tsc_open_close_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "my_tsc";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *lens = optics_tsc_alloc(optics, lens_name, optics_usec);
+        if (!lens) optics_abort();
+
+        assert_int_equal(optics_lens_type(lens), optics_tsc);
+        assert_string_equal(optics_lens_name(lens), lens_name);
+
+        assert_null(optics_tsc_alloc(optics, lens_name, optics_usec));
+        optics_lens_close(lens);
+        assert_null(optics_tsc_alloc(optics, lens_name, optics_usec));
+
+        assert_non_null(lens = optics_lens_get(optics, lens_name));
+        optics_lens_free(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// alloc_get
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_tsc_alloc_get_test)
+{
+    struct optics *optics = optics_create(test_name);
+    const char *lens_name = "blah";
+
+    for (size_t i = 0; i < 3; ++i) {
+        struct optics_lens *l0 = optics_tsc_alloc_get(optics, lens_name, optics_usec);
+        if (!l0) optics_abort();
+        optics_tsc_record(l0, 160);
+
+        struct optics_lens *l1 = optics_tsc_alloc_get(optics, lens_name, optics_usec);
+        if (!l1) optics_abort();
+        optics_tsc_record(l1, 320);
+
+        struct optics_tsc value = checked_tsc_read(l0, optics_epoch(optics));
+        assert_int_equal(tsc_count(&value), 2);
+        assert_int_equal(value.cycles.max, 320);
+
+        optics_lens_close(l0);
+        optics_lens_free(l1);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// invalid
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_tsc_invalid_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    assert_null(optics_tsc_alloc(optics, "blah", 0));
+    assert_null(optics_tsc_alloc(optics, "blah", -1));
+    assert_null(optics_tsc_alloc(optics, "blah", INFINITY));
+    assert_null(optics_tsc_alloc(optics, "blah", NAN));
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// calibration
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_tsc_calibration_test)
+{
+    struct optics *optics = optics_create(test_name);
+
+    // The calibration is done on first use and reused afterwards.
+    double nanos = optics_tsc_nanos(optics);
+    assert_true(nanos > 0);
+    assert_float_equal(optics_tsc_nanos(optics), nanos, 0);
+
+    struct optics_lens *lens = optics_tsc_alloc(optics, "my_tsc", optics_msec);
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    // nsleep is innacurate so we mostly care about getting the order of
+    // magnitude right.
+    uint64_t t0 = optics_rdtsc();
+    nsleep(10 * 1000 * 1000);
+    optics_tsc_record(lens, optics_rdtsc() - t0);
+
+    struct optics_tsc value = checked_tsc_read(lens, epoch);
+    assert_int_equal(tsc_count(&value), 1);
+    assert_float_equal(optics_tsc_max(&value), 10.0, 10.0);
+    assert_true(optics_tsc_percentile(&value, 50) >= 10.0 * 0.99);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// record/read
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_tsc_record_read_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_tsc_alloc(optics, "my_tsc", cycles_scale(optics));
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    struct optics_tsc value = checked_tsc_read(lens, epoch);
+    assert_float_equal(value.scale, 1.0, 1e-9);
+    assert_int_equal(value.cycles.precision, 2);
+    assert_int_equal(value.cycles.unit, 4);
+    assert_int_equal(tsc_count(&value), 0);
+    assert_float_equal(optics_tsc_percentile(&value, 50), 0, 0);
+
+    for (size_t i = 0; i < 100; ++i) optics_tsc_record(lens, i * 16);
+    value = checked_tsc_read(lens, epoch);
+    assert_int_equal(tsc_count(&value), 100);
+    assert_int_equal(value.cycles.max, 99 * 16);
+    assert_float_equal(optics_tsc_max(&value), 99 * 16, 1e-6);
+    assert_float_equal(optics_tsc_percentile(&value, 50), 50 * 16 + 15, 1e-6);
+    assert_float_equal(optics_tsc_percentile(&value, 90), 90 * 16 + 15, 1e-6);
+    assert_float_equal(optics_tsc_percentile(&value, 99), 99 * 16, 1e-6);
+
+    value = checked_tsc_read(lens, epoch);
+    assert_int_equal(tsc_count(&value), 0);
+    assert_int_equal(value.cycles.max, 0);
+
+    optics_tsc_record(lens, UINT64_MAX);
+    value = checked_tsc_read(lens, epoch);
+    assert_int_equal(tsc_count(&value), 1);
+    assert_int_equal(value.cycles.above, 1);
+    assert_int_equal(value.cycles.max, UINT64_MAX);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// typed
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_tsc_typed_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_tsc_alloc(optics, "my_tsc", cycles_scale(optics));
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    optics_tsc_t tsc;
+    assert_true(optics_tsc_typed(lens, &tsc));
+
+    for (size_t i = 0; i < 100; ++i) optics_tsc_typed_record(tsc, i * 16);
+
+    struct optics_tsc value = checked_tsc_read(lens, epoch);
+    assert_int_equal(tsc_count(&value), 100);
+    assert_int_equal(value.cycles.max, 99 * 16);
+    assert_float_equal(optics_tsc_percentile(&value, 50), 50 * 16 + 15, 1e-6);
+
+    optics_lens_close(lens);
+
+    lens = optics_hdr_alloc(optics, "my_hdr", 2, 1, 1000 * 1000);
+    assert_false(optics_tsc_typed(lens, &tsc));
+    optics_lens_close(lens);
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// type
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_tsc_type_test)
+{
+    const char * lens_name = "blah";
+    struct optics *optics = optics_create(test_name);
+
+    struct optics_tsc value;
+    optics_epoch_t epoch = optics_epoch(optics);
+
+    {
+        struct optics_lens *lens = optics_hdr_alloc(optics, lens_name, 2, 1, 1000 * 1000);
+
+        assert_false(optics_tsc_record(lens, 1));
+        assert_int_equal(optics_tsc_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    {
+        struct optics_lens *lens = optics_lens_get(optics, lens_name);
+
+        assert_false(optics_tsc_record(lens, 1));
+        assert_int_equal(optics_tsc_read(lens, epoch, &value), optics_err);
+
+        optics_lens_close(lens);
+    }
+
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch st
+// -----------------------------------------------------------------------------
+
+optics_test_head(lens_tsc_epoch_st_test)
+{
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_tsc_alloc(optics, "my_tsc", optics_usec);
+
+    for (size_t i = 1; i < 5; ++i) {
+        optics_epoch_t epoch = optics_epoch_inc(optics);
+        optics_tsc_record(lens, i);
+
+        struct optics_tsc value = checked_tsc_read(lens, epoch);
+        assert_int_equal(tsc_count(&value), i - 1 ? 1 : 0);
+        assert_int_equal(value.cycles.max, i - 1);
+    }
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// epoch mt
+// -----------------------------------------------------------------------------
+
+struct epoch_test
+{
+    struct optics *optics;
+    struct optics_lens *lens;
+    size_t workers;
+
+    atomic_size_t done;
+};
+
+size_t epoch_test_read_lens(struct epoch_test *test)
+{
+    optics_epoch_t epoch = optics_epoch_inc(test->optics);
+
+    struct optics_tsc value = checked_tsc_read(test->lens, epoch);
+    return tsc_count(&value);
+}
+
+void run_epoch_test(size_t id, void *ctx)
+{
+    struct epoch_test *test = ctx;
+    enum { iterations = 1000 * 1000 };
+
+    if (id) {
+        for (size_t i = 0; i < iterations; ++i)
+            optics_tsc_record(test->lens, i);
+
+        atomic_fetch_add_explicit(&test->done, 1, memory_order_release);
+    }
+
+    else {
+        size_t done;
+        uint64_t result = 0;
+        size_t writers = test->workers - 1;
+
+        do {
+            result += epoch_test_read_lens(test);
+            done = atomic_load_explicit(&test->done, memory_order_acquire);
+        } while (done < writers);
+
+        // Read whatever is leftover in the remaining epochs
+        for (size_t i = 0; i < 2; ++i)
+            result += epoch_test_read_lens(test);
+
+        // cmocka just plain sucks when it comes to mt.
+        optics_assert(result == writers * iterations, "%lu != %lu",
+                result, writers * iterations);
+    }
+}
+
+optics_test_head(lens_tsc_epoch_mt_test)
+{
+    assert_mt();
+    struct optics *optics = optics_create(test_name);
+    struct optics_lens *lens = optics_tsc_alloc(optics, "my_tsc", optics_usec);
+
+    struct epoch_test data = {
+        .optics = optics,
+        .lens = lens,
+        .workers = cpus(),
+    };
+    run_threads(run_epoch_test, &data, data.workers);
+
+    optics_lens_close(lens);
+    optics_close(optics);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(lens_tsc_open_close_test),
+        cmocka_unit_test(lens_tsc_alloc_get_test),
+        cmocka_unit_test(lens_tsc_invalid_test),
+        cmocka_unit_test(lens_tsc_calibration_test),
+        cmocka_unit_test(lens_tsc_record_read_test),
+        cmocka_unit_test(lens_tsc_typed_test),
+        cmocka_unit_test(lens_tsc_type_test),
+        cmocka_unit_test(lens_tsc_epoch_st_test),
+        cmocka_unit_test(lens_tsc_epoch_mt_test),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,113 @@
+/* poller_bench.c
+   agent (agent@local), 17 Oct 2026
+   FreeBSD-style copyright and disclaimer apply
+*/
+
+#include "bench.h"
+#include "utils/rng.h"
+
+
+// -----------------------------------------------------------------------------
+// backend
+// -----------------------------------------------------------------------------
+
+static bool backend_normalized_cb(void *ctx, uint64_t ts, const char *key, double value)
+{
+    (void) ctx, (void) ts, (void) key;
+    optics_no_opt_val(value);
+    return true;
+}
+
+
+// -----------------------------------------------------------------------------
+// dist bench
+// -----------------------------------------------------------------------------
+
+struct dist_bench
+{
+    const char *name;
+    size_t regions;
+};
+
+// Reports the time taken by the poller to read, merge and normalize a single
+// dist lens with a full reservoir in each of the regions. We skip the actual
+// poll loop as it sleeps to give stragglers a chance to finish which would
+// drown out the cost of the lenses.
+void run_dist_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) id;
+    struct dist_bench *bench = data;
+
+    struct optics *optics[bench->regions];
+    for (size_t i = 0; i < bench->regions; ++i)
+        optics[i] = optics_create_idx_at(bench->name, i, 0);
+
+    struct optics_lens **lenses = calloc(n * bench->regions, sizeof(*lenses));
+    for (size_t i = 0; i < n; ++i) {
+        struct optics_key key = {0};
+        optics_key_pushf(&key, "dist_%lu", i);
+
+        for (size_t j = 0; j < bench->regions; ++j) {
+            struct optics_lens *lens = optics_dist_alloc(optics[j], key.data);
+            for (size_t k = 0; k < optics_dist_samples; ++k)
+                optics_dist_record(lens, rng_gen_range(rng_global(), 0, 1000));
+            lenses[i * bench->regions + j] = lens;
+        }
+    }
+
+    optics_epoch_t epoch = 0;
+    for (size_t i = 0; i < bench->regions; ++i) epoch = optics_epoch_inc(optics[i]);
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i) {
+        struct optics_poll poll = {
+            .type = optics_dist,
+            .key = optics_lens_name(lenses[i * bench->regions]),
+            .elapsed = 1,
+        };
+
+        for (size_t j = 0; j < bench->regions; ++j)
+            optics_dist_read(lenses[i * bench->regions + j], epoch, &poll.value.dist);
+
+        optics_poll_normalize(&poll, backend_normalized_cb, NULL);
+    }
+
+    optics_bench_stop(b);
+
+    for (size_t i = 0; i < n * bench->regions; ++i) optics_lens_close(lenses[i]);
+    free(lenses);
+
+    for (size_t i = 0; i < bench->regions; ++i) optics_close(optics[i]);
+}
+
+optics_test_head(poller_dist_bench_st)
+{
+    struct dist_bench bench = { .name = test_name, .regions = 1 };
+    optics_bench_st(test_name, run_dist_bench, &bench);
+}
+optics_test_tail()
+
+optics_test_head(poller_dist_merge_bench_st)
+{
+    struct dist_bench bench = { .name = test_name, .regions = 4 };
+    optics_bench_st(test_name, run_dist_bench, &bench);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// setup
+// -----------------------------------------------------------------------------
+
+int main(void)
+{
+    rng_seed_with(rng_global(), 0);
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(poller_dist_bench_st),
+        cmocka_unit_test(poller_dist_merge_bench_st),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -97,6 +97,49 @@ optics_test_head(poller_gauge_test)
 }
 optics_test_tail()
 
+optics_test_head(poller_gauge_add_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+    }
+
+    struct optics_lens *l0 = optics_gauge_alloc_additive(optics[0], "gauge");
+    struct optics_lens *l1 = optics_gauge_alloc_additive(optics[1], "gauge");
+
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 0, make_kv("prefix.host.gauge", 0.0));
+
+    optics_gauge_add(l0, 2);
+    optics_gauge_add(l1, 3);
+
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 0, make_kv("prefix.host.gauge", 5.0));
+
+    // Values persist across polls.
+    optics_gauge_add(l1, -1);
+
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 0, make_kv("prefix.host.gauge", 4.0));
+
+    htable_reset(&result);
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    for (size_t i = 0; i < 2; ++i) optics_close(optics[i]);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
 
 // -----------------------------------------------------------------------------
 // counter
@@ -428,6 +471,680 @@ optics_test_head(poller_quantile_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// hdr
+// -----------------------------------------------------------------------------
+
+optics_test_head(poller_hdr_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+    }
+
+    struct optics_lens *l0 = optics_hdr_alloc(optics[0], "hdr", 2, 1, 1000 * 1000);
+    struct optics_lens *l1 = optics_hdr_alloc(optics[1], "hdr", 2, 1, 1000 * 1000);
+
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.hdr.count", 0.0),
+            make_kv("prefix.host.hdr.p50", 0.0),
+            make_kv("prefix.host.hdr.p90", 0.0),
+            make_kv("prefix.host.hdr.p99", 0.0),
+            make_kv("prefix.host.hdr.p999", 0.0),
+            make_kv("prefix.host.hdr.max", 0.0),
+            make_kv("prefix.host.hdr.above", 0.0));
+
+    for (size_t i = 0; i < 100; ++i) {
+        optics_hdr_record(l0, i);
+        optics_hdr_record(l1, 100 + i);
+    }
+
+    ts += 2;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.hdr.count", 100.0),
+            make_kv("prefix.host.hdr.p50", 100.0),
+            make_kv("prefix.host.hdr.p90", 180.0),
+            make_kv("prefix.host.hdr.p99", 198.0),
+            make_kv("prefix.host.hdr.p999", 199.0),
+            make_kv("prefix.host.hdr.max", 199.0),
+            make_kv("prefix.host.hdr.above", 0.0));
+
+    htable_reset(&result);
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    for (size_t i = 0; i < 2; ++i) optics_close(optics[i]);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// sketch
+// -----------------------------------------------------------------------------
+
+optics_test_head(poller_sketch_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+    }
+
+    struct optics_lens *l0 = optics_sketch_alloc(optics[0], "sketch", 0.01, 1);
+    struct optics_lens *l1 = optics_sketch_alloc(optics[1], "sketch", 0.01, 1);
+
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.sketch.count", 0.0),
+            make_kv("prefix.host.sketch.p50", 0.0),
+            make_kv("prefix.host.sketch.p90", 0.0),
+            make_kv("prefix.host.sketch.p99", 0.0),
+            make_kv("prefix.host.sketch.p999", 0.0));
+
+    for (size_t i = 1; i <= 500; ++i) {
+        optics_sketch_record(l0, i);
+        optics_sketch_record(l1, 500 + i);
+    }
+
+    ts += 2;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 10,
+            make_kv("prefix.host.sketch.count", 500.0),
+            make_kv("prefix.host.sketch.p50", 501.0),
+            make_kv("prefix.host.sketch.p90", 901.0),
+            make_kv("prefix.host.sketch.p99", 991.0),
+            make_kv("prefix.host.sketch.p999", 1000.0));
+
+    htable_reset(&result);
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    for (size_t i = 0; i < 2; ++i) optics_close(optics[i]);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// hll
+// -----------------------------------------------------------------------------
+
+optics_test_head(poller_hll_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+    }
+
+    struct optics_lens *l0 = optics_hll_alloc(optics[0], "hll", 12);
+    struct optics_lens *l1 = optics_hll_alloc(optics[1], "hll", 12);
+
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 0, make_kv("prefix.host.hll", 0.0));
+
+    // Overlapping values are only counted once.
+    for (size_t i = 0; i < 10; ++i) {
+        optics_hll_record(l0, i);
+        optics_hll_record(l1, 5 + i);
+    }
+
+    ts += 2;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 0.1, make_kv("prefix.host.hll", 15.0));
+
+    htable_reset(&result);
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    for (size_t i = 0; i < 2; ++i) optics_close(optics[i]);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// topk
+// -----------------------------------------------------------------------------
+
+optics_test_head(poller_topk_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+    }
+
+    struct optics_lens *l0 = optics_topk_alloc(optics[0], "topk", 2);
+    struct optics_lens *l1 = optics_topk_alloc(optics[1], "topk", 2);
+
+    optics_poller_poll_at(poller, ++ts);
+    assert_int_equal(result.len, 0);
+
+    // Only the top 2 items of the merged lenses are emitted.
+    optics_topk_inc(l0, "a", 10);
+    optics_topk_inc(l0, "b", 6);
+    optics_topk_inc(l1, "b", 6);
+    optics_topk_inc(l1, "c", 2);
+
+    ts += 2;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.topk.b", 6.0),
+            make_kv("prefix.host.topk.a", 5.0));
+
+    // Items are sanitized before being used as a key component.
+    optics_topk_inc(l0, "d.e f", 4);
+
+    ts += 2;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.topk.d_e_f", 2.0));
+
+    htable_reset(&result);
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    for (size_t i = 0; i < 2; ++i) optics_close(optics[i]);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// summary
+// -----------------------------------------------------------------------------
+
+optics_test_head(poller_summary_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+    }
+
+    struct optics_lens *l0 = optics_summary_alloc(optics[0], "summary");
+    struct optics_lens *l1 = optics_summary_alloc(optics[1], "summary");
+
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.summary.count", 0.0),
+            make_kv("prefix.host.summary.mean", 0.0),
+            make_kv("prefix.host.summary.stddev", 0.0),
+            make_kv("prefix.host.summary.min", 0.0),
+            make_kv("prefix.host.summary.max", 0.0));
+
+    const double values[] = { 2, 4, 4, 4, 5, 5, 7, 9 };
+    for (size_t i = 0; i < 4; ++i) {
+        optics_summary_record(l0, values[i]);
+        optics_summary_record(l1, values[4 + i]);
+    }
+
+    ts += 2;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 1e-9,
+            make_kv("prefix.host.summary.count", 4.0),
+            make_kv("prefix.host.summary.mean", 5.0),
+            make_kv("prefix.host.summary.stddev", 2.0),
+            make_kv("prefix.host.summary.min", 2.0),
+            make_kv("prefix.host.summary.max", 9.0));
+
+    htable_reset(&result);
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    for (size_t i = 0; i < 2; ++i) optics_close(optics[i]);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// counter vec
+// -----------------------------------------------------------------------------
+
+optics_test_head(poller_counter_vec_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+    }
+
+    const char *labels[] = { "2xx", "5xx" };
+    struct optics_lens *l0 = optics_counter_vec_alloc(optics[0], "status", labels, 2);
+    struct optics_lens *l1 = optics_counter_vec_alloc(optics[1], "status", labels, 2);
+
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.status.2xx", 0.0),
+            make_kv("prefix.host.status.5xx", 0.0));
+
+    optics_counter_vec_inc(l0, 0, 10);
+    optics_counter_vec_inc(l1, 0, 6);
+    optics_counter_vec_inc(l1, 1, 4);
+
+    ts += 2;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.status.2xx", 8.0),
+            make_kv("prefix.host.status.5xx", 2.0));
+
+    htable_reset(&result);
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    for (size_t i = 0; i < 2; ++i) optics_close(optics[i]);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// heatmap
+// -----------------------------------------------------------------------------
+
+optics_test_head(poller_heatmap_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+    }
+
+    const uint64_t x[] = { 10, 20 };
+    const uint64_t y[] = { 1, 2 };
+    struct optics_lens *l0 = optics_heatmap_alloc(optics[0], "heatmap", x, 2, y, 2);
+    struct optics_lens *l1 = optics_heatmap_alloc(optics[1], "heatmap", x, 2, y, 2);
+
+    optics_heatmap_inc(l0, 15, 1);
+    optics_heatmap_inc(l1, 15, 1);
+    optics_heatmap_inc(l1, 25, 0);
+    optics_heatmap_inc(l1, 25, 0);
+
+    ts += 2;
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.heatmap.below.below", 0.0),
+            make_kv("prefix.host.heatmap.below.bucket_1_2", 0.0),
+            make_kv("prefix.host.heatmap.below.above", 0.0),
+            make_kv("prefix.host.heatmap.bucket_10_20.below", 0.0),
+            make_kv("prefix.host.heatmap.bucket_10_20.bucket_1_2", 1.0),
+            make_kv("prefix.host.heatmap.bucket_10_20.above", 0.0),
+            make_kv("prefix.host.heatmap.above.below", 1.0),
+            make_kv("prefix.host.heatmap.above.bucket_1_2", 0.0),
+            make_kv("prefix.host.heatmap.above.above", 0.0));
+
+    htable_reset(&result);
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    for (size_t i = 0; i < 2; ++i) optics_close(optics[i]);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// event
+// -----------------------------------------------------------------------------
+
+optics_test_head(poller_event_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+    }
+
+    struct optics_lens *l0 = optics_event_alloc(optics[0], "event", 2);
+    struct optics_lens *l1 = optics_event_alloc(optics[1], "event", 2);
+
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.event.count", 0.0),
+            make_kv("prefix.host.event.dropped", 0.0));
+
+    optics_event_record(l0, 10, 1.5);
+    optics_event_record(l1, 20, 2.5);
+    optics_event_record(l1, 21, 3.5);
+    optics_event_record(l1, 22, 4.5);
+
+    ts += 2;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.event.count", 1.5),
+            make_kv("prefix.host.event.dropped", 0.5),
+            make_kv("prefix.host.event.10", 1.5),
+            make_kv("prefix.host.event.20", 2.5),
+            make_kv("prefix.host.event.21", 3.5));
+
+    htable_reset(&result);
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    for (size_t i = 0; i < 2; ++i) optics_close(optics[i]);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// tsc
+// -----------------------------------------------------------------------------
+
+optics_test_head(poller_tsc_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    struct optics_lens *lens[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+
+        // Report cycles so that the values don't depend on the calibration.
+        double scale = optics_nsec / optics_tsc_nanos(optics[i]);
+        lens[i] = optics_tsc_alloc(optics[i], "tsc", scale);
+    }
+
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 1e-6,
+            make_kv("prefix.host.tsc.count", 0.0),
+            make_kv("prefix.host.tsc.p50", 0.0),
+            make_kv("prefix.host.tsc.p90", 0.0),
+            make_kv("prefix.host.tsc.p99", 0.0),
+            make_kv("prefix.host.tsc.p999", 0.0),
+            make_kv("prefix.host.tsc.max", 0.0));
+
+    for (size_t i = 0; i < 100; ++i) {
+        optics_tsc_record(lens[0], i * 16);
+        optics_tsc_record(lens[1], (100 + i) * 16);
+    }
+
+    ts += 2;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 1e-6,
+            make_kv("prefix.host.tsc.count", 100.0),
+            make_kv("prefix.host.tsc.p50", 1615.0),
+            make_kv("prefix.host.tsc.p90", 2895.0),
+            make_kv("prefix.host.tsc.p99", 3183.0),
+            make_kv("prefix.host.tsc.p999", 3184.0),
+            make_kv("prefix.host.tsc.max", 3184.0));
+
+    htable_reset(&result);
+    for (size_t i = 0; i < 2; ++i) {
+        optics_lens_close(lens[i]);
+        optics_close(optics[i]);
+    }
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// meter
+// -----------------------------------------------------------------------------
+
+static double ewma(double old, double rate, double window)
+{
+    return old + (1 - exp(-1 / window)) * (rate - old);
+}
+
+optics_test_head(poller_meter_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+    }
+
+    struct optics_lens *l0 = optics_meter_alloc(optics[0], "meter");
+    struct optics_lens *l1 = optics_meter_alloc(optics[1], "meter");
+
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.meter.count", 0.0),
+            make_kv("prefix.host.meter.rate_1", 0.0),
+            make_kv("prefix.host.meter.rate_5", 0.0),
+            make_kv("prefix.host.meter.rate_15", 0.0));
+
+    // Rates are computed from the merged count rather than summed.
+    optics_meter_mark(l0, 10);
+    optics_meter_mark(l1, 20);
+
+    ts += 2;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 1e-9,
+            make_kv("prefix.host.meter.count", 15.0),
+            make_kv("prefix.host.meter.rate_1", ewma(0, 15, 1)),
+            make_kv("prefix.host.meter.rate_5", ewma(0, 15, 5)),
+            make_kv("prefix.host.meter.rate_15", ewma(0, 15, 15)));
+
+    // Idle polls decay the averages.
+    ts += 1;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 1e-9,
+            make_kv("prefix.host.meter.count", 0.0),
+            make_kv("prefix.host.meter.rate_1", ewma(ewma(0, 15, 1), 0, 1)),
+            make_kv("prefix.host.meter.rate_5", ewma(ewma(0, 15, 5), 0, 5)),
+            make_kv("prefix.host.meter.rate_15", ewma(ewma(0, 15, 15), 0, 15)));
+
+    htable_reset(&result);
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    for (size_t i = 0; i < 2; ++i) optics_close(optics[i]);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// quantile vec
+// -----------------------------------------------------------------------------
+
+optics_test_head(poller_quantile_vec_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics = optics_create_at(test_name, ts);
+    optics_set_prefix(optics, "prefix");
+
+    const double quantiles[] = { 0.5, 0.9, 0.999 };
+    struct optics_lens *lens = optics_quantile_vec_alloc(optics, "quantile", quantiles, 3, 50, 0.05);
+
+    optics_poller_poll_at(poller, ++ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.quantile.count", 0.0),
+            make_kv("prefix.host.quantile.p50", 50.0),
+            make_kv("prefix.host.quantile.p90", 50.0),
+            make_kv("prefix.host.quantile.p999", 50.0));
+
+    for (size_t i = 0; i < 1000; ++i) {
+        for (size_t j = 0; j < 100; ++j)
+            optics_quantile_vec_update(lens, j);
+    }
+
+    ts += 10;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 2,
+            make_kv("prefix.host.quantile.count", 10000.0),
+            make_kv("prefix.host.quantile.p50", 50.0),
+            make_kv("prefix.host.quantile.p90", 90.0),
+            make_kv("prefix.host.quantile.p999", 99.9));
+
+    htable_reset(&result);
+    optics_lens_close(lens);
+    optics_close(optics);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
+// -----------------------------------------------------------------------------
+// sampling
+// -----------------------------------------------------------------------------
+
+optics_test_head(poller_sampling_test)
+{
+    struct htable result = {0};
+    struct optics_poller *poller = optics_poller_alloc();
+    optics_poller_set_host(poller, "host");
+    optics_poller_backend(poller, &result, backend_cb, NULL);
+
+    optics_ts_t ts = 0;
+
+    struct optics *optics[2];
+    for (size_t i = 0; i < 2; ++i) {
+        optics[i] = optics_create_idx_at(test_name, i, ts);
+        optics_set_prefix(optics[i], "prefix");
+    }
+
+    struct optics_lens *l0 = optics_counter_alloc(optics[0], "counter");
+    struct optics_lens *l1 = optics_counter_alloc(optics[1], "counter");
+    assert_true(optics_lens_set_sampling(l0, 10));
+    assert_true(optics_lens_set_sampling(l1, 10));
+
+    const uint64_t buckets[] = {10, 20};
+    struct optics_lens *histo = optics_histo_alloc(optics[0], "histo", buckets, 2);
+    assert_true(optics_lens_set_sampling(histo, 10));
+
+    optics_poller_poll_at(poller, ++ts);
+
+    // Counts are scaled back up before being turned into rates.
+    for (size_t i = 0; i < 100 * 1000; ++i) {
+        optics_counter_inc(l0, 1);
+        optics_counter_inc(l1, 1);
+        optics_histo_inc(histo, 15);
+    }
+
+    ts += 10;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 1000,
+            make_kv("prefix.host.counter", 20 * 1000),
+            make_kv("prefix.host.histo.below", 0),
+            make_kv("prefix.host.histo.above", 0),
+            make_kv("prefix.host.histo.bucket_10_20", 10 * 1000));
+
+    // Each lens is scaled back up by its own rate so lenses of the same key
+    // sampled at different rates can still be merged.
+    assert_true(optics_lens_set_sampling(l1, 1));
+    for (size_t i = 0; i < 100 * 1000; ++i) {
+        optics_counter_inc(l0, 1);
+        optics_counter_inc(l1, 1);
+    }
+
+    ts += 10;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 500,
+            make_kv("prefix.host.counter", 20 * 1000),
+            make_kv("prefix.host.histo.below", 0),
+            make_kv("prefix.host.histo.above", 0),
+            make_kv("prefix.host.histo.bucket_10_20", 0));
+
+    // Both lenses were read and reset by the previous poll.
+    ts += 10;
+    htable_reset(&result);
+    optics_poller_poll_at(poller, ts);
+    assert_htable_equal(&result, 0,
+            make_kv("prefix.host.counter", 0),
+            make_kv("prefix.host.histo.below", 0),
+            make_kv("prefix.host.histo.above", 0),
+            make_kv("prefix.host.histo.bucket_10_20", 0));
+
+    htable_reset(&result);
+    optics_lens_close(l0);
+    optics_lens_close(l1);
+    optics_lens_close(histo);
+    for (size_t i = 0; i < 2; ++i) optics_close(optics[i]);
+    optics_poller_free(poller);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // setup
 // -----------------------------------------------------------------------------
@@ -438,10 +1155,23 @@ int main(void)
 
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(poller_gauge_test),
+        cmocka_unit_test(poller_gauge_add_test),
         cmocka_unit_test(poller_counter_test),
         cmocka_unit_test(poller_dist_test),
         cmocka_unit_test(poller_histo_test),
         cmocka_unit_test(poller_quantile_test),
+        cmocka_unit_test(poller_hdr_test),
+        cmocka_unit_test(poller_sketch_test),
+        cmocka_unit_test(poller_hll_test),
+        cmocka_unit_test(poller_topk_test),
+        cmocka_unit_test(poller_summary_test),
+        cmocka_unit_test(poller_counter_vec_test),
+        cmocka_unit_test(poller_heatmap_test),
+        cmocka_unit_test(poller_event_test),
+        cmocka_unit_test(poller_tsc_test),
+        cmocka_unit_test(poller_meter_test),
+        cmocka_unit_test(poller_quantile_vec_test),
+        cmocka_unit_test(poller_sampling_test),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
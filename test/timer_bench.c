@@ -186,6 +186,31 @@ optics_test_head(optics_timer_bench)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// optics rdtsc
+// -----------------------------------------------------------------------------
+
+void run_optics_rdtsc_bench(struct optics_bench *b, void *data, size_t id, size_t n)
+{
+    (void) data, (void) id, (void) n;
+
+    optics_bench_start(b);
+
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t t0 = optics_rdtsc();
+
+        uint64_t diff = optics_rdtsc() - t0;
+        optics_no_opt_val(diff);
+    }
+}
+
+optics_test_head(optics_rdtsc_bench)
+{
+    optics_bench_st(test_name, run_optics_rdtsc_bench, NULL);
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // main
 // -----------------------------------------------------------------------------
@@ -198,6 +223,7 @@ int main(void)
         cmocka_unit_test(delta_timespec_ret_bench),
         cmocka_unit_test(delta_double_bench),
         cmocka_unit_test(optics_timer_bench),
+        cmocka_unit_test(optics_rdtsc_bench),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
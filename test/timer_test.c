@@ -35,6 +35,34 @@ optics_test_head(basics_test)
 optics_test_tail()
 
 
+// -----------------------------------------------------------------------------
+// borrow
+// -----------------------------------------------------------------------------
+
+// Moves the start time back by a fraction of a second which requires a borrow
+// from the seconds whenever the nanos of the start end up above the current
+// nanos.
+optics_test_head(borrow_test)
+{
+    const long nano_sec = 1L * 1000 * 1000 * 1000;
+
+    for (size_t i = 1; i < 10; ++i) {
+        long offset = i * (nano_sec / 10);
+
+        optics_timer_t t0;
+        optics_timer_start(&t0);
+
+        t0.tv_sec -= 1;
+        t0.tv_nsec += nano_sec - offset;
+        if (t0.tv_nsec >= nano_sec) { t0.tv_sec++; t0.tv_nsec -= nano_sec; }
+
+        double diff = optics_timer_elapsed(&t0, optics_nsec);
+        assert_float_equal(diff, offset, 1e7);
+    }
+}
+optics_test_tail()
+
+
 // -----------------------------------------------------------------------------
 // main
 // -----------------------------------------------------------------------------
@@ -43,6 +71,7 @@ int main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(basics_test),
+        cmocka_unit_test(borrow_test),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);